@@ -0,0 +1,191 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file benchmark.cpp Benchmarking of the game loop without a user interface. */
+
+#include "stdafx.h"
+#include "benchmark.h"
+#include "openttd.h"
+#include "cargopacket.h"
+#include "company_base.h"
+#include "framerate_type.h"
+#include "map_func.h"
+#include "fileio_type.h"
+#include "vehicle_base.h"
+#include "worker_pool.h"
+#include "core/random_func.hpp"
+#include "saveload/saveload.h"
+#include "timer/timer_game_tick.h"
+
+#include <chrono>
+
+#include "safeguards.h"
+
+/** Simple FNV-1a hash to combine the parts of the game state. */
+class StateHasher {
+	uint64_t hash = 0xCBF29CE484222325ULL; ///< The hash so far.
+
+public:
+	/**
+	 * Add a value to the hash.
+	 * @param value The value to add.
+	 */
+	void Add(uint64_t value)
+	{
+		for (uint i = 0; i < 8; i++) {
+			this->hash ^= GB(value, i * 8, 8);
+			this->hash *= 0x100000001B3ULL;
+		}
+	}
+
+	/**
+	 * Get the hash of all values added so far.
+	 * @return The hash.
+	 */
+	uint64_t Get() const { return this->hash; }
+};
+
+/**
+ * Get a hash of the game state that two runs of the game loop are expected to agree on.
+ * It covers the random state, the map, the vehicles, the age of all cargo and the money of
+ * the companies, which is where differences between runs end up sooner or later.
+ * @return The hash of the game state.
+ */
+uint64_t GetGameStateHash()
+{
+	StateHasher hasher;
+	hasher.Add(_random.state[0]);
+	hasher.Add(_random.state[1]);
+
+	for (auto t : Map::Iterate()) {
+		hasher.Add(t.type() | t.height() << 8 | t.m1() << 16 | (uint64_t)t.m2() << 24 | (uint64_t)t.m3() << 40 | (uint64_t)t.m4() << 48 | (uint64_t)t.m5() << 56);
+		hasher.Add(t.m6() | t.m7() << 8 | t.m8() << 16);
+	}
+
+	for (const Vehicle *v : Vehicle::Iterate()) {
+		hasher.Add(v->index);
+		hasher.Add((uint64_t)(uint32_t)v->x_pos | (uint64_t)(uint32_t)v->y_pos << 32);
+		hasher.Add((uint64_t)v->z_pos | (uint64_t)v->cur_speed << 32);
+		hasher.Add(v->cargo.TotalCount() | (uint64_t)v->cargo_age_counter << 32);
+	}
+
+	/* Cargo aging does not affect anything else until the cargo is delivered, so check it on its own. */
+	for (const CargoPacket *cp : CargoPacket::Iterate()) {
+		hasher.Add(cp->index);
+		hasher.Add(cp->Count() | (uint64_t)cp->GetPeriodsInTransit() << 32);
+	}
+
+	for (const Company *c : Company::Iterate()) {
+		hasher.Add(c->index);
+		hasher.Add((int64_t)c->money);
+	}
+
+	return hasher.Get();
+}
+
+/**
+ * Run the game loop for a number of ticks as fast as possible and print
+ * how long that took, and the hash of the game state afterwards.
+ * @param ticks Number of ticks to run.
+ * @return False if there is no game to run.
+ */
+bool RunGameLoopBenchmark(uint ticks)
+{
+	if (_game_mode != GM_NORMAL) {
+		fmt::print(stderr, "No game was loaded, nothing to benchmark.\n");
+		return false;
+	}
+
+	/* A savegame may have been saved while paused, or be paused on load. */
+	_pause_mode = PM_UNPAUSED;
+
+	uint64_t start_tick = TimerGameTick::counter;
+	uint64_t start_hash = GetGameStateHash();
+	ResetPerformanceTotals();
+
+	auto start = std::chrono::steady_clock::now();
+	for (uint i = 0; i < ticks; i++) StateGameLoop();
+	std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+
+	static const std::pair<PerformanceElement, const char *> elements[] = {
+		{ PFE_GAMELOOP,     "Game loop" },
+		{ PFE_GL_ECONOMY,   "  station ticks" },
+		{ PFE_GL_TRAINS,    "  train ticks" },
+		{ PFE_GL_ROADVEHS,  "  road vehicle ticks" },
+		{ PFE_GL_SHIPS,     "  ship ticks" },
+		{ PFE_GL_AIRCRAFT,  "  aircraft ticks" },
+		{ PFE_GL_LANDSCAPE, "  landscape ticks" },
+		{ PFE_GL_LINKGRAPH, "  link graph delays" },
+		{ PFE_ALLSCRIPTS,   "  AI/GS scripts" },
+	};
+
+	fmt::print("Ran {} ticks, from tick {}, with {} worker thread(s).\n", ticks, start_tick, GetWorkerThreadCount());
+	fmt::print("Wall time: {:.3f} s, {:.1f} ticks/s\n", duration.count(), ticks / std::max(duration.count(), 1e-9));
+	for (const auto &[elem, name] : elements) {
+		double total = GetPerformanceTotalMilliseconds(elem);
+		fmt::print("{:<22} {:>12.3f} ms total, {:>9.4f} ms/tick\n", name, total, ticks > 0 ? total / ticks : 0.0);
+	}
+	fmt::print("Initial state hash: {:016X}\n", start_hash);
+	fmt::print("Final state hash:   {:016X}\n", GetGameStateHash());
+	return true;
+}
+
+/**
+ * Run the game loop for a number of ticks twice from the same state, first without and
+ * then with worker threads, and compare the random state and the hash of the game state
+ * afterwards. Any difference means that the work done by the worker threads changes the
+ * outcome of the game, which would make clients of a multiplayer game desync.
+ * @param ticks Number of ticks to run.
+ * @return False if there is no game to run, or when the runs do not end in the same state.
+ */
+bool RunDesyncCheck(uint ticks)
+{
+	if (_game_mode != GM_NORMAL) {
+		fmt::print(stderr, "No game was loaded, nothing to check.\n");
+		return false;
+	}
+
+	static const std::string filename = "desync_check.sav";
+	if (SaveOrLoad(filename, SLO_SAVE, DFT_GAME_FILE, SAVE_DIR, false) != SL_OK) {
+		fmt::print(stderr, "Saving the game to start both runs from failed.\n");
+		return false;
+	}
+
+	/* Compare with the configured number of worker threads, or with all hardware threads when they are disabled. */
+	uint8_t threads = _worker_threads;
+	uint8_t parallel_threads = (threads == 1) ? 0 : threads;
+
+	uint32_t random_state[2][2];
+	uint64_t hash[2];
+	for (uint run = 0; run < 2; run++) {
+		/* Both runs start from the savegame, so state that is not saved cannot differ between them. */
+		if (SaveOrLoad(filename, SLO_LOAD, DFT_GAME_FILE, SAVE_DIR) != SL_OK) {
+			fmt::print(stderr, "Loading the game to start run {} from failed.\n", run + 1);
+			_worker_threads = threads;
+			return false;
+		}
+		_pause_mode = PM_UNPAUSED;
+		_worker_threads = (run == 0) ? 1 : parallel_threads;
+
+		for (uint i = 0; i < ticks; i++) StateGameLoop();
+
+		random_state[run][0] = _random.state[0];
+		random_state[run][1] = _random.state[1];
+		hash[run] = GetGameStateHash();
+		fmt::print("Run {} with {} worker thread(s): random state {:08X} {:08X}, state hash {:016X}\n",
+				run + 1, GetWorkerThreadCount(), random_state[run][0], random_state[run][1], hash[run]);
+	}
+	_worker_threads = threads;
+
+	if (random_state[0][0] != random_state[1][0] || random_state[0][1] != random_state[1][1] || hash[0] != hash[1]) {
+		fmt::print("Desync after {} ticks: the worker threads changed the outcome of the game.\n", ticks);
+		return false;
+	}
+
+	fmt::print("No desync after {} ticks.\n", ticks);
+	return true;
+}
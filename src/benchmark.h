@@ -0,0 +1,17 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file benchmark.h Functions for benchmarking the game loop without a user interface. */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+uint64_t GetGameStateHash();
+bool RunGameLoopBenchmark(uint ticks);
+bool RunDesyncCheck(uint ticks);
+
+#endif /* BENCHMARK_H */
@@ -0,0 +1,53 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file benchmark_main.cpp Main entry for running the game loop of a savegame headless, as a benchmark. */
+
+#include "stdafx.h"
+#include "openttd.h"
+#include "crashlog.h"
+#include "core/format.hpp"
+#include "core/random_func.hpp"
+#include "string_func.h"
+
+#include "safeguards.h"
+
+int CDECL main(int argc, char *argv[])
+{
+	if (argc < 2) {
+		fmt::print(stderr,
+			"Usage: {} <savegame> [<ticks> [<worker-threads>]] [<openttd-options>...]\n"
+			"Runs the game loop of the savegame for a number of ticks (default 1000) without\n"
+			"any user interface, and prints the time spent and a hash of the final game state.\n"
+			"Runs with a different number of worker threads are expected to give the same hash.\n",
+			argv[0]);
+		return 1;
+	}
+
+	/* Make sure our arguments contain only valid UTF-8 characters. */
+	for (int i = 0; i < argc; i++) StrMakeValidInPlace(argv[i]);
+
+	int arg = 1;
+	std::string savegame = argv[arg++];
+	std::string video = "null:benchmark";
+	if (arg < argc && argv[arg][0] != '-') video += fmt::format(",ticks={}", atoi(argv[arg++]));
+	if (arg < argc && argv[arg][0] != '-') video += fmt::format(",threads={}", atoi(argv[arg++]));
+
+	std::vector<std::string> args = { argv[0], "-x", "-snull", "-mnull", "-v" + video, "-g", savegame };
+	for (; arg < argc; arg++) args.emplace_back(argv[arg]);
+
+	std::vector<char *> args_ptr;
+	for (std::string &a : args) args_ptr.push_back(a.data());
+	args_ptr.push_back(nullptr);
+
+	CrashLog::InitialiseCrashLog();
+
+	/* Only affects things outside the game state; still, make runs as alike as possible. */
+	SetRandomSeed(0);
+
+	return openttd_main((int)args.size(), args_ptr.data());
+}
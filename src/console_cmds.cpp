@@ -24,6 +24,7 @@
 #include "fios.h"
 #include "fileio_func.h"
 #include "fontcache.h"
+#include "spritecache.h"
 #include "screenshot.h"
 #include "genworld.h"
 #include "strings_func.h"
@@ -36,10 +37,14 @@
 #include "ai/ai_config.hpp"
 #include "newgrf.h"
 #include "newgrf_profiling.h"
+#include "tick_profiling.h"
 #include "console_func.h"
 #include "engine_base.h"
 #include "road.h"
 #include "rail.h"
+#include "station_base.h"
+#include "pathfinder/yapf/yapf_cache.h"
+#include "pathfinder/rail_junctions.h"
 #include "game/game.hpp"
 #include "table/strings.h"
 #include "3rdparty/fmt/chrono.h"
@@ -2290,6 +2295,7 @@ DEF_CONSOLE_CMD(ConNewGRFProfile)
 		IConsolePrint(CC_HELP, "  Unselect one or more GRFs from profiling. Use the keyword \"all\" instead of a GRF number to unselect all. Removing an active profiler aborts data collection.");
 		IConsolePrint(CC_HELP, "Usage: 'newgrf_profile start [<num-ticks>]':");
 		IConsolePrint(CC_HELP, "  Begin profiling all selected GRFs. If a number of ticks is provided, profiling stops after that many game ticks. There are 74 ticks in a calendar day.");
+		IConsolePrint(CC_HELP, "  Calls alternate between the compiled and the interpreted varaction 2, to compare their performance.");
 		IConsolePrint(CC_HELP, "Usage: 'newgrf_profile stop':");
 		IConsolePrint(CC_HELP, "  End profiling and write the collected data to CSV files.");
 		IConsolePrint(CC_HELP, "Usage: 'newgrf_profile abort':");
@@ -2399,6 +2405,79 @@ DEF_CONSOLE_CMD(ConNewGRFProfile)
 	return false;
 }
 
+DEF_CONSOLE_CMD(ConTickProfile)
+{
+	if (argc == 0) {
+		IConsolePrint(CC_HELP, "Collect performance data about the game loop, per subsystem and per vehicle, station, town, industry and NewGRF. Sub-commands can be abbreviated.");
+		IConsolePrint(CC_HELP, "Usage: 'tick_profile start [<num-ticks>]':");
+		IConsolePrint(CC_HELP, "  Begin profiling, discarding any previously collected data. If a number of ticks is provided, profiling stops after that many game ticks.");
+		IConsolePrint(CC_HELP, "Usage: 'tick_profile stop':");
+		IConsolePrint(CC_HELP, "  End profiling and show the time spent per subsystem.");
+		IConsolePrint(CC_HELP, "Usage: 'tick_profile summary':");
+		IConsolePrint(CC_HELP, "  Show the time spent per subsystem.");
+		IConsolePrint(CC_HELP, "Usage: 'tick_profile top <subsystem> [<count>]':");
+		IConsolePrint(CC_HELP, "  Show the entities that took the most time in a subsystem; one of vehicle, station, town, industry, yapf_train, yapf_road, yapf_ship or newgrf.");
+		IConsolePrint(CC_HELP, "Usage: 'tick_profile export':");
+		IConsolePrint(CC_HELP, "  Write the collected data to the screenshot directory as a trace that can be opened in chrome://tracing or Perfetto.");
+		IConsolePrint(CC_HELP, "Usage: 'tick_profile abort':");
+		IConsolePrint(CC_HELP, "  End profiling and discard all collected data.");
+		return true;
+	}
+
+	if (argc == 1) return false;
+
+	/* "start" sub-command */
+	if (StrStartsWithIgnoreCase(argv[1], "sta")) {
+		uint64_t ticks = (argc >= 3) ? std::max(atoi(argv[2]), 1) : 0;
+		StartTickProfile(ticks);
+		if (ticks > 0) {
+			IConsolePrint(CC_DEBUG, "Started tick profiling, it will automatically stop after {} ticks.", ticks);
+		} else {
+			IConsolePrint(CC_DEBUG, "Started tick profiling.");
+		}
+		return true;
+	}
+
+	/* "stop" sub-command */
+	if (StrStartsWithIgnoreCase(argv[1], "sto")) {
+		StopTickProfile();
+		PrintTickProfileSummary();
+		return true;
+	}
+
+	/* "summary" sub-command */
+	if (StrStartsWithIgnoreCase(argv[1], "sum")) {
+		PrintTickProfileSummary();
+		return true;
+	}
+
+	/* "top" sub-command */
+	if (StrStartsWithIgnoreCase(argv[1], "top") && argc >= 3) {
+		uint count = (argc >= 4) ? std::max(atoi(argv[3]), 1) : 10;
+		if (!PrintTickProfileTop(argv[2], count)) {
+			IConsolePrint(CC_ERROR, "'{}' is not a subsystem that is profiled per entity.", argv[2]);
+		}
+		return true;
+	}
+
+	/* "export" sub-command */
+	if (StrStartsWithIgnoreCase(argv[1], "exp")) {
+		std::string filename = GetTickProfileFilename();
+		if (!ExportTickProfile(filename)) {
+			IConsolePrint(CC_ERROR, "Failed to write tick profile to '{}'.", filename);
+		}
+		return true;
+	}
+
+	/* "abort" sub-command */
+	if (StrStartsWithIgnoreCase(argv[1], "abo")) {
+		AbortTickProfile();
+		return true;
+	}
+
+	return false;
+}
+
 #ifdef _DEBUG
 /******************
  *  debug commands
@@ -2423,6 +2502,56 @@ DEF_CONSOLE_CMD(ConFramerate)
 	return true;
 }
 
+DEF_CONSOLE_CMD(ConSpriteSort)
+{
+	if (argc == 0) {
+		IConsolePrint(CC_HELP, "Benchmark the sorting of viewport sprites.");
+		IConsolePrint(CC_HELP, "Usage: 'sprite_sort dump <file>':");
+		IConsolePrint(CC_HELP, "  Write the sprites of the next viewport redraw to a file in the screenshot directory.");
+		IConsolePrint(CC_HELP, "Usage: 'sprite_sort benchmark <file> [<repeats>]':");
+		IConsolePrint(CC_HELP, "  Time the sprite sorters with the sprites in a file in the screenshot directory written by 'sprite_sort dump'.");
+		return true;
+	}
+
+	if (argc < 3) return false;
+
+	if (StrEqualsIgnoreCase(argv[1], "dump")) {
+		if (!DumpViewportSpriteSort(argv[2])) {
+			IConsolePrint(CC_ERROR, "'{}' is not a valid file name; it must not contain directories.", argv[2]);
+			return false;
+		}
+		return true;
+	}
+
+	if (StrEqualsIgnoreCase(argv[1], "benchmark")) {
+		uint repeats = (argc >= 4) ? std::max(atoi(argv[3]), 1) : 10;
+		if (!BenchmarkViewportSpriteSorters(argv[2], repeats)) {
+			IConsolePrint(CC_ERROR, "Could not read sprites from '{}'.", argv[2]);
+			return false;
+		}
+		return true;
+	}
+
+	return false;
+}
+
+DEF_CONSOLE_CMD(ConSpriteCache)
+{
+	if (argc == 0) {
+		IConsolePrint(CC_HELP, "Show statistics of the sprite cache. Usage: 'sprite_cache [reset]'.");
+		return true;
+	}
+
+	if (argc >= 2) {
+		if (!StrEqualsIgnoreCase(argv[1], "reset")) return false;
+		ResetSpriteCacheStats();
+		return true;
+	}
+
+	ConPrintSpriteCacheStats();
+	return true;
+}
+
 DEF_CONSOLE_CMD(ConFramerateWindow)
 {
 	if (argc == 0) {
@@ -2564,12 +2693,56 @@ static void ConDumpCargoTypes()
 }
 
 
+static void ConDumpFlows()
+{
+	/* Estimated size of a node of a red-black tree, excluding its value: colour, parent, left and right. */
+	static const size_t TREE_NODE_OVERHEAD = 4 * sizeof(void *);
+
+	size_t stations = 0;
+	size_t flow_stats = 0;
+	size_t shares = 0;
+	size_t flat_bytes = 0;
+	for (const Station *st : Station::Iterate()) {
+		bool has_flows = false;
+		for (const GoodsEntry &ge : st->goods) {
+			if (ge.flows.empty()) continue;
+			has_flows = true;
+			flow_stats += ge.flows.size();
+			flat_bytes += ge.flows.capacity() * sizeof(FlowStatMap::value_type);
+			for (const auto &it : ge.flows) {
+				shares += it.second.GetShares()->size();
+				flat_bytes += it.second.GetShares()->capacity() * sizeof(FlowStat::SharesMap::value_type);
+			}
+		}
+		if (has_flows) stations++;
+	}
+
+	/* What the same flows took when stored in nested std::maps. */
+	size_t tree_bytes = flow_stats * (TREE_NODE_OVERHEAD + sizeof(StationID) + sizeof(std::map<uint32_t, StationID>) + sizeof(uint)) +
+			shares * (TREE_NODE_OVERHEAD + sizeof(FlowStat::SharesMap::value_type));
+
+	IConsolePrint(CC_DEFAULT, "  Stations with flows: {}, flow stats: {}, shares: {}", stations, flow_stats, shares);
+	IConsolePrint(CC_DEFAULT, "  Memory used by flows: {} bytes, {} bytes per station", flat_bytes, stations > 0 ? flat_bytes / stations : 0);
+	IConsolePrint(CC_DEFAULT, "  Estimated memory use when stored as trees: {} bytes, {} bytes per station", tree_bytes, stations > 0 ? tree_bytes / stations : 0);
+}
+
+static void ConDumpYapfCache()
+{
+	YapfSegmentCacheStats stats = YapfGetSegmentCacheStats();
+	uint64_t lookups = stats.hits + stats.misses;
+
+	IConsolePrint(CC_DEFAULT, "  Rail segment cost cache: {} segments, {} tile index entries", stats.segments, stats.index_entries);
+	IConsolePrint(CC_DEFAULT, "  Hits: {}, misses: {}, hit rate: {:.1f}%", stats.hits, stats.misses, lookups > 0 ? 100.0 * stats.hits / lookups : 0.0);
+	IConsolePrint(CC_DEFAULT, "  Invalidated by track changes: {}, dropped by {} flushes: {}", stats.invalidated, stats.flushes, stats.flushed);
+	PrintRailJunctionDebugInfo();
+}
+
 DEF_CONSOLE_CMD(ConDumpInfo)
 {
 	if (argc != 2) {
 		IConsolePrint(CC_HELP, "Dump debugging information.");
-		IConsolePrint(CC_HELP, "Usage: 'dump_info roadtypes|railtypes|cargotypes'.");
-		IConsolePrint(CC_HELP, "  Show information about road/tram types, rail types or cargo types.");
+		IConsolePrint(CC_HELP, "Usage: 'dump_info roadtypes|railtypes|cargotypes|flows|yapf'.");
+		IConsolePrint(CC_HELP, "  Show information about road/tram types, rail types, cargo types, the memory used by cargo flows or the rail pathfinder cache.");
 		return true;
 	}
 
@@ -2588,6 +2761,16 @@ DEF_CONSOLE_CMD(ConDumpInfo)
 		return true;
 	}
 
+	if (StrEqualsIgnoreCase(argv[1], "flows")) {
+		ConDumpFlows();
+		return true;
+	}
+
+	if (StrEqualsIgnoreCase(argv[1], "yapf")) {
+		ConDumpYapfCache();
+		return true;
+	}
+
 	return false;
 }
 
@@ -2731,10 +2914,13 @@ void IConsoleStdLibRegister()
 #endif
 	IConsole::CmdRegister("fps",                     ConFramerate);
 	IConsole::CmdRegister("fps_wnd",                 ConFramerateWindow);
+	IConsole::CmdRegister("sprite_sort",             ConSpriteSort);
+	IConsole::CmdRegister("sprite_cache",            ConSpriteCache);
 
 	/* NewGRF development stuff */
 	IConsole::CmdRegister("reload_newgrfs",          ConNewGRFReload,     ConHookNewGRFDeveloperTool);
 	IConsole::CmdRegister("newgrf_profile",          ConNewGRFProfile,    ConHookNewGRFDeveloperTool);
+	IConsole::CmdRegister("tick_profile",            ConTickProfile);
 
 	IConsole::CmdRegister("dump_info",               ConDumpInfo);
 }
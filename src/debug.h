@@ -52,6 +52,7 @@ extern int _debug_sl_level;
 extern int _debug_gamelog_level;
 extern int _debug_desync_level;
 extern int _debug_console_level;
+extern int _debug_linkgraph_level;
 #ifdef RANDOM_DEBUG
 extern int _debug_random_level;
 #endif
@@ -1030,6 +1030,8 @@ void DeterminePaths(const char *exe, bool only_local_path)
 	_private_file = config_dir + "private.cfg";
 	extern std::string _secrets_file;
 	_secrets_file = config_dir + "secrets.cfg";
+	extern std::string _newgrf_scan_cache_file;
+	_newgrf_scan_cache_file = config_dir + "newgrf_scan.dat";
 
 #ifdef USE_XDG
 	if (config_dir == config_home) {
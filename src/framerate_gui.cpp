@@ -68,6 +68,9 @@ namespace {
 		/** Start time for current accumulation cycle */
 		TimingMeasurement acc_timestamp;
 
+		/** Time spent processing all cycles since the totals were last reset */
+		TimingMeasurement total_duration = 0;
+
 		/**
 		 * Initialize a data element with an expected collection rate
 		 * @param expected_rate
@@ -81,6 +84,7 @@ namespace {
 		{
 			this->durations[this->next_index] = end_time - start_time;
 			this->timestamps[this->next_index] = start_time;
+			this->total_duration += end_time - start_time;
 			this->prev_index = this->next_index;
 			this->next_index += 1;
 			if (this->next_index >= NUM_FRAMERATE_POINTS) this->next_index = 0;
@@ -105,6 +109,7 @@ namespace {
 		void AddAccumulate(TimingMeasurement duration)
 		{
 			this->acc_duration += duration;
+			this->total_duration += duration;
 		}
 
 		/** Indicate a pause/expected discontinuity in processing the element */
@@ -1039,6 +1044,22 @@ void ShowFrametimeGraphWindow(PerformanceElement elem)
 	AllocateWindowDescFront<FrametimeGraphWindow>(&_frametime_graph_window_desc, elem, true);
 }
 
+/** Reset the total time spent in all performance elements. */
+void ResetPerformanceTotals()
+{
+	for (PerformanceData &pf : _pf_data) pf.total_duration = 0;
+}
+
+/**
+ * Get the total time spent in a performance element since the totals were last reset.
+ * @param elem The element to get the total time of.
+ * @return Time in milliseconds.
+ */
+double GetPerformanceTotalMilliseconds(PerformanceElement elem)
+{
+	return (double)_pf_data[elem].total_duration * 1000 / TIMESTAMP_PRECISION;
+}
+
 /** Print performance statistics to game console */
 void ConPrintFramerate()
 {
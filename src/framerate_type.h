@@ -122,5 +122,7 @@ public:
 
 void ShowFramerateWindow();
 void ProcessPendingPerformanceMeasurements();
+void ResetPerformanceTotals();
+double GetPerformanceTotalMilliseconds(PerformanceElement elem);
 
 #endif /* FRAMERATE_TYPE_H */
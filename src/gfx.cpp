@@ -52,8 +52,9 @@ PauseMode _pause_mode;
 static byte _stringwidth_table[FS_END][224]; ///< Cache containing width of often used characters. @see GetCharacterWidth()
 DrawPixelInfo *_cur_dpi;
 
-static void GfxMainBlitterViewport(const Sprite *sprite, int x, int y, BlitterMode mode, const SubSprite *sub = nullptr, SpriteID sprite_id = SPR_CURSOR_MOUSE);
 static void GfxMainBlitter(const Sprite *sprite, int x, int y, BlitterMode mode, const SubSprite *sub = nullptr, SpriteID sprite_id = SPR_CURSOR_MOUSE, ZoomLevel zoom = ZOOM_LVL_NORMAL);
+template <int ZOOM_BASE, bool SCALED_XY>
+static void GfxBlitter(const Sprite * const sprite, int x, int y, BlitterMode mode, const SubSprite * const sub, SpriteID sprite_id, ZoomLevel zoom, const DrawPixelInfo *dst = nullptr, const byte *remap = nullptr);
 
 static ReusableBuffer<uint8_t> _cursor_backup;
 
@@ -464,7 +465,7 @@ void DrawRectOutline(const Rect &r, int colour, int width, int dash)
  * Set the colour remap to be for the given colour.
  * @param colour the new colour of the remap.
  */
-static void SetColourRemap(TextColour colour)
+static void SetColourRemap(TextColour colour, byte *remap = _string_colourremap)
 {
 	if (colour == TC_INVALID) return;
 
@@ -474,9 +475,9 @@ static void SetColourRemap(TextColour colour)
 	bool raw_colour = (colour & TC_IS_PALETTE_COLOUR) != 0;
 	colour &= ~(TC_NO_SHADE | TC_IS_PALETTE_COLOUR | TC_FORCED);
 
-	_string_colourremap[1] = raw_colour ? (byte)colour : _string_colourmap[colour];
-	_string_colourremap[2] = no_shade ? 0 : 1;
-	_colour_remap_ptr = _string_colourremap;
+	remap[1] = raw_colour ? (byte)colour : _string_colourmap[colour];
+	remap[2] = no_shade ? 0 : 1;
+	if (remap == _string_colourremap) _colour_remap_ptr = _string_colourremap;
 }
 
 /**
@@ -978,21 +979,59 @@ static BlitterMode GetBlitterMode(PaletteID pal)
  */
 void DrawSpriteViewport(SpriteID img, PaletteID pal, int x, int y, const SubSprite *sub)
 {
-	SpriteID real_sprite = GB(img, 0, SPRITE_WIDTH);
+	DrawPreparedSpriteViewport(PrepareSpriteViewport(img, pal), x, y, sub, _cur_dpi);
+}
+
+/**
+ * Look up everything that is needed to draw a sprite in a viewport.
+ * The result stays valid as long as the version of the sprite cache does not change.
+ * @param img Image number to draw
+ * @param pal Palette to use.
+ * @return The sprite, ready to be drawn.
+ */
+PreparedViewportSprite PrepareSpriteViewport(SpriteID img, PaletteID pal)
+{
+	PreparedViewportSprite ps;
+	ps.img = img;
+	ps.pal = pal;
+	ps.remap = _colour_remap_ptr;
+	std::copy(std::begin(_string_colourremap), std::end(_string_colourremap), ps.text_remap);
+
 	if (HasBit(img, PALETTE_MODIFIER_TRANSPARENT)) {
-		pal = GB(pal, 0, PALETTE_WIDTH);
-		_colour_remap_ptr = GetNonSprite(pal, SpriteType::Recolour) + 1;
-		GfxMainBlitterViewport(GetSprite(real_sprite, SpriteType::Normal), x, y, pal == PALETTE_TO_TRANSPARENT ? BM_TRANSPARENT : BM_TRANSPARENT_REMAP, sub, real_sprite);
+		ps.remap = GetNonSprite(GB(pal, 0, PALETTE_WIDTH), SpriteType::Recolour) + 1;
 	} else if (pal != PAL_NONE) {
 		if (HasBit(pal, PALETTE_TEXT_RECOLOUR)) {
-			SetColourRemap((TextColour)GB(pal, 0, PALETTE_WIDTH));
+			SetColourRemap((TextColour)GB(pal, 0, PALETTE_WIDTH), ps.text_remap);
+			ps.remap = nullptr;
 		} else {
-			_colour_remap_ptr = GetNonSprite(GB(pal, 0, PALETTE_WIDTH), SpriteType::Recolour) + 1;
+			ps.remap = GetNonSprite(GB(pal, 0, PALETTE_WIDTH), SpriteType::Recolour) + 1;
 		}
-		GfxMainBlitterViewport(GetSprite(real_sprite, SpriteType::Normal), x, y, GetBlitterMode(pal), sub, real_sprite);
+	}
+	ps.sprite = GetSprite(GB(img, 0, SPRITE_WIDTH), SpriteType::Normal);
+	return ps;
+}
+
+/**
+ * Draw a sprite in a viewport that has been looked up before.
+ * This does not use the sprite cache or global drawing state, so different threads may draw to different parts of the screen.
+ * @param ps   The sprite to draw.
+ * @param x    Left coordinate of image in viewport, scaled by zoom
+ * @param y    Top coordinate of image in viewport, scaled by zoom
+ * @param sub  If available, draw only specified part of the sprite
+ * @param dpi  The part of the viewport to draw to.
+ */
+void DrawPreparedSpriteViewport(const PreparedViewportSprite &ps, int x, int y, const SubSprite *sub, const DrawPixelInfo *dpi)
+{
+	SpriteID real_sprite = GB(ps.img, 0, SPRITE_WIDTH);
+	const byte *remap = ps.remap != nullptr ? ps.remap : ps.text_remap;
+
+	BlitterMode mode;
+	if (HasBit(ps.img, PALETTE_MODIFIER_TRANSPARENT)) {
+		mode = GB(ps.pal, 0, PALETTE_WIDTH) == PALETTE_TO_TRANSPARENT ? BM_TRANSPARENT : BM_TRANSPARENT_REMAP;
 	} else {
-		GfxMainBlitterViewport(GetSprite(real_sprite, SpriteType::Normal), x, y, BM_NORMAL, sub, real_sprite);
+		mode = GetBlitterMode(ps.pal);
 	}
+	GfxBlitter<ZOOM_LVL_BASE, false>(ps.sprite, x, y, mode, sub, real_sprite, dpi->zoom, dpi, remap);
 }
 
 /**
@@ -1032,11 +1071,12 @@ void DrawSprite(SpriteID img, PaletteID pal, int x, int y, const SubSprite *sub,
  * @param sub Whether to only draw a sub set of the sprite.
  * @param zoom The zoom level at which to draw the sprites.
  * @param dst Optional parameter for a different blitting destination.
+ * @param remap Optional parameter for a different recolouring than the last one that was set.
  * @tparam ZOOM_BASE The factor required to get the sub sprite information into the right size.
  * @tparam SCALED_XY Whether the X and Y are scaled or unscaled.
  */
 template <int ZOOM_BASE, bool SCALED_XY>
-static void GfxBlitter(const Sprite * const sprite, int x, int y, BlitterMode mode, const SubSprite * const sub, SpriteID sprite_id, ZoomLevel zoom, const DrawPixelInfo *dst = nullptr)
+static void GfxBlitter(const Sprite * const sprite, int x, int y, BlitterMode mode, const SubSprite * const sub, SpriteID sprite_id, ZoomLevel zoom, const DrawPixelInfo *dst, const byte *remap)
 {
 	const DrawPixelInfo *dpi = (dst != nullptr) ? dst : _cur_dpi;
 	Blitter::BlitterParams bp;
@@ -1085,7 +1125,7 @@ static void GfxBlitter(const Sprite * const sprite, int x, int y, BlitterMode mo
 
 	bp.dst = dpi->dst_ptr;
 	bp.pitch = dpi->pitch;
-	bp.remap = _colour_remap_ptr;
+	bp.remap = (remap != nullptr) ? remap : _colour_remap_ptr;
 
 	assert(sprite->width > 0);
 	assert(sprite->height > 0);
@@ -1216,11 +1256,6 @@ std::unique_ptr<uint32_t[]> DrawSpriteToRgbaBuffer(SpriteID spriteId, ZoomLevel
 	return result;
 }
 
-static void GfxMainBlitterViewport(const Sprite *sprite, int x, int y, BlitterMode mode, const SubSprite *sub, SpriteID sprite_id)
-{
-	GfxBlitter<ZOOM_LVL_BASE, false>(sprite, x, y, mode, sub, sprite_id, _cur_dpi->zoom);
-}
-
 static void GfxMainBlitter(const Sprite *sprite, int x, int y, BlitterMode mode, const SubSprite *sub, SpriteID sprite_id, ZoomLevel zoom)
 {
 	GfxBlitter<1, true>(sprite, x, y, mode, sub, sprite_id, zoom);
@@ -1551,6 +1586,7 @@ void AddDirtyBlock(int left, int top, int right, int bottom)
  */
 void MarkWholeScreenDirty()
 {
+	ClearTileDrawCache();
 	AddDirtyBlock(0, 0, _screen.width, _screen.height);
 }
 
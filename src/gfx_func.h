@@ -85,9 +85,20 @@ void UndrawMouseCursor();
 void RedrawScreenRect(int left, int top, int right, int bottom);
 void GfxScroll(int left, int top, int width, int height, int xo, int yo);
 
+/** A sprite for a viewport that has been looked up in the sprite cache, so it can be drawn by any thread. */
+struct PreparedViewportSprite {
+	const struct Sprite *sprite; ///< The sprite data.
+	const byte *remap;           ///< The recolour sprite to use, or \c nullptr to use #text_remap.
+	byte text_remap[3];          ///< Recolouring for a text colour palette.
+	SpriteID img;                ///< The image that is drawn.
+	PaletteID pal;               ///< The palette that is used.
+};
+
 Dimension GetSpriteSize(SpriteID sprid, Point *offset = nullptr, ZoomLevel zoom = ZOOM_LVL_GUI);
 Dimension GetScaledSpriteSize(SpriteID sprid); /* widget.cpp */
 void DrawSpriteViewport(SpriteID img, PaletteID pal, int x, int y, const SubSprite *sub = nullptr);
+PreparedViewportSprite PrepareSpriteViewport(SpriteID img, PaletteID pal);
+void DrawPreparedSpriteViewport(const PreparedViewportSprite &ps, int x, int y, const SubSprite *sub, const DrawPixelInfo *dpi);
 void DrawSprite(SpriteID img, PaletteID pal, int x, int y, const SubSprite *sub = nullptr, ZoomLevel zoom = ZOOM_LVL_GUI);
 void DrawSpriteIgnorePadding(SpriteID img, PaletteID pal, const Rect &r, StringAlignment align); /* widget.cpp */
 std::unique_ptr<uint32_t[]> DrawSpriteToRgbaBuffer(SpriteID spriteId, ZoomLevel zoom = ZOOM_LVL_GUI);
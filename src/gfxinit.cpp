@@ -225,6 +225,8 @@ static void RealChangeBlitter(const char *repl_blitter)
 	if (strcmp(cur_blitter, repl_blitter) == 0) return;
 
 	Debug(driver, 1, "Switching blitter from '{}' to '{}'... ", cur_blitter, repl_blitter);
+	/* Sprites that are being decoded in the background use the current blitter. */
+	FlushSpriteDecoder();
 	Blitter *new_blitter = BlitterFactory::SelectBlitter(repl_blitter);
 	if (new_blitter == nullptr) NOT_REACHED();
 	Debug(driver, 1, "Successfully switched to {}.", repl_blitter);
@@ -43,6 +43,7 @@
 #include "industry_cmd.h"
 #include "landscape_cmd.h"
 #include "terraform_cmd.h"
+#include "tick_profiling.h"
 #include "timer/timer.h"
 #include "timer/timer_game_calendar.h"
 #include "timer/timer_game_economy.h"
@@ -1242,6 +1243,7 @@ void OnTick_Industry()
 	if (_game_mode == GM_EDITOR) return;
 
 	for (Industry *i : Industry::Iterate()) {
+		TickProfileScope tick_profile(TPZ_INDUSTRY, i->index);
 		ProduceIndustryGoods(i);
 	}
 }
@@ -3199,6 +3201,7 @@ extern const TileTypeProcs _tile_type_industry_procs = {
 	nullptr,                        // vehicle_enter_tile_proc
 	GetFoundation_Industry,      // get_foundation_proc
 	TerraformTile_Industry,      // terraform_tile_proc
+	nullptr,                     // tile_loop_idle_proc
 };
 
 bool IndustryCompare::operator() (const IndustryListEntry &lhs, const IndustryListEntry &rhs) const
@@ -36,7 +36,10 @@
 #include "landscape_cmd.h"
 #include "terraform_cmd.h"
 #include "station_func.h"
+#include "pathfinder/road_regions.h"
 #include "pathfinder/water_regions.h"
+#include "worker_pool.h"
+#include "tick_profiling.h"
 
 #include "table/strings.h"
 #include "table/sprites.h"
@@ -541,6 +544,7 @@ void DoClearSquare(TileIndex tile)
 	if (remove) RemoveDockingTile(tile);
 
 	InvalidateWaterRegion(tile);
+	InvalidateRoadRegion(tile);
 }
 
 /**
@@ -755,12 +759,51 @@ std::tuple<CommandCost, Money> CmdClearArea(DoCommandFlag flags, TileIndex tile,
 
 TileIndex _cur_tileloop_tile;
 
+/**
+ * Run the tile loop for a batch of tiles in two phases. First the worker threads
+ * check which tiles of the batch are idle, i.e. their tile loop would do nothing.
+ * Then the tile loop procs of the other tiles are called in the usual order.
+ * @param tile First tile of the batch.
+ * @param count Number of tiles in the batch.
+ * @param feedback Feedback term of the LFSR generating the order of the tiles.
+ * @return The tile after the batch.
+ */
+static TileIndex RunTileLoopBatch(TileIndex tile, uint count, uint32_t feedback)
+{
+	static std::vector<TileIndex> tiles;
+	static std::vector<uint8_t> idle;
+
+	tiles.clear();
+	for (uint i = 0; i < count; i++) {
+		tiles.push_back(tile);
+
+		/* Get the next tile in sequence using a Galois LFSR. */
+		tile = (tile.base() >> 1) ^ (-(int32_t)(tile.base() & 1) & feedback);
+	}
+
+	idle.assign(count, 0);
+	ParallelFor(count, [](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			TileLoopIdleProc *proc = _tile_type_procs[GetTileType(tiles[i])]->tile_loop_idle_proc;
+			if (proc != nullptr) idle[i] = proc(tiles[i]);
+		}
+	});
+
+	for (uint i = 0; i < count; i++) {
+		if (idle[i]) continue;
+		_tile_type_procs[GetTileType(tiles[i])]->tile_loop_proc(tiles[i]);
+	}
+
+	return tile;
+}
+
 /**
  * Gradually iterate over all tiles on the map, calling their TileLoopProcs once every 256 ticks.
  */
 void RunTileLoop()
 {
 	PerformanceAccumulator framerate(PFE_GL_LANDSCAPE);
+	TickProfileScope tick_profile(TPZ_TILELOOP);
 
 	/* The pseudorandom sequence of tiles is generated using a Galois linear feedback
 	 * shift register (LFSR). This allows a deterministic pseudorandom ordering, but
@@ -787,11 +830,15 @@ void RunTileLoop()
 		count--;
 	}
 
-	while (count--) {
-		_tile_type_procs[GetTileType(tile)]->tile_loop_proc(tile);
+	if (GetWorkerThreadCount() > 1) {
+		tile = RunTileLoopBatch(tile, count, feedback);
+	} else {
+		while (count--) {
+			_tile_type_procs[GetTileType(tile)]->tile_loop_proc(tile);
 
-		/* Get the next tile in sequence using a Galois LFSR. */
-		tile = (tile.base() >> 1) ^ (-(int32_t)(tile.base() & 1) & feedback);
+			/* Get the next tile in sequence using a Galois LFSR. */
+			tile = (tile.base() >> 1) ^ (-(int32_t)(tile.base() & 1) & feedback);
+		}
 	}
 
 	_cur_tileloop_tile = tile;
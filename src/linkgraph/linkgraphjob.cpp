@@ -13,6 +13,8 @@
 #include "linkgraphjob.h"
 #include "linkgraphschedule.h"
 
+#include <condition_variable>
+
 #include "../safeguards.h"
 
 /* Initialize the link-graph-job-pool */
@@ -38,6 +40,7 @@ LinkGraphJob::LinkGraphJob(const LinkGraph &orig) :
 		link_graph(orig),
 		settings(_settings_game.linkgraph),
 		join_date(TimerGameEconomy::date + (_settings_game.linkgraph.recalc_time / EconomyTime::SECONDS_PER_DAY)),
+		queued(false),
 		job_completed(false),
 		job_aborted(false)
 {
@@ -55,12 +58,153 @@ void LinkGraphJob::EraseFlows(NodeID from)
 }
 
 /**
- * Spawn a thread if possible and run the link graph job in the thread. If
- * that's not possible run the job right now in the current thread.
+ * Persistent threads running the link graph jobs. Jobs are not tied to a thread;
+ * whenever a thread becomes available it takes the queued job that has to be
+ * joined first, and of those the biggest one as that takes longest to run.
+ * The order jobs are run in does not influence their results, so this does not
+ * affect the game state.
+ */
+class LinkGraphJobThreads {
+	/** Job waiting for a thread, with its priority fixed when queueing it. */
+	struct QueuedJob {
+		LinkGraphJob *job;                ///< The job.
+		TimerGameEconomy::Date join_date; ///< Date the job has to be joined.
+		uint size;                        ///< Number of nodes of the job.
+
+		/**
+		 * Check whether this job should be run after another job.
+		 * @param other The other job.
+		 * @return True iff the other job has a higher priority.
+		 */
+		bool operator<(const QueuedJob &other) const
+		{
+			if (this->join_date != other.join_date) return this->join_date > other.join_date;
+			if (this->size != other.size) return this->size < other.size;
+			return this->job->index > other.job->index;
+		}
+	};
+
+	std::vector<std::thread> threads;  ///< The threads, started when the first job is queued.
+	std::mutex mutex;                  ///< Protects all variables below and LinkGraphJob::queued.
+	std::condition_variable work_cv;   ///< Signalled when a job is queued or the threads should stop.
+	std::condition_variable done_cv;   ///< Signalled when a job has finished running.
+	std::vector<QueuedJob> queue;      ///< Heap of jobs waiting for a thread.
+	bool exit = false;                 ///< Whether the threads should stop.
+
+	/** Main loop of the threads. */
+	void ThreadLoop()
+	{
+		std::unique_lock<std::mutex> lock(this->mutex);
+		for (;;) {
+			this->work_cv.wait(lock, [&]() { return this->exit || !this->queue.empty(); });
+			if (this->exit) return;
+
+			std::pop_heap(this->queue.begin(), this->queue.end());
+			LinkGraphJob *job = this->queue.back().job;
+			this->queue.pop_back();
+
+			lock.unlock();
+			job->RunInThread();
+			lock.lock();
+
+			job->queued = false;
+			this->done_cv.notify_all();
+		}
+	}
+
+	/**
+	 * Entry point of the threads.
+	 * @param threads The threads object the thread belongs to.
+	 */
+	static void ThreadThunk(LinkGraphJobThreads *threads)
+	{
+		threads->ThreadLoop();
+	}
+
+public:
+	~LinkGraphJobThreads()
+	{
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->exit = true;
+		}
+		this->work_cv.notify_all();
+		for (std::thread &t : this->threads) t.join();
+	}
+
+	/**
+	 * Queue a job to be run by one of the threads.
+	 * @param job The job.
+	 * @return False if no thread could be started; the job is not queued then.
+	 */
+	bool Queue(LinkGraphJob *job)
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		if (this->threads.empty()) {
+			/* Leave one hardware thread for the game itself. */
+			uint count = std::max(2U, std::thread::hardware_concurrency()) - 1;
+			for (uint i = 0; i < count; i++) {
+				std::thread t;
+				if (!StartNewThread(&t, "ottd:linkgraph", &LinkGraphJobThreads::ThreadThunk, this)) break;
+				this->threads.push_back(std::move(t));
+			}
+			if (this->threads.empty()) return false;
+		}
+
+		job->queued = true;
+		this->queue.push_back({ job, job->JoinDate(), job->Size() });
+		std::push_heap(this->queue.begin(), this->queue.end());
+		this->work_cv.notify_one();
+		return true;
+	}
+
+	/**
+	 * Wait until a job is not used by any of the threads anymore. If no thread has
+	 * started the job yet, it is taken out of the queue and, unless aborted, run
+	 * right away in the calling thread.
+	 * @param job The job.
+	 */
+	void Wait(LinkGraphJob *job)
+	{
+		std::unique_lock<std::mutex> lock(this->mutex);
+		if (!job->queued) return;
+
+		auto it = std::find_if(this->queue.begin(), this->queue.end(), [job](const QueuedJob &q) { return q.job == job; });
+		if (it != this->queue.end()) {
+			this->queue.erase(it);
+			std::make_heap(this->queue.begin(), this->queue.end());
+			job->queued = false;
+			lock.unlock();
+			if (!job->IsJobAborted()) job->RunInThread();
+			return;
+		}
+
+		this->done_cv.wait(lock, [job]() { return !job->queued; });
+	}
+};
+
+/** The threads running the link graph jobs. */
+static LinkGraphJobThreads _link_graph_job_threads;
+
+/**
+ * Run the link graph job and record how long that took.
+ * This is called from the thread the job is run in.
+ */
+void LinkGraphJob::RunInThread()
+{
+	this->start_time = std::chrono::steady_clock::now();
+	LinkGraphSchedule::Run(this);
+	this->finish_time = std::chrono::steady_clock::now();
+}
+
+/**
+ * Hand the job to the link graph threads if possible. If that's not possible
+ * run the job right now in the current thread.
  */
 void LinkGraphJob::SpawnThread()
 {
-	if (!StartNewThread(&this->thread, "ottd:linkgraph", &(LinkGraphSchedule::Run), this)) {
+	this->spawn_time = std::chrono::steady_clock::now();
+	if (!_link_graph_job_threads.Queue(this)) {
 		/* Of course this will hang a bit.
 		 * On the other hand, if you want to play games which make this hang noticeably
 		 * on a platform without threads then you'll probably get other problems first.
@@ -68,18 +212,27 @@ void LinkGraphJob::SpawnThread()
 		 * If someone comes and tells me that this hangs for them, I'll implement a
 		 * smaller grained "Step" method for all handlers and add some more ticks where
 		 * "Step" is called. No problem in principle. */
-		LinkGraphSchedule::Run(this);
+		this->RunInThread();
 	}
 }
 
 /**
- * Join the calling thread with this job's thread if threading is enabled.
+ * Wait until the link graph threads are done with this job, and report how long
+ * the job took compared to the time it had until being joined.
  */
 void LinkGraphJob::JoinThread()
 {
-	if (this->thread.joinable()) {
-		this->thread.join();
-	}
+	auto join_time = std::chrono::steady_clock::now();
+	_link_graph_job_threads.Wait(this);
+	if (this->IsJobAborted() || this->spawn_time == std::chrono::steady_clock::time_point{}) return;
+
+	using ms = std::chrono::duration<double, std::milli>;
+	auto stall = std::chrono::steady_clock::now() - join_time;
+	Debug(linkgraph, stall > std::chrono::milliseconds(1) ? 1 : 2,
+			"Job for link graph {} (cargo {}, {} nodes): waited {:.1f} ms for a thread, ran {:.1f} ms of the {:.1f} ms available, stalled the game {:.1f} ms",
+			this->link_graph.index, this->Cargo(), this->Size(),
+			ms(this->start_time - this->spawn_time).count(), ms(this->finish_time - this->start_time).count(),
+			ms(join_time - this->spawn_time).count(), ms(stall).count());
 }
 
 /**
@@ -157,7 +310,7 @@ LinkGraphJob::~LinkGraphJob()
 				} else {
 					FlowStat shares(INVALID_STATION, 1);
 					it->second.SwapShares(shares);
-					ge.flows.erase(it++);
+					it = ge.flows.erase(it);
 					for (FlowStat::SharesMap::const_iterator shares_it(shares.GetShares()->begin());
 							shares_it != shares.GetShares()->end(); ++shares_it) {
 						RerouteCargo(st, this->Cargo(), shares_it->second, st->index);
@@ -169,7 +322,7 @@ LinkGraphJob::~LinkGraphJob()
 				++it;
 			}
 		}
-		ge.flows.insert(flows.begin(), flows.end());
+		ge.flows.Merge(flows);
 		InvalidateWindowData(WC_STATION_VIEW, st->index, this->Cargo());
 	}
 }
@@ -13,6 +13,7 @@
 #include "../thread.h"
 #include "linkgraph.h"
 #include <atomic>
+#include <chrono>
 
 class LinkGraphJob;
 class Path;
@@ -158,12 +159,16 @@ private:
 
 	friend SaveLoadTable GetLinkGraphJobDesc();
 	friend class LinkGraphSchedule;
+	friend class LinkGraphJobThreads;
 
 protected:
 	const LinkGraph link_graph;        ///< Link graph to by analyzed. Is copied when job is started and mustn't be modified later.
 	const LinkGraphSettings settings;  ///< Copy of _settings_game.linkgraph at spawn time.
-	std::thread thread;                ///< Thread the job is running in or a default-constructed thread if it's running in the main thread.
 	TimerGameEconomy::Date join_date; ///< Date when the job is to be joined.
+	bool queued;                       ///< Is the job waiting for or running in a link graph thread. Protected by the mutex of the link graph threads.
+	std::chrono::steady_clock::time_point spawn_time;  ///< Time the job was handed to the link graph threads.
+	std::chrono::steady_clock::time_point start_time;  ///< Time a link graph thread started running the job.
+	std::chrono::steady_clock::time_point finish_time; ///< Time the job finished running.
 	NodeAnnotationVector nodes;        ///< Extra node data necessary for link graph calculation.
 	std::atomic<bool> job_completed;   ///< Is the job still running. This is accessed by multiple threads and reads may be stale.
 	std::atomic<bool> job_aborted;     ///< Has the job been aborted. This is accessed by multiple threads and reads may be stale.
@@ -171,6 +176,7 @@ protected:
 	void EraseFlows(NodeID from);
 	void JoinThread();
 	void SpawnThread();
+	void RunInThread();
 
 public:
 	/**
@@ -178,7 +184,7 @@ public:
 	 * settings have to be brutally const-casted in order to populate them.
 	 */
 	LinkGraphJob() : settings(_settings_game.linkgraph),
-			join_date(EconomyTime::INVALID_DATE), job_completed(false), job_aborted(false) {}
+			join_date(EconomyTime::INVALID_DATE), queued(false), job_completed(false), job_aborted(false) {}
 
 	LinkGraphJob(const LinkGraph &orig);
 	~LinkGraphJob();
@@ -3,12 +3,29 @@
 #include "../stdafx.h"
 #include "../core/math_func.hpp"
 #include "../timer/timer_game_tick.h"
+#include "../worker_pool.h"
 #include "mcf.h"
 
 #include "../safeguards.h"
 
 typedef std::map<NodeID, Path *> PathViaMap;
 
+/** Link graphs with at least this many nodes search the paths of multiple sources at once in the first pass. */
+static const uint MCF_PARALLEL_MIN_NODES = 128;
+
+/** Number of sources whose paths are searched at once, for big link graphs. */
+static const uint MCF_PARALLEL_SOURCES = 16;
+
+/**
+ * Entry of the open list of the Dijkstra algorithm.
+ * @tparam T Type of the annotation value.
+ */
+template <typename T>
+struct AnnotationEntry {
+	T annotation; ///< Value of the annotation of the node when it was added.
+	NodeID node;  ///< The node.
+};
+
 /**
  * Distance-based annotation for use in the Dijkstra algorithm. This is close
  * to the original meaning of "annotation" in this context. Paths are rated
@@ -37,11 +54,14 @@ public:
 	 */
 	inline void UpdateAnnotation() { }
 
+	/** Type of the annotation value. */
+	typedef uint AnnotationType;
+
 	/**
-	 * Comparator for std containers.
+	 * Comparator for the heap of the open list.
 	 */
 	struct Comparator {
-		bool operator()(const DistanceAnnotation *x, const DistanceAnnotation *y) const;
+		bool operator()(const AnnotationEntry<uint> &x, const AnnotationEntry<uint> &y) const;
 	};
 };
 
@@ -79,11 +99,14 @@ public:
 		this->cached_annotation = this->GetCapacityRatio();
 	}
 
+	/** Type of the annotation value. */
+	typedef int AnnotationType;
+
 	/**
-	 * Comparator for std containers.
+	 * Comparator for the heap of the open list.
 	 */
 	struct Comparator {
-		bool operator()(const CapacityAnnotation *x, const CapacityAnnotation *y) const;
+		bool operator()(const AnnotationEntry<int> &x, const AnnotationEntry<int> &y) const;
 	};
 };
 
@@ -256,38 +279,49 @@ bool CapacityAnnotation::IsBetter(const CapacityAnnotation *base, uint cap,
 template<class Tannotation, class Tedge_iterator>
 void MultiCommodityFlow::Dijkstra(NodeID source_node, PathVector &paths)
 {
-	typedef std::set<Tannotation *, typename Tannotation::Comparator> AnnoSet;
+	typedef AnnotationEntry<typename Tannotation::AnnotationType> Entry;
+	typename Tannotation::Comparator comp;
 	Tedge_iterator iter(this->job);
 	uint16_t size = this->job.Size();
-	AnnoSet annos;
+
+	/* Prioritize the fastest route for passengers, mail and express cargo,
+	 * and the shortest route for other classes of cargo. */
+	bool express = IsCargoInClass(this->job.Cargo(), CC_PASSENGERS) ||
+		IsCargoInClass(this->job.Cargo(), CC_MAIL) ||
+		IsCargoInClass(this->job.Cargo(), CC_EXPRESS);
+
+	/* Heap of nodes to be searched. Instead of removing a node when its annotation
+	 * changes, it is added again and the old entry is skipped once it comes up.
+	 * As the entries are ordered by annotation and node, this searches the nodes
+	 * in exactly the same order as an ordered set of the nodes would. */
+	std::vector<Entry> open;
+	std::vector<bool> in_open(size, true);
+	open.reserve(size);
 	paths.resize(size, nullptr);
 	for (NodeID node = 0; node < size; ++node) {
 		Tannotation *anno = new Tannotation(node, node == source_node);
 		anno->UpdateAnnotation();
-		annos.insert(anno);
+		open.push_back({anno->GetAnnotation(), node});
 		paths[node] = anno;
 	}
-	while (!annos.empty()) {
-		typename AnnoSet::iterator i = annos.begin();
-		Tannotation *source = *i;
-		annos.erase(i);
-		NodeID from = source->GetNode();
+	std::make_heap(open.begin(), open.end(), comp);
+
+	while (!open.empty()) {
+		std::pop_heap(open.begin(), open.end(), comp);
+		Entry entry = open.back();
+		open.pop_back();
+
+		Tannotation *source = static_cast<Tannotation *>(paths[entry.node]);
+		if (!in_open[entry.node] || entry.annotation != source->GetAnnotation()) continue;
+		in_open[entry.node] = false;
+
+		NodeID from = entry.node;
 		iter.SetNode(source_node, from);
 		for (NodeID to = iter.Next(); to != INVALID_NODE; to = iter.Next()) {
 			if (to == from) continue; // Not a real edge but a consumption sign.
 			const Edge &edge = this->job[from][to];
-			uint capacity = edge.base.capacity;
-			if (this->max_saturation != UINT_MAX) {
-				capacity *= this->max_saturation;
-				capacity /= 100;
-				if (capacity == 0) capacity = 1;
-			}
-			/* Prioritize the fastest route for passengers, mail and express cargo,
-			 * and the shortest route for other classes of cargo.
-			 * In-between stops are punished with a 1 tile or 1 day penalty. */
-			bool express = IsCargoInClass(this->job.Cargo(), CC_PASSENGERS) ||
-				IsCargoInClass(this->job.Cargo(), CC_MAIL) ||
-				IsCargoInClass(this->job.Cargo(), CC_EXPRESS);
+			uint capacity = this->GetSearchCapacity(edge);
+			/* In-between stops are punished with a 1 tile or 1 day penalty. */
 			uint distance = DistanceMaxPlusManhattan(this->job[from].base.xy, this->job[to].base.xy) + 1;
 			/* Compute a default travel time from the distance and an average speed of 1 tile/day. */
 			uint time = (edge.base.TravelTime() != 0) ? edge.base.TravelTime() + Ticks::DAY_TICKS : distance * Ticks::DAY_TICKS;
@@ -295,15 +329,83 @@ void MultiCommodityFlow::Dijkstra(NodeID source_node, PathVector &paths)
 
 			Tannotation *dest = static_cast<Tannotation *>(paths[to]);
 			if (dest->IsBetter(source, capacity, capacity - edge.Flow(), distance_anno)) {
-				annos.erase(dest);
 				dest->Fork(source, capacity, capacity - edge.Flow(), distance_anno);
 				dest->UpdateAnnotation();
-				annos.insert(dest);
+				open.push_back({dest->GetAnnotation(), to});
+				std::push_heap(open.begin(), open.end(), comp);
+				in_open[to] = true;
 			}
 		}
 	}
 }
 
+/**
+ * Run the Dijkstra algorithm for all unfinished sources in a range. For big link
+ * graphs the searches are split over the worker threads. As Dijkstra only reads
+ * the job, the results are the same however the searches are split.
+ * @tparam Tannotation Annotation to be used.
+ * @tparam Tedge_iterator Iterator to be used for getting outgoing edges.
+ * @param first First source to search the paths of.
+ * @param last One past the last source to search the paths of.
+ * @param finished_sources Sources that do not need to be searched anymore.
+ * @param paths Container for the paths of each source in the range.
+ */
+template<class Tannotation, class Tedge_iterator>
+void MultiCommodityFlow::FindPaths(NodeID first, NodeID last, const std::vector<bool> &finished_sources, std::vector<PathVector> &paths)
+{
+	ParallelFor(last - first, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			if (!finished_sources[first + i]) this->Dijkstra<Tannotation, Tedge_iterator>(first + i, paths[i]);
+		}
+	});
+}
+
+/**
+ * Get the number of sources whose paths are searched at once in the first pass. Those
+ * searches are repeated when flow pushed along the paths of an earlier source changes
+ * the outcome, so this does not change the result. It only pays off for big link graphs
+ * when there are worker threads to do the searches.
+ * @return Number of sources to search at once.
+ */
+NodeID MultiCommodityFlow::GetSourcesPerSearch() const
+{
+	return (this->job.Size() >= MCF_PARALLEL_MIN_NODES && GetWorkerThreadCount() > 1) ? MCF_PARALLEL_SOURCES : 1;
+}
+
+/**
+ * Get the capacity of an edge as the Dijkstra algorithm sees it.
+ * @param edge Edge to get the capacity of.
+ * @return The capacity of the edge, limited to the maximum saturation.
+ */
+uint MultiCommodityFlow::GetSearchCapacity(const Edge &edge) const
+{
+	uint capacity = edge.base.capacity;
+	if (this->max_saturation != UINT_MAX) {
+		capacity *= this->max_saturation;
+		capacity /= 100;
+		if (capacity == 0) capacity = 1;
+	}
+	return capacity;
+}
+
+/**
+ * Get the smallest flow that saturates one of the edges of a path that is not
+ * saturated yet. The distance annotation only checks whether edges are saturated,
+ * so pushing less flow along the path does not change the paths it finds.
+ * @param path End of the path.
+ * @return The flow, or UINT_MAX if all edges of the path are saturated.
+ */
+uint MultiCommodityFlow::GetSaturatingFlow(Path *path) const
+{
+	uint flow = UINT_MAX;
+	for (Path *parent = path->GetParent(); parent != nullptr; path = parent, parent = path->GetParent()) {
+		const Edge &edge = this->job[parent->GetNode()][path->GetNode()];
+		uint capacity = this->GetSearchCapacity(edge);
+		if (capacity > edge.Flow()) flow = std::min(flow, capacity - edge.Flow());
+	}
+	return flow;
+}
+
 /**
  * Clean up paths that lead nowhere and the root path.
  * @param source_id ID of the root node.
@@ -346,8 +448,10 @@ uint MultiCommodityFlow::PushFlow(Node &node, NodeID to, Path *path, uint accura
 {
 	assert(node.UnsatisfiedDemandTo(to) > 0);
 	uint flow = Clamp(node.DemandTo(to) / accuracy, 1, node.UnsatisfiedDemandTo(to));
+	uint saturating_flow = this->GetSaturatingFlow(path);
 	flow = path->AddFlow(flow, this->job, max_saturation);
 	node.SatisfyDemandTo(to, flow);
+	if (flow >= saturating_flow) this->saturated_edge = true;
 	return flow;
 }
 
@@ -498,20 +602,36 @@ bool MCF1stPass::EliminateCycles()
  */
 MCF1stPass::MCF1stPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 {
-	PathVector paths;
 	uint16_t size = job.Size();
 	uint accuracy = job.Settings().accuracy;
 	bool more_loops;
 	std::vector<bool> finished_sources(size);
+	NodeID sources_per_search = this->GetSourcesPerSearch();
+	std::vector<PathVector> source_paths(sources_per_search);
 
 	do {
 		more_loops = false;
+		NodeID first_searched = 0;
+		NodeID last_searched = 0;
 		for (NodeID source = 0; source < size; ++source) {
 			if (finished_sources[source]) continue;
 
-			/* First saturate the shortest paths. */
-			this->Dijkstra<DistanceAnnotation, GraphEdgeIterator>(source, paths);
+			/* The paths of the next sources are searched at once. Those searches are outdated
+			 * once an edge has been saturated, so then they are discarded and done again. */
+			if (source >= last_searched || this->saturated_edge) {
+				for (NodeID outdated = source; outdated < last_searched; ++outdated) {
+					PathVector &paths = source_paths[outdated - first_searched];
+					if (!paths.empty()) this->CleanupPaths(outdated, paths);
+				}
+
+				/* First saturate the shortest paths. */
+				first_searched = source;
+				last_searched = std::min<NodeID>(source + sources_per_search, size);
+				this->FindPaths<DistanceAnnotation, GraphEdgeIterator>(first_searched, last_searched, finished_sources, source_paths);
+				this->saturated_edge = false;
+			}
 
+			PathVector &paths = source_paths[source - first_searched];
 			Node &src_node = job[source];
 			bool source_demand_left = false;
 			for (NodeID dest = 0; dest < size; ++dest) {
@@ -557,6 +677,8 @@ MCF2ndPass::MCF2ndPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 		for (NodeID source = 0; source < size; ++source) {
 			if (finished_sources[source]) continue;
 
+			/* The capacity annotation compares the free capacity of edges, so any pushed flow
+			 * changes the outcome of the searches. Hence they cannot be done at once here. */
 			this->Dijkstra<CapacityAnnotation, FlowEdgeIterator>(source, paths);
 
 			Node &src_node = job[source];
@@ -597,27 +719,25 @@ bool Greater(T x_anno, T y_anno, NodeID x, NodeID y)
 }
 
 /**
- * Compare two capacity annotations.
+ * Compare two capacity annotations in the open list.
  * @param x First capacity annotation.
  * @param y Second capacity annotation.
- * @return If x is better than y.
+ * @return If x is worse than y, i.e. is to be searched after y.
  */
-bool CapacityAnnotation::Comparator::operator()(const CapacityAnnotation *x,
-		const CapacityAnnotation *y) const
+bool CapacityAnnotation::Comparator::operator()(const AnnotationEntry<int> &x,
+		const AnnotationEntry<int> &y) const
 {
-	return x != y && Greater<int>(x->GetAnnotation(), y->GetAnnotation(),
-			x->GetNode(), y->GetNode());
+	return Greater<int>(y.annotation, x.annotation, y.node, x.node);
 }
 
 /**
- * Compare two distance annotations.
+ * Compare two distance annotations in the open list.
  * @param x First distance annotation.
  * @param y Second distance annotation.
- * @return If x is better than y.
+ * @return If x is worse than y, i.e. is to be searched after y.
  */
-bool DistanceAnnotation::Comparator::operator()(const DistanceAnnotation *x,
-		const DistanceAnnotation *y) const
+bool DistanceAnnotation::Comparator::operator()(const AnnotationEntry<uint> &x,
+		const AnnotationEntry<uint> &y) const
 {
-	return x != y && !Greater<uint>(x->GetAnnotation(), y->GetAnnotation(),
-			x->GetNode(), y->GetNode());
+	return Greater<uint>(x.annotation, y.annotation, x.node, y.node);
 }
@@ -17,18 +17,26 @@ protected:
 	 * @param job Link graph job being executed.
 	 */
 	MultiCommodityFlow(LinkGraphJob &job) : job(job),
-			max_saturation(job.Settings().short_path_saturation)
+			max_saturation(job.Settings().short_path_saturation), saturated_edge(false)
 	{}
 
 	template<class Tannotation, class Tedge_iterator>
 	void Dijkstra(NodeID from, PathVector &paths);
 
+	template<class Tannotation, class Tedge_iterator>
+	void FindPaths(NodeID first, NodeID last, const std::vector<bool> &finished_sources, std::vector<PathVector> &paths);
+
+	NodeID GetSourcesPerSearch() const;
+	uint GetSearchCapacity(const Edge &edge) const;
+	uint GetSaturatingFlow(Path *path) const;
+
 	uint PushFlow(Node &node, NodeID to, Path *path, uint accuracy, uint max_saturation);
 
 	void CleanupPaths(NodeID source, PathVector &paths);
 
 	LinkGraphJob &job;   ///< Job we're working with.
 	uint max_saturation; ///< Maximum saturation for edges.
+	bool saturated_edge; ///< Whether flow has saturated an edge since the last search for paths.
 };
 
 /**
@@ -13,6 +13,8 @@
 #include "water_map.h"
 #include "error_func.h"
 #include "string_func.h"
+#include "pathfinder/rail_junctions.h"
+#include "pathfinder/road_regions.h"
 #include "pathfinder/water_regions.h"
 
 #include "safeguards.h"
@@ -29,8 +31,7 @@ extern "C" _CRTIMP void __cdecl _assert(void *, void *, unsigned);
 /* static */ uint Map::size;      ///< The number of tiles on the map
 /* static */ uint Map::tile_mask; ///< _map_size - 1 (to mask the mapsize)
 
-/* static */ Tile::TileBase *Tile::base_tiles = nullptr;         ///< Base tiles of the map
-/* static */ Tile::TileExtended *Tile::extended_tiles = nullptr; ///< Extended tiles of the map
+/* static */ Tile::TilePlanes Tile::planes = {}; ///< The planes with the data of all tiles of the map
 
 
 /**
@@ -58,13 +59,28 @@ extern "C" _CRTIMP void __cdecl _assert(void *, void *, unsigned);
 	Map::size = size_x * size_y;
 	Map::tile_mask = Map::size - 1;
 
-	free(Tile::base_tiles);
-	free(Tile::extended_tiles);
-
-	Tile::base_tiles = CallocT<Tile::TileBase>(Map::size);
-	Tile::extended_tiles = CallocT<Tile::TileExtended>(Map::size);
+	/* All planes are in one allocation, which starts with the 16 bits planes to keep them aligned. */
+	free(Tile::planes.m2);
+
+	byte *data = CallocT<byte>(static_cast<size_t>(Map::size) * (2 * sizeof(uint16_t) + 8));
+	auto take_plane = [&data](auto *&plane) {
+		plane = reinterpret_cast<std::remove_reference_t<decltype(plane)>>(data);
+		data += static_cast<size_t>(Map::size) * sizeof(*plane);
+	};
+	take_plane(Tile::planes.m2);
+	take_plane(Tile::planes.m8);
+	take_plane(Tile::planes.type);
+	take_plane(Tile::planes.height);
+	take_plane(Tile::planes.m1);
+	take_plane(Tile::planes.m3);
+	take_plane(Tile::planes.m4);
+	take_plane(Tile::planes.m5);
+	take_plane(Tile::planes.m6);
+	take_plane(Tile::planes.m7);
 
 	AllocateWaterRegions();
+	AllocateRailJunctions();
+	AllocateRoadRegions();
 }
 
 
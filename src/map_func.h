@@ -26,33 +26,25 @@ class Tile {
 private:
 	friend struct Map;
 	/**
-	 * Data that is stored per tile. Also used TileExtended for this.
+	 * Data that is stored per tile, with each field of all tiles in a contiguous plane of its own.
+	 * Scans of a single field over the whole map, like the type of the tiles, then only touch the
+	 * memory of that field, and saving and loading a field is a single copy.
 	 * Look at docs/landscape.html for the exact meaning of the members.
 	 */
-	struct TileBase {
-		byte   type;   ///< The type (bits 4..7), bridges (2..3), rainforest/desert (0..1)
-		byte   height; ///< The height of the northern corner.
-		uint16_t m2;     ///< Primarily used for indices to towns, industries and stations
-		byte   m1;     ///< Primarily used for ownership information
-		byte   m3;     ///< General purpose
-		byte   m4;     ///< General purpose
-		byte   m5;     ///< General purpose
+	struct TilePlanes {
+		byte     *type;   ///< The type (bits 4..7), bridges (2..3), rainforest/desert (0..1)
+		byte     *height; ///< The height of the northern corner.
+		uint16_t *m2;     ///< Primarily used for indices to towns, industries and stations
+		byte     *m1;     ///< Primarily used for ownership information
+		byte     *m3;     ///< General purpose
+		byte     *m4;     ///< General purpose
+		byte     *m5;     ///< General purpose
+		byte     *m6;     ///< General purpose
+		byte     *m7;     ///< Primarily used for newgrf support
+		uint16_t *m8;     ///< General purpose
 	};
 
-	static_assert(sizeof(TileBase) == 8);
-
-	/**
-	 * Data that is stored per tile. Also used TileBase for this.
-	 * Look at docs/landscape.html for the exact meaning of the members.
-	 */
-	struct TileExtended {
-		byte m6;   ///< General purpose
-		byte m7;   ///< Primarily used for newgrf support
-		uint16_t m8; ///< General purpose
-	};
-
-	static TileBase *base_tiles;         ///< Pointer to the tile-array.
-	static TileExtended *extended_tiles; ///< Pointer to the extended tile-array.
+	static TilePlanes planes; ///< The planes with the data of all tiles.
 
 	TileIndex tile; ///< The tile to access the map data for.
 
@@ -69,6 +61,15 @@ public:
 	 */
 	Tile(uint tile) : tile(tile) {}
 
+	/**
+	 * Get the planes with the data of all tiles, e.g. to save or load a field of all tiles at once.
+	 * @return The planes.
+	 */
+	static const TilePlanes &GetPlanes()
+	{
+		return planes;
+	}
+
 	/**
 	 * Implicit conversion to the TileIndex.
 	 */
@@ -88,7 +89,7 @@ public:
 	 */
 	debug_inline byte &type()
 	{
-		return base_tiles[tile.base()].type;
+		return planes.type[tile.base()];
 	}
 
 	/**
@@ -100,7 +101,7 @@ public:
 	 */
 	debug_inline byte &height()
 	{
-		return base_tiles[tile.base()].height;
+		return planes.height[tile.base()];
 	}
 
 	/**
@@ -112,7 +113,7 @@ public:
 	 */
 	debug_inline byte &m1()
 	{
-		return base_tiles[tile.base()].m1;
+		return planes.m1[tile.base()];
 	}
 
 	/**
@@ -124,7 +125,7 @@ public:
 	 */
 	debug_inline uint16_t &m2()
 	{
-		return base_tiles[tile.base()].m2;
+		return planes.m2[tile.base()];
 	}
 
 	/**
@@ -136,7 +137,7 @@ public:
 	 */
 	debug_inline byte &m3()
 	{
-		return base_tiles[tile.base()].m3;
+		return planes.m3[tile.base()];
 	}
 
 	/**
@@ -148,7 +149,7 @@ public:
 	 */
 	debug_inline byte &m4()
 	{
-		return base_tiles[tile.base()].m4;
+		return planes.m4[tile.base()];
 	}
 
 	/**
@@ -160,7 +161,7 @@ public:
 	 */
 	debug_inline byte &m5()
 	{
-		return base_tiles[tile.base()].m5;
+		return planes.m5[tile.base()];
 	}
 
 	/**
@@ -172,7 +173,7 @@ public:
 	 */
 	debug_inline byte &m6()
 	{
-		return extended_tiles[tile.base()].m6;
+		return planes.m6[tile.base()];
 	}
 
 	/**
@@ -184,7 +185,7 @@ public:
 	 */
 	debug_inline byte &m7()
 	{
-		return extended_tiles[tile.base()].m7;
+		return planes.m7[tile.base()];
 	}
 
 	/**
@@ -196,7 +197,7 @@ public:
 	 */
 	debug_inline uint16_t &m8()
 	{
-		return extended_tiles[tile.base()].m8;
+		return planes.m8[tile.base()];
 	}
 };
 
@@ -353,7 +354,7 @@ public:
 	 */
 	static bool IsInitialized()
 	{
-		return Tile::base_tiles != nullptr;
+		return Tile::planes.type != nullptr;
 	}
 
 	/**
@@ -58,20 +58,22 @@ INSTANTIATE_POOL_METHODS(NetworkClientSocket)
 /** Instantiate the listen sockets. */
 template SocketList TCPListenHandler<ServerNetworkGameSocketHandler, PACKET_SERVER_FULL, PACKET_SERVER_BANNED>::sockets;
 
-/** Writing a savegame directly to a number of packets. */
+/**
+ * Writing a savegame directly to a number of packets. The packets are kept
+ * until every client that downloads this savegame has received them, so
+ * clients that start joining at the same time can share one savegame.
+ */
 struct PacketWriter : SaveFilter {
-	ServerNetworkGameSocketHandler *cs; ///< Socket we are associated with.
-	std::unique_ptr<Packet> current; ///< The packet we're currently writing to.
+	uint clients;                       ///< Number of clients still downloading this savegame.
+	std::unique_ptr<Packet> current;    ///< The packet we're currently writing to.
 	size_t total_size;                  ///< Total size of the compressed savegame.
-	std::deque<std::unique_ptr<Packet>> packets; ///< Packet queue of the savegame; send these "slowly" to the client. Cannot be a std::queue as we want to push the map size packet in front of the data packets.
+	bool finished;                      ///< Whether the whole savegame has been written.
+	std::vector<std::unique_ptr<Packet>> packets; ///< Packets of the savegame; copies of these are sent "slowly" to each client.
 	std::mutex mutex;                   ///< Mutex for making threaded saving safe.
 	std::condition_variable exit_sig;   ///< Signal for threaded destruction of this packet writer.
 
-	/**
-	 * Create the packet writer.
-	 * @param cs The socket handler we're making the packets for.
-	 */
-	PacketWriter(ServerNetworkGameSocketHandler *cs) : SaveFilter(nullptr), cs(cs), total_size(0)
+	/** Create the packet writer. */
+	PacketWriter() : SaveFilter(nullptr), clients(0), total_size(0), finished(false)
 	{
 	}
 
@@ -80,30 +82,38 @@ struct PacketWriter : SaveFilter {
 	{
 		std::unique_lock<std::mutex> lock(this->mutex);
 
-		if (this->cs != nullptr) this->exit_sig.wait(lock);
-
-		/* This must all wait until the Destroy function is called. */
+		/* This must all wait until the Destroy function is called for all clients. */
+		this->exit_sig.wait(lock, [this]() { return this->clients == 0; });
 
 		Debug(net, 0, "Destruct!");
 		this->packets.clear();
 		this->current = nullptr;
 	}
 
+	/** Register another client that is going to download this savegame. */
+	void AddClient()
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->clients++;
+	}
+
 	/**
-	 * Begin the destruction of this packet writer. It can happen in two ways:
-	 * in the first case the client disconnected while saving the map. In this
-	 * case the saving has not finished and killed this PacketWriter. In that
-	 * case we simply set cs to nullptr, triggering the appending to fail due to
-	 * the connection problem and eventually triggering the destructor. In the
-	 * second case the destructor is already called, and it is waiting for our
-	 * signal which we will send. Only then the packets will be removed by the
+	 * Stop sending this packet writer to one of its clients. When this was the
+	 * last client, begin the destruction of this packet writer. It can happen in
+	 * two ways: in the first case the clients disconnected while saving the map.
+	 * In this case the saving has not finished and killed this PacketWriter. In
+	 * that case we simply have no clients anymore, triggering the appending to
+	 * fail due to the connection problem and eventually triggering the destructor.
+	 * In the second case the destructor is already called, and it is waiting for
+	 * our signal which we will send. Only then the packets will be removed by the
 	 * destructor.
 	 */
 	void Destroy()
 	{
 		std::unique_lock<std::mutex> lock(this->mutex);
 
-		this->cs = nullptr;
+		assert(this->clients > 0);
+		if (--this->clients != 0) return;
 
 		this->exit_sig.notify_all();
 		lock.unlock();
@@ -115,22 +125,27 @@ struct PacketWriter : SaveFilter {
 	}
 
 	/**
-	 * Transfer all packets from here to the network's queue while holding
-	 * the lock on our mutex.
+	 * Transfer copies of the packets the socket has not received yet to the
+	 * network's queue while holding the lock on our mutex.
 	 * @param socket The network socket to write to.
 	 * @return True iff the last packet of the map has been sent.
 	 */
 	bool TransferToNetworkQueue(ServerNetworkGameSocketHandler *socket)
 	{
-		/* Unsafe check for the queue being empty or not. */
-		if (this->packets.empty()) return false;
-
 		std::lock_guard<std::mutex> lock(this->mutex);
 
-		while (!this->packets.empty()) {
-			bool last_packet = this->packets.front()->GetPacketType() == PACKET_SERVER_MAP_DONE;
-			socket->SendPacket(std::move(this->packets.front()));
-			this->packets.pop_front();
+		/* Fast-track the size to the client as soon as it is known. */
+		if (this->finished && !socket->savegame_size_sent) {
+			auto p = std::make_unique<Packet>(PACKET_SERVER_MAP_SIZE);
+			p->Send_uint32((uint32_t)this->total_size);
+			socket->SendPacket(std::move(p));
+			socket->savegame_size_sent = true;
+		}
+
+		while (socket->savegame_packets_sent < this->packets.size()) {
+			const Packet &packet = *this->packets[socket->savegame_packets_sent++];
+			bool last_packet = packet.GetPacketType() == PACKET_SERVER_MAP_DONE;
+			socket->SendPacket(std::make_unique<Packet>(packet));
 
 			if (last_packet) return true;
 		}
@@ -140,12 +155,12 @@ struct PacketWriter : SaveFilter {
 
 	void Write(byte *buf, size_t size) override
 	{
-		/* We want to abort the saving when the socket is closed. */
-		if (this->cs == nullptr) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
+		std::lock_guard<std::mutex> lock(this->mutex);
 
-		if (this->current == nullptr) this->current = std::make_unique<Packet>(PACKET_SERVER_MAP_DATA, TCP_MTU);
+		/* We want to abort the saving when all sockets are closed. */
+		if (this->clients == 0) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
 
-		std::lock_guard<std::mutex> lock(this->mutex);
+		if (this->current == nullptr) this->current = std::make_unique<Packet>(PACKET_SERVER_MAP_DATA, TCP_MTU);
 
 		byte *bufe = buf + size;
 		while (buf != bufe) {
@@ -163,21 +178,18 @@ struct PacketWriter : SaveFilter {
 
 	void Finish() override
 	{
-		/* We want to abort the saving when the socket is closed. */
-		if (this->cs == nullptr) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
-
 		std::lock_guard<std::mutex> lock(this->mutex);
 
+		/* We want to abort the saving when all sockets are closed. */
+		if (this->clients == 0) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
+
 		/* Make sure the last packet is flushed. */
 		if (this->current != nullptr) this->packets.push_back(std::move(this->current));
 
 		/* Add a packet stating that this is the end to the queue. */
 		this->packets.push_back(std::make_unique<Packet>(PACKET_SERVER_MAP_DONE));
 
-		/* Fast-track the size to the client. */
-		auto p = std::make_unique<Packet>(PACKET_SERVER_MAP_SIZE);
-		p->Send_uint32((uint32_t)this->total_size);
-		this->packets.push_front(std::move(p));
+		this->finished = true;
 	}
 };
 
@@ -191,6 +203,8 @@ ServerNetworkGameSocketHandler::ServerNetworkGameSocketHandler(SOCKET s) : Netwo
 	this->status = STATUS_INACTIVE;
 	this->client_id = _network_client_id++;
 	this->receive_limit = _settings_client.network.bytes_per_frame_burst;
+	this->savegame_packets_sent = 0;
+	this->savegame_size_sent = false;
 
 	Debug(net, 9, "client[{}] status = INACTIVE", this->client_id);
 
@@ -536,7 +550,7 @@ void ServerNetworkGameSocketHandler::CheckNextClientToSendMap(NetworkClientSocke
 
 	/* Is there someone else to join? */
 	if (best != nullptr) {
-		/* Let the first start joining. */
+		/* Let the first start joining; the others that are waiting join along. */
 		best->status = STATUS_AUTHORIZED;
 		best->SendMap();
 
@@ -547,6 +561,32 @@ void ServerNetworkGameSocketHandler::CheckNextClientToSendMap(NetworkClientSocke
 	}
 }
 
+/**
+ * Start sending the given savegame to this client.
+ * @param savegame The writer of the savegame that is about to be made.
+ */
+void ServerNetworkGameSocketHandler::StartMapTransfer(std::shared_ptr<PacketWriter> savegame)
+{
+	Debug(net, 9, "client[{}] StartMapTransfer()", this->client_id);
+
+	this->savegame = savegame;
+	this->savegame->AddClient();
+	this->savegame_packets_sent = 0;
+	this->savegame_size_sent = false;
+
+	/* Now send the _frame_counter and how many packets are coming */
+	auto p = std::make_unique<Packet>(PACKET_SERVER_MAP_BEGIN);
+	p->Send_uint32(_frame_counter);
+	this->SendPacket(std::move(p));
+
+	NetworkSyncCommandQueue(this);
+	Debug(net, 9, "client[{}] status = MAP", this->client_id);
+	this->status = STATUS_MAP;
+	/* Mark the start of download */
+	this->last_frame = _frame_counter;
+	this->last_frame_server = _frame_counter;
+}
+
 /** This sends the map to the client */
 NetworkRecvStatus ServerNetworkGameSocketHandler::SendMap()
 {
@@ -559,22 +599,18 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendMap()
 		Debug(net, 9, "client[{}] SendMap(): first_packet", this->client_id);
 
 		WaitTillSaved();
-		this->savegame = std::make_shared<PacketWriter>(this);
-
-		/* Now send the _frame_counter and how many packets are coming */
-		auto p = std::make_unique<Packet>(PACKET_SERVER_MAP_BEGIN);
-		p->Send_uint32(_frame_counter);
-		this->SendPacket(std::move(p));
+		std::shared_ptr<PacketWriter> savegame = std::make_shared<PacketWriter>();
 
-		NetworkSyncCommandQueue(this);
-		Debug(net, 9, "client[{}] status = MAP", this->client_id);
-		this->status = STATUS_MAP;
-		/* Mark the start of download */
-		this->last_frame = _frame_counter;
-		this->last_frame_server = _frame_counter;
+		/* All clients that are waiting for the map get the same dump, as they
+		 * all start at this frame. That way joining does not take longer for
+		 * every client that is queued in front of you. */
+		this->StartMapTransfer(savegame);
+		for (NetworkClientSocket *new_cs : NetworkClientSocket::Iterate()) {
+			if (new_cs->status == STATUS_MAP_WAIT) new_cs->StartMapTransfer(savegame);
+		}
 
 		/* Make a dump of the current game */
-		if (SaveWithFilter(this->savegame, true) != SL_OK) UserError("network savedump failed");
+		if (SaveWithFilter(savegame, true) != SL_OK) UserError("network savedump failed");
 	}
 
 	if (this->status == STATUS_MAP) {
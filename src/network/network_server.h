@@ -70,6 +70,8 @@ public:
 	size_t receive_limit;        ///< Amount of bytes that we can receive at this moment
 
 	std::shared_ptr<struct PacketWriter> savegame; ///< Writer used to write the savegame.
+	size_t savegame_packets_sent;  ///< Number of packets of the savegame that have been sent to this client.
+	bool savegame_size_sent;       ///< Whether the size of the savegame has been sent to this client.
 	NetworkAddress client_address; ///< IP-address of the client (so they can be banned)
 
 	ServerNetworkGameSocketHandler(SOCKET s);
@@ -80,6 +82,7 @@ public:
 	std::string GetClientName() const;
 
 	void CheckNextClientToSendMap(NetworkClientSocket *ignore_cs = nullptr);
+	void StartMapTransfer(std::shared_ptr<struct PacketWriter> savegame);
 
 	NetworkRecvStatus SendWait();
 	NetworkRecvStatus SendMap();
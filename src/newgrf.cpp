@@ -49,6 +49,9 @@
 #include "vehicle_base.h"
 #include "road.h"
 #include "newgrf_roadstop.h"
+#include "newgrf_callback_cache.h"
+#include "newgrf_scan_cache.h"
+#include "worker_pool.h"
 
 #include "table/strings.h"
 #include "table/build_industry.h"
@@ -5320,6 +5323,7 @@ static void NewSpriteGroup(ByteReader *buf)
 				}
 			}
 
+			group->Compile();
 			break;
 		}
 
@@ -8866,6 +8870,7 @@ void ResetNewGRFData()
 	_grf_id_overrides.clear();
 
 	InitializeSoundPool();
+	ClearNewGRFCallbackCache();
 	_spritegroup_pool.CleanPool();
 }
 
@@ -9623,6 +9628,90 @@ static void DecodeSpecialSprite(byte *buf, uint num, GrfLoadingStage stage)
 	}
 }
 
+/** The scans of the NewGRFs that are being loaded by #LoadNewGRF. */
+static std::vector<GRFFileScan> _grf_file_scans;
+
+/**
+ * Scan a NewGRF file for its sprite offsets and the positions of its real sprites.
+ * This only reads the file with its own file handle, so it can be run on a worker thread.
+ * @param scan The scan to fill; the NewGRF and its sub directory are already set.
+ */
+static void ScanNewGRFFile(GRFFileScan &scan)
+{
+	SpriteFile file(scan.config->filename, scan.subdir, false);
+
+	byte grf_container_version = file.GetContainerVersion();
+	if (grf_container_version == 0) return;
+
+	ScanGRFSpriteOffsets(file, scan.sprite_offsets);
+	if (grf_container_version >= 2 && file.ReadByte() != 0) return;
+
+	uint32_t num = grf_container_version >= 2 ? file.ReadDword() : file.ReadWord();
+	if (num != 4 || file.ReadByte() != 0xFF) return;
+	file.ReadDword();
+	scan.scanned = true;
+
+	/* Walk the records the same way LoadNewGRFFileFromFile skips them. */
+	while ((num = (grf_container_version >= 2 ? file.ReadDword() : file.ReadWord())) != 0) {
+		byte type = file.ReadByte();
+		if (type == 0xFF || (grf_container_version >= 2 && type == 0xFD)) {
+			file.SkipBytes(num);
+			continue;
+		}
+
+		size_t begin = file.GetPos();
+		file.SkipBytes(7);
+		if (SkipSpriteData(file, type, num - 8)) scan.real_sprites.emplace_back(begin, file.GetPos());
+	}
+}
+
+/**
+ * Get the scan of a NewGRF that is being loaded.
+ * @param config The configuration of the NewGRF.
+ * @param subdir The sub directory the NewGRF is loaded from.
+ * @return The scan, or \c nullptr when the NewGRF has not been scanned.
+ */
+static const GRFFileScan *GetNewGRFFileScan(const GRFConfig *config, Subdirectory subdir)
+{
+	for (const GRFFileScan &scan : _grf_file_scans) {
+		if (scan.config == config) return (scan.scanned && scan.subdir == subdir) ? &scan : nullptr;
+	}
+	return nullptr;
+}
+
+/**
+ * Scan all NewGRFs that are going to be loaded and are not in the scan cache on the worker threads.
+ * The loading stages themselves have to go through the NewGRFs one by one, in order,
+ * as each can depend on what the NewGRFs before it did; the scans do not.
+ * @param num_baseset Number of NewGRFs at the front of the list to look up in the baseset dir instead of the newgrf dir.
+ */
+static void ScanNewGRFFiles(uint num_baseset)
+{
+	_grf_file_scans.clear();
+
+	uint num_grfs = 0;
+	for (const GRFConfig *c = _grfconfig; c != nullptr; c = c->next) {
+		if (c->status == GCS_DISABLED || c->status == GCS_NOT_FOUND) continue;
+
+		Subdirectory subdir = num_grfs < num_baseset ? BASESET_DIR : NEWGRF_DIR;
+		if (!FioCheckFileExists(c->filename, subdir)) continue;
+		num_grfs++;
+
+		_grf_file_scans.emplace_back(c, subdir);
+	}
+
+	std::vector<GRFFileScan *> to_scan;
+	for (GRFFileScan &scan : _grf_file_scans) {
+		if (!LoadCachedGRFFileScan(scan)) to_scan.push_back(&scan);
+	}
+
+	ParallelFor(to_scan.size(), [&to_scan](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) ScanNewGRFFile(*to_scan[i]);
+	});
+
+	CacheGRFFileScans(_grf_file_scans);
+}
+
 /**
  * Load a particular NewGRF from a SpriteFile.
  * @param config The configuration of the to be loaded NewGRF.
@@ -9631,6 +9720,8 @@ static void DecodeSpecialSprite(byte *buf, uint num, GrfLoadingStage stage)
  */
 static void LoadNewGRFFileFromFile(GRFConfig *config, GrfLoadingStage stage, SpriteFile &file)
 {
+	const GRFFileScan *scan = GetNewGRFFileScan(config, file.GetSubdirectory());
+
 	_cur.file = &file;
 	_cur.grfconfig = config;
 
@@ -9645,7 +9736,7 @@ static void LoadNewGRFFileFromFile(GRFConfig *config, GrfLoadingStage stage, Spr
 	if (stage == GLS_INIT || stage == GLS_ACTIVATION) {
 		/* We need the sprite offsets in the init stage for NewGRF sounds
 		 * and in the activation stage for real sprites. */
-		ReadGRFSpriteOffsets(file);
+		ReadGRFSpriteOffsets(file, scan != nullptr ? &scan->sprite_offsets : nullptr);
 	} else {
 		/* Skip sprite section offset if present. */
 		if (grf_container_version >= 2) file.ReadDword();
@@ -9700,6 +9791,9 @@ static void LoadNewGRFFileFromFile(GRFConfig *config, GrfLoadingStage stage, Spr
 			if (grf_container_version >= 2 && type == 0xFD) {
 				/* Reference to data section. Container version >= 2 only. */
 				file.SkipBytes(num);
+			} else if (size_t end = scan != nullptr ? scan->GetRealSpriteEnd(file.GetPos()) : SIZE_MAX; end != SIZE_MAX) {
+				/* Already decoded by the scan, so jump to its end. */
+				file.SeekTo(end, SEEK_SET);
 			} else {
 				file.SkipBytes(7);
 				SkipSpriteData(file, type, num - 8);
@@ -10087,6 +10181,13 @@ void LoadNewGRF(uint load_index, uint num_baseset)
 
 	_cur.spriteid = load_index;
 
+	auto start = std::chrono::steady_clock::now();
+	ScanNewGRFFiles(num_baseset);
+	auto stage_start = std::chrono::steady_clock::now();
+	Debug(grf, 1, "LoadNewGRF: Scanned {} NewGRFs ({} from the cache) in {} ms using {} threads", _grf_file_scans.size(),
+			std::count_if(_grf_file_scans.begin(), _grf_file_scans.end(), [](const GRFFileScan &scan) { return scan.cached; }),
+			std::chrono::duration_cast<std::chrono::milliseconds>(stage_start - start).count(), GetWorkerThreadCount());
+
 	/* Load newgrf sprites
 	 * in each loading stage, (try to) open each file specified in the config
 	 * and load information from it. */
@@ -10151,10 +10252,17 @@ void LoadNewGRF(uint load_index, uint num_baseset)
 				ClearTemporaryNewGRFData(_cur.grffile);
 			}
 		}
+
+		auto now = std::chrono::steady_clock::now();
+		Debug(grf, 1, "LoadNewGRF: Stage {} took {} ms", stage, std::chrono::duration_cast<std::chrono::milliseconds>(now - stage_start).count());
+		stage_start = now;
 	}
 
 	/* Pseudo sprite processing is finished; free temporary stuff */
 	_cur.ClearDataForNextFile();
+	_grf_file_scans.clear();
+	_grf_file_scans.shrink_to_fit();
+	Debug(grf, 1, "LoadNewGRF: Loaded all NewGRFs in {} ms", std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
 
 	/* Call any functions that should be run after GRFs have been loaded. */
 	AfterLoadGRFs();
@@ -0,0 +1,256 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file newgrf_callback_cache.cpp Memoisation of the results of NewGRF callbacks.
+ *
+ * While a callback is resolved, the variables it reads and the registers it stores
+ * into are recorded. The next time the same callback is resolved with the same
+ * parameters, the recorded variables are read again; when they all still have the
+ * same value, the callback takes the same path through its sprite groups, so the
+ * recorded stores and result are used instead of resolving the callback again.
+ * Callbacks with effects that can not be replayed, like storing into persistent
+ * storage, are not cached.
+ */
+
+#include "stdafx.h"
+#include "newgrf_callback_cache.h"
+#include "newgrf_profiling.h"
+
+#include <chrono>
+#include <unordered_map>
+
+#include "safeguards.h"
+
+extern TemporaryStorageArray<int32_t, 0x110> _temp_store;
+
+static const size_t CALLBACK_CACHE_MAX_ENTRIES = 1 << 16; ///< Number of cached results after which the cache is emptied.
+static const size_t CALLBACK_TRACE_MAX_EVENTS = 64;       ///< Maximum number of events of a cached callback; checking longer ones is hardly faster than resolving them.
+
+/** Something a callback did that determines what it does afterwards. */
+struct NewGRFCallbackEvent {
+	bool store;                ///< Whether a register was stored into, instead of a variable read.
+	bool available;            ///< Whether the variable was available.
+	VarSpriteGroupScope scope; ///< Scope of the variable.
+	byte relative;             ///< Relative position of the scope of the variable.
+	byte variable;             ///< The variable.
+	uint32_t parameter;        ///< Parameter of the variable, or the register that was stored into.
+	uint32_t value;            ///< Value of the variable, or the value that was stored.
+};
+
+/** Recording of the events of a callback while it is resolved. */
+struct NewGRFCallbackTrace {
+	const ResolverObject *object;             ///< Resolver of the callback.
+	std::vector<NewGRFCallbackEvent> events;  ///< Events so far.
+	bool cacheable = true;                    ///< Whether the result may be cached.
+};
+
+/** Identification of the cached result of a callback. */
+struct NewGRFCallbackKey {
+	const SpriteGroup *root;  ///< Root sprite group of the callback.
+	const GRFFile *grffile;   ///< NewGRF of the callback.
+	CallbackID callback;      ///< The callback.
+	uint32_t param1;          ///< First parameter of the callback.
+	uint32_t param2;          ///< Second parameter of the callback.
+
+	bool operator==(const NewGRFCallbackKey &other) const = default;
+};
+
+/** Hash of #NewGRFCallbackKey. */
+struct NewGRFCallbackKeyHash {
+	size_t operator()(const NewGRFCallbackKey &key) const
+	{
+		size_t hash = std::hash<const void *>{}(key.root);
+		hash = hash * 31 + std::hash<const void *>{}(key.grffile);
+		hash = hash * 31 + key.callback;
+		hash = hash * 31 + key.param1;
+		return hash * 31 + key.param2;
+	}
+};
+
+/** Cached result of a callback. */
+struct NewGRFCallbackEntry {
+	std::vector<NewGRFCallbackEvent> events; ///< The events that lead to the result.
+	uint16_t result;                          ///< Result of the callback.
+	uint32_t last_value;                      ///< Last value of the resolver after the callback.
+	uint32_t resolve_time;                    ///< Time resolving the callback took (nanoseconds).
+};
+
+bool _cache_newgrf_callbacks = false; ///< Whether the results of callbacks are memoised at all; see #IsMemoisedCallback.
+NewGRFCallbackTrace *_newgrf_callback_trace = nullptr; ///< Recording of the callback that is being resolved, if it is memoised.
+static std::unordered_map<NewGRFCallbackKey, NewGRFCallbackEntry, NewGRFCallbackKeyHash> _newgrf_callback_cache;
+
+/**
+ * Check whether the results of a callback are memoised.
+ * These are callbacks that are resolved often, mostly for the same objects over and over again.
+ * Memoising is off unless enabled by the cache_newgrf_callbacks setting: a cached result is only
+ * right as long as every input of the callback is recorded, and a missed input makes clients
+ * with and without the result in their cache disagree.
+ * @param callback The callback.
+ * @return True iff the results of the callback are cached.
+ */
+bool IsMemoisedCallback(CallbackID callback)
+{
+	if (!_cache_newgrf_callbacks) return false;
+
+	switch (callback) {
+		case CBID_STATION_SPRITE_LAYOUT:
+		case CBID_VEHICLE_REFIT_CAPACITY:
+		case CBID_HOUSE_ACCEPT_CARGO:
+		case CBID_VEHICLE_MODIFY_PROPERTY:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+/**
+ * Record a read of a variable by the callback that is being memoised.
+ * @param object Resolver that read the variable.
+ * @param scope Scope of the variable.
+ * @param relative Relative position of the scope.
+ * @param variable The variable.
+ * @param parameter Parameter of the variable.
+ * @param value Value of the variable.
+ * @param available Whether the variable was available.
+ */
+void TraceCallbackRead(const ResolverObject &object, VarSpriteGroupScope scope, byte relative, byte variable, uint32_t parameter, uint32_t value, bool available)
+{
+	NewGRFCallbackTrace *trace = _newgrf_callback_trace;
+	if (&object != trace->object || !trace->cacheable) return;
+
+	if (trace->events.size() >= CALLBACK_TRACE_MAX_EVENTS) {
+		trace->cacheable = false;
+		return;
+	}
+	trace->events.push_back({ false, available, scope, relative, variable, parameter, value });
+}
+
+/**
+ * Record a store into a register by the callback that is being memoised.
+ * @param object Resolver that stored into the register.
+ * @param pos The register.
+ * @param value The value.
+ */
+void TraceCallbackStore(const ResolverObject &object, uint pos, int32_t value)
+{
+	NewGRFCallbackTrace *trace = _newgrf_callback_trace;
+	if (&object != trace->object || !trace->cacheable) return;
+
+	if (trace->events.size() >= CALLBACK_TRACE_MAX_EVENTS) {
+		trace->cacheable = false;
+		return;
+	}
+	trace->events.push_back({ true, true, VSG_SCOPE_SELF, 0, 0, pos, (uint32_t)value });
+}
+
+/**
+ * Mark the callback that is being memoised as not cacheable, as something happened that can not be replayed.
+ * @param object Resolver that did it.
+ */
+void TraceCallbackUncacheable([[maybe_unused]] const ResolverObject &object)
+{
+	_newgrf_callback_trace->cacheable = false;
+}
+
+/**
+ * Record the start of resolving a chain of sprite groups while a memoised callback is resolved.
+ * @param object Resolver of the chain; other resolvers than the one of the callback change its registers.
+ */
+void TraceCallbackResolve(const ResolverObject &object)
+{
+	if (&object != _newgrf_callback_trace->object) _newgrf_callback_trace->cacheable = false;
+}
+
+/**
+ * Check whether a cached result is still the result of a callback, by checking the variables it read.
+ * When the result is valid, the registers are set as the callback would have set them.
+ * @param object Resolver of the callback.
+ * @param entry The cached result.
+ * @return True iff the cached result is valid.
+ */
+static bool ValidateCallbackEntry(ResolverObject &object, const NewGRFCallbackEntry &entry)
+{
+	/* Detect resolvers of other objects that change the registers while reading the variables. */
+	NewGRFCallbackTrace trace{ &object, {}, true };
+	_newgrf_callback_trace = &trace;
+
+	bool valid = true;
+	_temp_store.ClearChanges();
+	for (const NewGRFCallbackEvent &event : entry.events) {
+		if (event.store) {
+			_temp_store.StoreValue(event.parameter, (int32_t)event.value);
+			continue;
+		}
+
+		bool available = true;
+		uint32_t value = GetScopeVariable(object, event.scope, event.relative, event.variable, event.parameter, &available);
+		if (value != event.value || available != event.available || !trace.cacheable) {
+			valid = false;
+			break;
+		}
+	}
+
+	_newgrf_callback_trace = nullptr;
+	return valid;
+}
+
+/**
+ * Resolve a callback, using the cached result of the previous time it was resolved with the same parameters when that is still valid.
+ * @param object Resolver of the callback.
+ * @return The result of the callback.
+ */
+uint16_t ResolveMemoisedCallback(ResolverObject &object)
+{
+	if (_newgrf_callback_trace != nullptr) {
+		/* Resolved while resolving another callback; it changes the registers of that callback. */
+		TraceCallbackUncacheable(object);
+		const SpriteGroup *result = object.Resolve();
+		return result != nullptr ? result->GetCallbackResult() : CALLBACK_FAILED;
+	}
+
+	using namespace std::chrono;
+	auto profiler = std::find_if(_newgrf_profilers.begin(), _newgrf_profilers.end(), [&](const NewGRFProfiler &pr) { return pr.grffile == object.grffile && pr.active; });
+	bool profiling = profiler != _newgrf_profilers.end();
+
+	NewGRFCallbackKey key{ object.root_spritegroup, object.grffile, object.callback, object.callback_param1, object.callback_param2 };
+	auto start = high_resolution_clock::now();
+	auto it = _newgrf_callback_cache.find(key);
+	if (it != _newgrf_callback_cache.end() && ValidateCallbackEntry(object, it->second)) {
+		object.last_value = it->second.last_value;
+		if (profiling) {
+			uint32_t time = (uint32_t)duration_cast<nanoseconds>(high_resolution_clock::now() - start).count();
+			profiler->CallbackCacheLookup(object.callback, true, it->second.resolve_time > time ? it->second.resolve_time - time : 0);
+		}
+		return it->second.result;
+	}
+
+	NewGRFCallbackTrace trace{ &object, {}, true };
+	_newgrf_callback_trace = &trace;
+	start = high_resolution_clock::now();
+	const SpriteGroup *group = object.Resolve();
+	uint32_t resolve_time = (uint32_t)duration_cast<nanoseconds>(high_resolution_clock::now() - start).count();
+	_newgrf_callback_trace = nullptr;
+
+	uint16_t result = group != nullptr ? group->GetCallbackResult() : CALLBACK_FAILED;
+	if (profiling) profiler->CallbackCacheLookup(object.callback, false, 0);
+
+	if (trace.cacheable) {
+		if (_newgrf_callback_cache.size() >= CALLBACK_CACHE_MAX_ENTRIES) _newgrf_callback_cache.clear();
+		_newgrf_callback_cache[key] = { std::move(trace.events), result, object.last_value, resolve_time };
+	}
+	return result;
+}
+
+/**
+ * Remove all cached callback results; for when the sprite groups are freed.
+ */
+void ClearNewGRFCallbackCache()
+{
+	_newgrf_callback_cache.clear();
+}
@@ -0,0 +1,28 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file newgrf_callback_cache.h Memoisation of the results of NewGRF callbacks. */
+
+#ifndef NEWGRF_CALLBACK_CACHE_H
+#define NEWGRF_CALLBACK_CACHE_H
+
+#include "newgrf_spritegroup.h"
+
+struct NewGRFCallbackTrace;
+extern bool _cache_newgrf_callbacks;
+extern NewGRFCallbackTrace *_newgrf_callback_trace;
+
+bool IsMemoisedCallback(CallbackID callback);
+uint16_t ResolveMemoisedCallback(ResolverObject &object);
+void ClearNewGRFCallbackCache();
+
+void TraceCallbackRead(const ResolverObject &object, VarSpriteGroupScope scope, byte relative, byte variable, uint32_t parameter, uint32_t value, bool available);
+void TraceCallbackStore(const ResolverObject &object, uint pos, int32_t value);
+void TraceCallbackUncacheable(const ResolverObject &object);
+void TraceCallbackResolve(const ResolverObject &object);
+
+#endif /* NEWGRF_CALLBACK_CACHE_H */
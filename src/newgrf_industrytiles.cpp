@@ -349,6 +349,11 @@ static void DoReseedIndustry(Industry *ind, uint32_t reseed)
 	uint16_t random_bits = Random();
 	ind->random &= reseed;
 	ind->random |= random_bits & reseed;
+
+	/* The random bits of the industry can be used by the graphics of all its tiles, so their cached draw lists are stale. */
+	for (TileIndex tile : ind->location) {
+		if (ind->TileBelongsToIndustry(tile)) InvalidateTileDrawCache(tile);
+	}
 }
 
 /**
@@ -47,7 +47,9 @@ void NewGRFProfiler::BeginResolve(const ResolverObject &resolver)
 	using namespace std::chrono;
 	this->cur_call.root_sprite = resolver.root_spritegroup->nfo_line;
 	this->cur_call.subs = 0;
-	this->cur_call.time = (uint32_t)time_point_cast<microseconds>(high_resolution_clock::now()).time_since_epoch().count();
+	/* Alternate between the compiled and interpreted action 2, to compare their performance. */
+	this->cur_call.compiled = this->calls.size() % 2 == 0;
+	this->cur_call.time = (uint32_t)time_point_cast<nanoseconds>(high_resolution_clock::now()).time_since_epoch().count();
 	this->cur_call.tick = TimerGameTick::counter;
 	this->cur_call.cb = resolver.callback;
 	this->cur_call.feat = resolver.GetFeature();
@@ -60,7 +62,7 @@ void NewGRFProfiler::BeginResolve(const ResolverObject &resolver)
 void NewGRFProfiler::EndResolve(const SpriteGroup *result)
 {
 	using namespace std::chrono;
-	this->cur_call.time = (uint32_t)time_point_cast<microseconds>(high_resolution_clock::now()).time_since_epoch().count() - this->cur_call.time;
+	this->cur_call.time = (uint32_t)time_point_cast<nanoseconds>(high_resolution_clock::now()).time_since_epoch().count() - this->cur_call.time;
 
 	if (result == nullptr) {
 		this->cur_call.result = 0;
@@ -83,6 +85,23 @@ void NewGRFProfiler::RecursiveResolve()
 	this->cur_call.subs += 1;
 }
 
+/**
+ * Capture the lookup of a memoised callback.
+ * @param cb The callback.
+ * @param hit Whether the result was taken from the cache.
+ * @param saved Estimate of the time saved by taking the result from the cache (nanoseconds).
+ */
+void NewGRFProfiler::CallbackCacheLookup(CallbackID cb, bool hit, uint32_t saved)
+{
+	CacheUse &use = this->cache_use[cb];
+	if (hit) {
+		use.hits++;
+		use.saved += saved;
+	} else {
+		use.misses++;
+	}
+}
+
 void NewGRFProfiler::Start()
 {
 	this->Abort();
@@ -94,6 +113,10 @@ uint32_t NewGRFProfiler::Finish()
 {
 	if (!this->active) return 0;
 
+	for (const auto &[cb, use] : this->cache_use) {
+		IConsolePrint(CC_DEBUG, "NewGRF [{:08X}] callback {:#X}: {} of {} results from the cache, {} microseconds saved.", BSWAP32(this->grffile->grfid), (uint)cb, use.hits, use.hits + use.misses, use.saved / 1000);
+	}
+
 	if (this->calls.empty()) {
 		IConsolePrint(CC_DEBUG, "Finished profile of NewGRF [{:08X}], no events collected, not writing a file.", BSWAP32(this->grffile->grfid));
 
@@ -107,22 +130,32 @@ uint32_t NewGRFProfiler::Finish()
 	FILE *f = FioFOpenFile(filename, "wt", Subdirectory::NO_DIRECTORY);
 	FileCloser fcloser(f);
 
-	uint32_t total_microseconds = 0;
+	uint64_t total_nanoseconds = 0;
+	uint64_t mode_nanoseconds[2] = {};
+	uint32_t mode_calls[2] = {};
 
-	fmt::print(f, "Tick,Sprite,Feature,Item,CallbackID,Microseconds,Depth,Result\n");
+	fmt::print(f, "Tick,Sprite,Feature,Item,CallbackID,Microseconds,Depth,Result,Compiled\n");
 	for (const Call &c : this->calls) {
-		fmt::print(f, "{},{},{:#X},{},{:#X},{},{},{}\n", c.tick, c.root_sprite, c.feat, c.item, (uint)c.cb, c.time, c.subs, c.result);
-		total_microseconds += c.time;
+		fmt::print(f, "{},{},{:#X},{},{:#X},{},{},{},{}\n", c.tick, c.root_sprite, c.feat, c.item, (uint)c.cb, c.time / 1000, c.subs, c.result, c.compiled ? 1 : 0);
+		total_nanoseconds += c.time;
+		mode_nanoseconds[c.compiled] += c.time;
+		mode_calls[c.compiled]++;
+	}
+
+	if (mode_calls[0] > 0 && mode_calls[1] > 0) {
+		IConsolePrint(CC_DEBUG, "  Interpreted action 2: {} calls, {} nanoseconds on average.", mode_calls[0], mode_nanoseconds[0] / mode_calls[0]);
+		IConsolePrint(CC_DEBUG, "  Compiled action 2: {} calls, {} nanoseconds on average.", mode_calls[1], mode_nanoseconds[1] / mode_calls[1]);
 	}
 
 	this->Abort();
-	return total_microseconds;
+	return (uint32_t)(total_nanoseconds / 1000);
 }
 
 void NewGRFProfiler::Abort()
 {
 	this->active = false;
 	this->calls.clear();
+	this->cache_use.clear();
 }
 
 /**
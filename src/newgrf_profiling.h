@@ -27,6 +27,7 @@ struct NewGRFProfiler {
 	void BeginResolve(const ResolverObject &resolver);
 	void EndResolve(const SpriteGroup *result);
 	void RecursiveResolve();
+	void CallbackCacheLookup(CallbackID cb, bool hit, uint32_t saved);
 
 	void Start();
 	uint32_t Finish();
@@ -43,10 +44,18 @@ struct NewGRFProfiler {
 		uint32_t item;         ///< Local ID of item being resolved for
 		uint32_t result;       ///< Result of callback
 		uint32_t subs;         ///< Sub-calls to other sprite groups
-		uint32_t time;         ///< Time taken for resolution (microseconds)
+		uint32_t time;         ///< Time taken for resolution (nanoseconds)
 		uint64_t tick;         ///< Game tick
 		CallbackID cb;       ///< Callback ID
 		GrfSpecFeature feat; ///< GRF feature being resolved for
+		bool compiled;       ///< Whether deterministic sprite groups were resolved with their compiled program
+	};
+
+	/** Use of the cached results of a callback. */
+	struct CacheUse {
+		uint32_t hits;   ///< Results taken from the cache
+		uint32_t misses; ///< Results that had to be resolved
+		uint64_t saved;  ///< Estimate of the time saved by the cache (nanoseconds)
 	};
 
 	const GRFFile *grffile;  ///< Which GRF is being profiled
@@ -54,6 +63,7 @@ struct NewGRFProfiler {
 	uint64_t start_tick;       ///< Tick number this profiler was started on
 	Call cur_call;           ///< Data for current call in progress
 	std::vector<Call> calls; ///< All calls collected so far
+	std::map<CallbackID, CacheUse> cache_use; ///< Use of the cached callback results per callback
 };
 
 extern std::vector<NewGRFProfiler> _newgrf_profilers;
@@ -0,0 +1,281 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file newgrf_scan_cache.cpp Cache of the scans of NewGRF files, so they do not have to be scanned again on the next start. */
+
+#include "stdafx.h"
+#include "debug.h"
+#include "fileio_func.h"
+#include "newgrf_scan_cache.h"
+#include "rev.h"
+
+#include <sys/stat.h>
+
+#include "safeguards.h"
+
+static const char NEWGRF_SCAN_CACHE_MAGIC[8] = { 'O', 'T', 'T', 'D', 'G', 'R', 'F', 'S' }; ///< Start of the cache file.
+static const uint32_t NEWGRF_SCAN_CACHE_VERSION = 2;      ///< Version of the cache file; increase when its format or the scan changes.
+static const size_t NEWGRF_SCAN_CACHE_MAX_ENTRIES = 512; ///< Maximum number of NewGRFs in the cache; the ones unused for the longest time are dropped first.
+
+std::string _newgrf_scan_cache_file; ///< The file to keep the scans of NewGRFs in between runs.
+
+/**
+ * A scan of a NewGRF in the cache. Positions are relative to the begin of the NewGRF,
+ * as the same NewGRF can be loose in one run and in a tar file in the next.
+ */
+struct CachedGRFFileScan {
+	uint64_t file_size;              ///< Size of the NewGRF, to catch a different file with the same MD5 sum in the configuration.
+	int64_t modification_time;       ///< Time the file of the NewGRF was last modified; the MD5 sum in the configuration is not recomputed when a file changes.
+	uint64_t last_used;              ///< Number of the last load of NewGRFs that used this scan.
+	GrfSpriteOffsets sprite_offsets; ///< The offsets of the sprites in the sprite section.
+	std::vector<std::pair<size_t, size_t>> real_sprites; ///< Begin and end of the data of the real sprites in the data section.
+};
+
+static std::map<MD5Hash, CachedGRFFileScan> _newgrf_scan_cache; ///< The cached scans by the MD5 sum of their NewGRF.
+static bool _newgrf_scan_cache_read = false;                    ///< Whether the cache file has been read already.
+static uint64_t _newgrf_scan_cache_generation = 0;              ///< Number of the last load of NewGRFs.
+
+/** Reader of the data of the cache file, that notes when reading past its end. */
+struct NewGRFScanCacheReader {
+	const byte *data; ///< Current position in the data.
+	const byte *end;  ///< End of the data.
+	bool ok = true;   ///< Whether all reads were within the data.
+
+	NewGRFScanCacheReader(const std::vector<byte> &buffer) : data(buffer.data()), end(buffer.data() + buffer.size()) {}
+
+	/**
+	 * Read a value in the native byte order.
+	 * @tparam T The type of the value.
+	 * @return The value, or a default one when there is not enough data left.
+	 */
+	template <typename T>
+	T Read()
+	{
+		T value{};
+		if ((size_t)(this->end - this->data) < sizeof(T)) {
+			this->ok = false;
+			return value;
+		}
+		memcpy(&value, this->data, sizeof(T));
+		this->data += sizeof(T);
+		return value;
+	}
+
+	/**
+	 * Check whether a number of items can still be in the data.
+	 * @param count The number of items.
+	 * @param item_size The minimum size of an item.
+	 * @return True iff there is enough data left.
+	 */
+	bool HasRoomFor(size_t count, size_t item_size)
+	{
+		if (count > (size_t)(this->end - this->data) / item_size) this->ok = false;
+		return this->ok;
+	}
+};
+
+/**
+ * Append a value in the native byte order to the data of the cache file.
+ * @param buffer The data of the cache file.
+ * @param value The value to append.
+ */
+template <typename T>
+static void WriteToNewGRFScanCache(std::vector<byte> &buffer, T value)
+{
+	const byte *data = reinterpret_cast<const byte *>(&value);
+	buffer.insert(buffer.end(), data, data + sizeof(T));
+}
+
+/**
+ * Read the cache file into memory, if that has not been done yet.
+ * It is only read once; after that the cache in memory is kept up to date, so restarting a game does not read it again.
+ * A cache file of another version of OpenTTD or that is broken is ignored, and will be overwritten.
+ */
+static void ReadNewGRFScanCache()
+{
+	if (_newgrf_scan_cache_read) return;
+	_newgrf_scan_cache_read = true;
+
+	std::unique_ptr<FILE, FileDeleter> fp(fopen(_newgrf_scan_cache_file.c_str(), "rb"));
+	if (fp == nullptr) return;
+
+	std::vector<byte> buffer;
+	if (fseek(fp.get(), 0, SEEK_END) != 0) return;
+	long size = ftell(fp.get());
+	if (size <= 0 || fseek(fp.get(), 0, SEEK_SET) != 0) return;
+	buffer.resize(size);
+	if (fread(buffer.data(), buffer.size(), 1, fp.get()) != 1) return;
+
+	NewGRFScanCacheReader reader(buffer);
+	for (char c : NEWGRF_SCAN_CACHE_MAGIC) {
+		if (reader.Read<char>() != c) return;
+	}
+	if (reader.Read<uint32_t>() != NEWGRF_SCAN_CACHE_VERSION) return;
+
+	uint32_t revision_length = reader.Read<uint32_t>();
+	if (!reader.HasRoomFor(revision_length, 1)) return;
+	std::string revision(reinterpret_cast<const char *>(reader.data), revision_length);
+	reader.data += revision_length;
+	if (revision != _openttd_revision) {
+		Debug(grf, 1, "NewGRF scan cache is of OpenTTD {}, ignoring it", revision);
+		return;
+	}
+
+	uint64_t generation = reader.Read<uint64_t>();
+	uint32_t count = reader.Read<uint32_t>();
+	std::map<MD5Hash, CachedGRFFileScan> cache;
+	for (uint32_t i = 0; i < count && reader.ok; i++) {
+		MD5Hash md5sum = reader.Read<MD5Hash>();
+		CachedGRFFileScan &entry = cache[md5sum];
+		entry.file_size = reader.Read<uint64_t>();
+		entry.modification_time = reader.Read<int64_t>();
+		entry.last_used = reader.Read<uint64_t>();
+
+		uint32_t offsets = reader.Read<uint32_t>();
+		if (!reader.HasRoomFor(offsets, sizeof(uint32_t) + sizeof(uint64_t) + sizeof(byte))) break;
+		for (uint32_t j = 0; j < offsets; j++) {
+			uint32_t id = reader.Read<uint32_t>();
+			GrfSpriteOffset &offset = entry.sprite_offsets[id];
+			offset.file_pos = reader.Read<uint64_t>();
+			offset.control_flags = reader.Read<byte>();
+		}
+
+		uint32_t real_sprites = reader.Read<uint32_t>();
+		if (!reader.HasRoomFor(real_sprites, 2 * sizeof(uint64_t))) break;
+		entry.real_sprites.reserve(real_sprites);
+		for (uint32_t j = 0; j < real_sprites; j++) {
+			size_t begin = reader.Read<uint64_t>();
+			size_t end = reader.Read<uint64_t>();
+			entry.real_sprites.emplace_back(begin, end);
+		}
+	}
+	if (!reader.ok) {
+		Debug(grf, 0, "NewGRF scan cache '{}' is broken, ignoring it", _newgrf_scan_cache_file);
+		return;
+	}
+
+	_newgrf_scan_cache = std::move(cache);
+	_newgrf_scan_cache_generation = generation;
+	Debug(grf, 1, "Read the scans of {} NewGRFs from the NewGRF scan cache", _newgrf_scan_cache.size());
+}
+
+/** Write the cache in memory to the cache file. */
+static void WriteNewGRFScanCache()
+{
+	std::vector<byte> buffer;
+	buffer.insert(buffer.end(), std::begin(NEWGRF_SCAN_CACHE_MAGIC), std::end(NEWGRF_SCAN_CACHE_MAGIC));
+	WriteToNewGRFScanCache<uint32_t>(buffer, NEWGRF_SCAN_CACHE_VERSION);
+	std::string_view revision = _openttd_revision;
+	WriteToNewGRFScanCache<uint32_t>(buffer, (uint32_t)revision.size());
+	buffer.insert(buffer.end(), revision.begin(), revision.end());
+
+	WriteToNewGRFScanCache<uint64_t>(buffer, _newgrf_scan_cache_generation);
+	WriteToNewGRFScanCache<uint32_t>(buffer, (uint32_t)_newgrf_scan_cache.size());
+	for (const auto &[md5sum, entry] : _newgrf_scan_cache) {
+		WriteToNewGRFScanCache<MD5Hash>(buffer, md5sum);
+		WriteToNewGRFScanCache<uint64_t>(buffer, entry.file_size);
+		WriteToNewGRFScanCache<int64_t>(buffer, entry.modification_time);
+		WriteToNewGRFScanCache<uint64_t>(buffer, entry.last_used);
+
+		WriteToNewGRFScanCache<uint32_t>(buffer, (uint32_t)entry.sprite_offsets.size());
+		for (const auto &[id, offset] : entry.sprite_offsets) {
+			WriteToNewGRFScanCache<uint32_t>(buffer, id);
+			WriteToNewGRFScanCache<uint64_t>(buffer, offset.file_pos);
+			WriteToNewGRFScanCache<byte>(buffer, offset.control_flags);
+		}
+
+		WriteToNewGRFScanCache<uint32_t>(buffer, (uint32_t)entry.real_sprites.size());
+		for (const auto &[begin, end] : entry.real_sprites) {
+			WriteToNewGRFScanCache<uint64_t>(buffer, begin);
+			WriteToNewGRFScanCache<uint64_t>(buffer, end);
+		}
+	}
+
+	std::unique_ptr<FILE, FileDeleter> fp(fopen(_newgrf_scan_cache_file.c_str(), "wb"));
+	if (fp == nullptr || fwrite(buffer.data(), buffer.size(), 1, fp.get()) != 1) {
+		Debug(grf, 0, "Could not write NewGRF scan cache '{}'", _newgrf_scan_cache_file);
+		return;
+	}
+	Debug(grf, 1, "Wrote the scans of {} NewGRFs to the NewGRF scan cache", _newgrf_scan_cache.size());
+}
+
+/**
+ * Find where the NewGRF of a scan is, and fill the scan from the cache when it has been scanned before.
+ * @param scan The scan to fill; the NewGRF and its sub directory are already set.
+ * @return True iff the scan was in the cache, otherwise the NewGRF still has to be scanned.
+ */
+bool LoadCachedGRFFileScan(GRFFileScan &scan)
+{
+	size_t size;
+	FILE *f = FioFOpenFile(scan.config->filename, "rb", scan.subdir, &size);
+	if (f == nullptr) return false;
+	long begin = ftell(f);
+	/* For a NewGRF in a tar file this is the time of the tar file, which changes whenever the NewGRF does. */
+	struct stat st;
+	bool have_stat = fstat(fileno(f), &st) == 0;
+	FioFCloseFile(f);
+	if (begin < 0 || !have_stat) return false;
+
+	scan.file_begin = begin;
+	scan.file_size = size;
+	scan.modification_time = st.st_mtime;
+
+	if (_newgrf_scan_cache_file.empty() || scan.config->ident.md5sum == MD5Hash{}) return false;
+	ReadNewGRFScanCache();
+
+	auto it = _newgrf_scan_cache.find(scan.config->ident.md5sum);
+	if (it == _newgrf_scan_cache.end() || it->second.file_size != scan.file_size || it->second.modification_time != scan.modification_time) return false;
+
+	/* The positions wrap around like unsigned numbers do, so the offset at 0 of sprite 0 comes back as 0 as well. */
+	const CachedGRFFileScan &entry = it->second;
+	scan.sprite_offsets = entry.sprite_offsets;
+	for (auto &[id, offset] : scan.sprite_offsets) offset.file_pos += scan.file_begin;
+	scan.real_sprites.reserve(entry.real_sprites.size());
+	for (const auto &[begin, end] : entry.real_sprites) scan.real_sprites.emplace_back(begin + scan.file_begin, end + scan.file_begin);
+
+	scan.scanned = true;
+	scan.cached = true;
+	return true;
+}
+
+/**
+ * Store the scans of a load of NewGRFs in the cache, and write the cache file when any scan was not in it yet.
+ * @param scans The scans of all NewGRFs that are being loaded.
+ */
+void CacheGRFFileScans(const std::vector<GRFFileScan> &scans)
+{
+	if (_newgrf_scan_cache_file.empty()) return;
+
+	_newgrf_scan_cache_generation++;
+	bool changed = false;
+	for (const GRFFileScan &scan : scans) {
+		const MD5Hash &md5sum = scan.config->ident.md5sum;
+		if (!scan.scanned || md5sum == MD5Hash{}) continue;
+
+		CachedGRFFileScan &entry = _newgrf_scan_cache[md5sum];
+		entry.last_used = _newgrf_scan_cache_generation;
+		if (scan.cached) continue;
+
+		entry.file_size = scan.file_size;
+		entry.modification_time = scan.modification_time;
+		entry.sprite_offsets = scan.sprite_offsets;
+		for (auto &[id, offset] : entry.sprite_offsets) offset.file_pos -= scan.file_begin;
+		entry.real_sprites.clear();
+		for (const auto &[begin, end] : scan.real_sprites) entry.real_sprites.emplace_back(begin - scan.file_begin, end - scan.file_begin);
+		changed = true;
+	}
+
+	while (_newgrf_scan_cache.size() > NEWGRF_SCAN_CACHE_MAX_ENTRIES) {
+		auto oldest = std::min_element(_newgrf_scan_cache.begin(), _newgrf_scan_cache.end(), [](const auto &a, const auto &b) {
+			return a.second.last_used < b.second.last_used;
+		});
+		_newgrf_scan_cache.erase(oldest);
+		changed = true;
+	}
+
+	if (changed) WriteNewGRFScanCache();
+}
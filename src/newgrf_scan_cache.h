@@ -0,0 +1,51 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file newgrf_scan_cache.h Scans of NewGRF files, and the cache to keep them on disk between runs. */
+
+#ifndef NEWGRF_SCAN_CACHE_H
+#define NEWGRF_SCAN_CACHE_H
+
+#include "fileio_type.h"
+#include "newgrf_config.h"
+#include "spritecache.h"
+
+/**
+ * What a scan of a NewGRF file found. This is what every loading stage would
+ * otherwise work out again on its own, without depending on any other NewGRF.
+ */
+struct GRFFileScan {
+	const GRFConfig *config;         ///< The configuration of the scanned NewGRF.
+	Subdirectory subdir;             ///< The sub directory the NewGRF was scanned in.
+	size_t file_begin = 0;           ///< Position of the begin of the NewGRF in the file it is in, e.g. a tar file.
+	size_t file_size = 0;            ///< Size of the NewGRF in bytes.
+	int64_t modification_time = 0;   ///< Time the file the NewGRF is in was last modified.
+	bool scanned = false;            ///< Whether the scan got past the header of the file.
+	bool cached = false;             ///< Whether the scan came from the cache.
+	GrfSpriteOffsets sprite_offsets; ///< The offsets of the sprites in the sprite section.
+	std::vector<std::pair<size_t, size_t>> real_sprites; ///< Begin and end of the data of the real sprites in the data section, in order of the begin.
+
+	GRFFileScan(const GRFConfig *config, Subdirectory subdir) : config(config), subdir(subdir) {}
+
+	/**
+	 * Get the end of the data of a real sprite in the data section.
+	 * @param pos The begin of the data, just after the type of the sprite.
+	 * @return The end of the data, or \c SIZE_MAX when no sprite at \a pos was scanned.
+	 */
+	size_t GetRealSpriteEnd(size_t pos) const
+	{
+		auto it = std::lower_bound(this->real_sprites.begin(), this->real_sprites.end(), std::make_pair(pos, (size_t)0));
+		return (it != this->real_sprites.end() && it->first == pos) ? it->second : SIZE_MAX;
+	}
+};
+
+extern std::string _newgrf_scan_cache_file;
+
+bool LoadCachedGRFFileScan(GRFFileScan &scan);
+void CacheGRFFileScans(const std::vector<GRFFileScan> &scans);
+
+#endif /* NEWGRF_SCAN_CACHE_H */
@@ -10,7 +10,9 @@
 #include "stdafx.h"
 #include "debug.h"
 #include "newgrf_spritegroup.h"
+#include "newgrf_callback_cache.h"
 #include "newgrf_profiling.h"
+#include "tick_profiling.h"
 #include "core/pool_func.hpp"
 
 #include "safeguards.h"
@@ -20,6 +22,11 @@ INSTANTIATE_POOL_METHODS(SpriteGroup)
 
 TemporaryStorageArray<int32_t, 0x110> _temp_store;
 
+static const uint DSG_MAX_CACHE_SLOTS = 32;     ///< Maximum number of variables of which the value is reused in a compiled deterministic sprite group.
+static const uint DSG_MAX_RANGE_TABLE_SIZE = 256; ///< Maximum number of values in the range table of a deterministic sprite group.
+
+static bool _evaluate_compiled_action2 = true; ///< Whether deterministic sprite groups are resolved with their compiled program.
+
 
 /**
  * ResolverObject (re)entry point.
@@ -35,7 +42,11 @@ TemporaryStorageArray<int32_t, 0x110> _temp_store;
 {
 	if (group == nullptr) return nullptr;
 
+	if (top_level && _newgrf_callback_trace != nullptr) TraceCallbackResolve(object);
+
 	const GRFFile *grf = object.grffile;
+	std::optional<TickProfileScope> tick_profile;
+	if (top_level) tick_profile.emplace(TPZ_NEWGRF, grf != nullptr ? grf->grfid : TICK_PROFILE_NO_ID);
 	auto profiler = std::find_if(_newgrf_profilers.begin(), _newgrf_profilers.end(), [&](const NewGRFProfiler &pr) { return pr.grffile == grf; });
 
 	if (profiler == _newgrf_profilers.end() || !profiler->active) {
@@ -44,7 +55,9 @@ TemporaryStorageArray<int32_t, 0x110> _temp_store;
 	} else if (top_level) {
 		profiler->BeginResolve(object);
 		_temp_store.ClearChanges();
+		_evaluate_compiled_action2 = profiler->cur_call.compiled;
 		const SpriteGroup *result = group->Resolve(object);
+		_evaluate_compiled_action2 = true;
 		profiler->EndResolve(result);
 		return result;
 	} else {
@@ -78,6 +91,67 @@ static inline uint32_t GetVariable(const ResolverObject &object, ScopeResolver *
 	}
 }
 
+/**
+ * Whether the value of a variable has to be recorded for memoised callbacks.
+ * The other variables are parameters of the callback, constant, or only depend on what the callback did before.
+ * @param variable The variable.
+ * @return True iff the variable has to be recorded.
+ */
+static inline bool IsTracedVariable(byte variable)
+{
+	switch (variable) {
+		case 0x0C: case 0x10: case 0x18: case 0x1A: case 0x1C: case 0x7D: case 0x7F:
+			return false;
+
+		default:
+			return true;
+	}
+}
+
+/**
+ * Get the value of a variable, and record it when a memoised callback is being resolved.
+ * @param object The resolver.
+ * @param scope_id Scope of the variable.
+ * @param scope Resolver of the scope.
+ * @param variable The variable.
+ * @param parameter Parameter of the variable.
+ * @param[out] available Set to false, in case the variable does not exist.
+ * @return Value of the variable.
+ */
+static inline uint32_t GetTracedVariable(const ResolverObject &object, VarSpriteGroupScope scope_id, ScopeResolver *scope, byte variable, uint32_t parameter, bool *available)
+{
+	uint32_t value = GetVariable(object, scope, variable, parameter, available);
+	if (_newgrf_callback_trace != nullptr && IsTracedVariable(variable)) TraceCallbackRead(object, scope_id, 0, variable, parameter, value, *available);
+	return value;
+}
+
+/**
+ * Get the value of a variable of a scope.
+ * @param object The resolver.
+ * @param scope Scope of the variable.
+ * @param relative Relative position of the scope.
+ * @param variable The variable.
+ * @param parameter Parameter of the variable.
+ * @param[out] available Set to false, in case the variable does not exist.
+ * @return Value of the variable.
+ */
+uint32_t GetScopeVariable(ResolverObject &object, VarSpriteGroupScope scope, byte relative, byte variable, uint32_t parameter, bool *available)
+{
+	return GetVariable(object, object.GetScope(scope, relative), variable, parameter, available);
+}
+
+/**
+ * Resolve callback.
+ * @return Callback result.
+ */
+uint16_t ResolverObject::ResolveCallback()
+{
+	if (this->root_spritegroup != nullptr && IsMemoisedCallback(this->callback)) return ResolveMemoisedCallback(*this);
+
+	const SpriteGroup *result = this->Resolve();
+	return result != nullptr ? result->GetCallbackResult() : CALLBACK_FAILED;
+}
+
 /**
  * Get a few random bits. Default implementation has no random bits.
  * @return Random bits.
@@ -137,10 +211,10 @@ static inline uint32_t GetVariable(const ResolverObject &object, ScopeResolver *
 	return &this->default_scope;
 }
 
-/* Evaluate an adjustment for a variable of the given size.
+/* Apply the shift, mask and division or modulo of an adjustment to a variable of the given size.
  * U is the unsigned type and S is the signed type to use. */
-template <typename U, typename S>
-static U EvalAdjustT(const DeterministicSpriteGroupAdjust &adjust, ScopeResolver *scope, U last_value, uint32_t value)
+template <typename U, typename S, typename A>
+static inline uint32_t AdjustValueT(const A &adjust, uint32_t value)
 {
 	value >>= adjust.shift_num;
 	value  &= adjust.and_mask;
@@ -151,7 +225,15 @@ static U EvalAdjustT(const DeterministicSpriteGroupAdjust &adjust, ScopeResolver
 		case DSGA_TYPE_NONE: break;
 	}
 
-	switch (adjust.operation) {
+	return value;
+}
+
+/* Apply the operation of an adjustment for a variable of the given size.
+ * U is the unsigned type and S is the signed type to use. */
+template <typename U, typename S>
+static inline U EvalOperationT(DeterministicSpriteGroupAdjustOperation operation, ScopeResolver *scope, U last_value, uint32_t value)
+{
+	switch (operation) {
 		case DSGA_OP_ADD:  return last_value + value;
 		case DSGA_OP_SUB:  return last_value - value;
 		case DSGA_OP_SMIN: return std::min<S>(last_value, value);
@@ -166,9 +248,15 @@ static U EvalAdjustT(const DeterministicSpriteGroupAdjust &adjust, ScopeResolver
 		case DSGA_OP_AND:  return last_value & value;
 		case DSGA_OP_OR:   return last_value | value;
 		case DSGA_OP_XOR:  return last_value ^ value;
-		case DSGA_OP_STO:  _temp_store.StoreValue((U)value, (S)last_value); return last_value;
+		case DSGA_OP_STO:
+			_temp_store.StoreValue((U)value, (S)last_value);
+			if (_newgrf_callback_trace != nullptr) TraceCallbackStore(scope->ro, (U)value, (S)last_value);
+			return last_value;
 		case DSGA_OP_RST:  return value;
-		case DSGA_OP_STOP: scope->StorePSA((U)value, (S)last_value); return last_value;
+		case DSGA_OP_STOP:
+			scope->StorePSA((U)value, (S)last_value);
+			if (_newgrf_callback_trace != nullptr) TraceCallbackUncacheable(scope->ro);
+			return last_value;
 		case DSGA_OP_ROR:  return std::rotr<uint32_t>((U)last_value, (U)value & 0x1F); // mask 'value' to 5 bits, which should behave the same on all architectures.
 		case DSGA_OP_SCMP: return ((S)last_value == (S)value) ? 1 : ((S)last_value < (S)value ? 0 : 2);
 		case DSGA_OP_UCMP: return ((U)last_value == (U)value) ? 1 : ((U)last_value < (U)value ? 0 : 2);
@@ -179,6 +267,14 @@ static U EvalAdjustT(const DeterministicSpriteGroupAdjust &adjust, ScopeResolver
 	}
 }
 
+/* Evaluate an adjustment for a variable of the given size.
+ * U is the unsigned type and S is the signed type to use. */
+template <typename U, typename S>
+static U EvalAdjustT(const DeterministicSpriteGroupAdjust &adjust, ScopeResolver *scope, U last_value, uint32_t value)
+{
+	return EvalOperationT<U, S>(adjust.operation, scope, last_value, AdjustValueT<U, S>(adjust, value));
+}
+
 
 static bool RangeHighComparator(const DeterministicSpriteGroupRange &range, uint32_t value)
 {
@@ -187,6 +283,15 @@ static bool RangeHighComparator(const DeterministicSpriteGroupRange &range, uint
 
 const SpriteGroup *DeterministicSpriteGroup::Resolve(ResolverObject &object) const
 {
+	if (!this->program.empty() && _evaluate_compiled_action2) {
+		switch (this->size) {
+			case DSG_SIZE_BYTE:  return this->ResolveCompiledT<uint8_t,  int8_t> (object);
+			case DSG_SIZE_WORD:  return this->ResolveCompiledT<uint16_t, int16_t>(object);
+			case DSG_SIZE_DWORD: return this->ResolveCompiledT<uint32_t, int32_t>(object);
+			default: NOT_REACHED();
+		}
+	}
+
 	uint32_t last_value = 0;
 	uint32_t value = 0;
 
@@ -205,9 +310,9 @@ const SpriteGroup *DeterministicSpriteGroup::Resolve(ResolverObject &object) con
 
 			/* Note: 'last_value' and 'reseed' are shared between the main chain and the procedure */
 		} else if (adjust.variable == 0x7B) {
-			value = GetVariable(object, scope, adjust.parameter, last_value, &available);
+			value = GetTracedVariable(object, this->var_scope, scope, adjust.parameter, last_value, &available);
 		} else {
-			value = GetVariable(object, scope, adjust.variable, adjust.parameter, &available);
+			value = GetTracedVariable(object, this->var_scope, scope, adjust.variable, adjust.parameter, &available);
 		}
 
 		if (!available) {
@@ -252,6 +357,259 @@ const SpriteGroup *DeterministicSpriteGroup::Resolve(ResolverObject &object) con
 	return SpriteGroup::Resolve(this->default_group, object, false);
 }
 
+/**
+ * Resolve the group with its compiled program.
+ * U is the unsigned type and S is the signed type of the size of the group.
+ * @param object Information needed to resolve the group.
+ * @return The resolved group.
+ */
+template <typename U, typename S>
+const SpriteGroup *DeterministicSpriteGroup::ResolveCompiledT(ResolverObject &object) const
+{
+	uint32_t last_value = 0;
+	uint32_t cache[DSG_MAX_CACHE_SLOTS];
+	uint32_t cached = 0; // Bitmask of the valid values in cache.
+
+	ScopeResolver *scope = object.GetScope(this->var_scope);
+
+	for (const DeterministicSpriteGroupInstruction &ins : this->program) {
+		bool available = true;
+		uint32_t value;
+		switch (ins.operand) {
+			case DSGO_CONSTANT:
+				value = ins.constant;
+				break;
+
+			case DSGO_VARIABLE:
+				value = AdjustValueT<U, S>(ins, GetTracedVariable(object, this->var_scope, scope, ins.variable, ins.parameter, &available));
+				break;
+
+			case DSGO_CACHED:
+				if (!HasBit(cached, ins.cache_slot)) {
+					cache[ins.cache_slot] = GetTracedVariable(object, this->var_scope, scope, ins.variable, ins.parameter, &available);
+					SetBit(cached, ins.cache_slot);
+				}
+				value = AdjustValueT<U, S>(ins, cache[ins.cache_slot]);
+				break;
+
+			case DSGO_LAST_VALUE:
+				value = AdjustValueT<U, S>(ins, GetTracedVariable(object, this->var_scope, scope, ins.parameter, last_value, &available));
+				break;
+
+			case DSGO_PROCEDURE: {
+				const SpriteGroup *subgroup = SpriteGroup::Resolve(ins.subroutine, object, false);
+				value = AdjustValueT<U, S>(ins, subgroup == nullptr ? CALLBACK_FAILED : subgroup->GetCallbackResult());
+				/* The procedure might have changed the storage and thus the variables. */
+				cached = 0;
+				break;
+			}
+
+			default: NOT_REACHED();
+		}
+
+		if (!available) return SpriteGroup::Resolve(this->error_group, object, false);
+
+		if (ins.operation == DSGA_OP_STO || ins.operation == DSGA_OP_STOP) cached = 0;
+		last_value = EvalOperationT<U, S>(ins.operation, scope, last_value, value);
+	}
+
+	return this->ResolveResult(object, last_value);
+}
+
+/**
+ * Resolve the group for the value that the compiled program evaluated to.
+ * @param object Information needed to resolve the group.
+ * @param value The value.
+ * @return The resolved group.
+ */
+const SpriteGroup *DeterministicSpriteGroup::ResolveResult(ResolverObject &object, uint32_t value) const
+{
+	object.last_value = value;
+
+	if (this->calculated_result) {
+		/* nvar == 0 is a special case -- we turn our value into a callback result */
+		if (value != CALLBACK_FAILED) value = GB(value, 0, 15);
+		static CallbackResultSpriteGroup nvarzero(0, true);
+		nvarzero.result = value;
+		return &nvarzero;
+	}
+
+	if (!this->range_table.empty()) {
+		uint32_t index = value - this->range_table_base;
+		return SpriteGroup::Resolve(index < this->range_table.size() ? this->range_table[index] : this->default_group, object, false);
+	}
+
+	const auto &lower = std::lower_bound(this->ranges.begin(), this->ranges.end(), value, RangeHighComparator);
+	if (lower != this->ranges.end() && lower->low <= value) return SpriteGroup::Resolve(lower->group, object, false);
+
+	return SpriteGroup::Resolve(this->default_group, object, false);
+}
+
+/**
+ * Whether the value of a variable may be reused for later reads of the same variable by the same group,
+ * as long as nothing has been stored and no procedure has been called in between.
+ * @param variable The variable.
+ * @return True if the value can be reused.
+ */
+static bool IsCacheableVariable(byte variable)
+{
+	switch (variable) {
+		case 0x1A: // Constant
+		case 0x1C: // Result of the last procedure
+		case 0x7B: // Indirect variable access
+		case 0x7C: // Persistent storage
+		case 0x7D: // Temporary storage
+		case 0x7E: // Procedure call
+			return false;
+
+		default:
+			return true;
+	}
+}
+
+/**
+ * Get an upper bound of the result of an operation.
+ * @param operation The operation.
+ * @param last_max Upper bound of the last value.
+ * @param value_max Upper bound of the value to operate with.
+ * @param type_max Maximum value of the size of the group.
+ * @return The upper bound of the result.
+ */
+static uint32_t GetOperationUpperBound(DeterministicSpriteGroupAdjustOperation operation, uint32_t last_max, uint32_t value_max, uint32_t type_max)
+{
+	switch (operation) {
+		case DSGA_OP_ADD:  return (uint64_t)last_max + value_max <= type_max ? last_max + value_max : type_max;
+		case DSGA_OP_UMIN: return std::min(last_max, value_max);
+		case DSGA_OP_AND:  return std::min(last_max, value_max);
+		case DSGA_OP_OR:
+		case DSGA_OP_XOR: {
+			uint32_t max = std::max(last_max, value_max);
+			return max == 0 ? 0 : (uint32_t)((2ULL << FindLastBit(max)) - 1);
+		}
+		case DSGA_OP_STO:
+		case DSGA_OP_STOP: return last_max;
+		case DSGA_OP_RST:  return value_max;
+		case DSGA_OP_SCMP:
+		case DSGA_OP_UCMP: return 2;
+		default:           return type_max;
+	}
+}
+
+/**
+ * Compile the adjusts of the group into a program.
+ * U is the unsigned type and S is the signed type of the size of the group.
+ * Operations on constants are folded, values of variables that are read more than once are only read once,
+ * ranges the result can never be in are removed, and small ranges are turned into a lookup table.
+ */
+template <typename U, typename S>
+void DeterministicSpriteGroup::CompileT()
+{
+	this->program.clear();
+	this->range_table.clear();
+
+	std::map<std::pair<byte, byte>, uint> reads;
+	for (const DeterministicSpriteGroupAdjust &adjust : this->adjusts) {
+		if (IsCacheableVariable(adjust.variable)) reads[{adjust.variable, adjust.parameter}]++;
+	}
+	std::map<std::pair<byte, byte>, byte> slots;
+
+	const uint32_t type_max = std::numeric_limits<U>::max();
+	bool known = true;        // Whether the last value is known while compiling.
+	uint32_t last_value = 0;  // The last value, when known.
+	uint32_t last_max = 0;    // Upper bound of the last value.
+	bool folded = false;      // Whether the last instruction holds the folded constant last value.
+
+	for (const DeterministicSpriteGroupAdjust &adjust : this->adjusts) {
+		DeterministicSpriteGroupInstruction ins{};
+		ins.operation = adjust.operation;
+		ins.type = adjust.type;
+		ins.variable = adjust.variable;
+		ins.parameter = adjust.parameter;
+		ins.shift_num = adjust.shift_num;
+		ins.and_mask = adjust.and_mask;
+		ins.add_val = adjust.add_val;
+		ins.divmod_val = adjust.divmod_val;
+		ins.subroutine = adjust.subroutine;
+
+		/* Variable 0x1A is always -1. Divisions are left to the runtime, so faulty ones do not fail while loading. */
+		if (adjust.variable == 0x1A && adjust.type == DSGA_TYPE_NONE) {
+			ins.operand = DSGO_CONSTANT;
+			ins.constant = AdjustValueT<U, S>(adjust, UINT_MAX);
+		} else if (adjust.variable == 0x7E) {
+			ins.operand = DSGO_PROCEDURE;
+		} else if (adjust.variable == 0x7B) {
+			ins.operand = DSGO_LAST_VALUE;
+		} else if (IsCacheableVariable(adjust.variable) && reads[{adjust.variable, adjust.parameter}] > 1 && (slots.count({adjust.variable, adjust.parameter}) > 0 || slots.size() < DSG_MAX_CACHE_SLOTS)) {
+			ins.operand = DSGO_CACHED;
+			ins.cache_slot = slots.try_emplace({adjust.variable, adjust.parameter}, (byte)slots.size()).first->second;
+		} else {
+			ins.operand = DSGO_VARIABLE;
+		}
+
+		uint32_t value_max = ins.operand == DSGO_CONSTANT ? ins.constant : (adjust.type == DSGA_TYPE_NONE ? adjust.and_mask : type_max);
+		last_max = std::min(GetOperationUpperBound(adjust.operation, last_max, value_max, type_max), type_max);
+
+		bool side_effect = adjust.operation == DSGA_OP_STO || adjust.operation == DSGA_OP_STOP;
+		bool foldable = !side_effect && adjust.operation != DSGA_OP_SDIV && adjust.operation != DSGA_OP_SMOD;
+		if (ins.operand == DSGO_CONSTANT && foldable && (known || adjust.operation == DSGA_OP_RST)) {
+			/* The last value is known after this operation, so merge it with the previous operations on constants. */
+			last_value = EvalOperationT<U, S>(adjust.operation, nullptr, (U)(known ? last_value : 0), ins.constant);
+			last_max = last_value;
+			known = true;
+
+			if (!folded) {
+				DeterministicSpriteGroupInstruction &rst = this->program.emplace_back();
+				rst.operand = DSGO_CONSTANT;
+				rst.operation = DSGA_OP_RST;
+				folded = true;
+			}
+			this->program.back().constant = last_value;
+			continue;
+		}
+
+		this->program.push_back(ins);
+		folded = false;
+		if (!side_effect) known = false;
+	}
+
+	if (this->calculated_result) return;
+
+	/* Ranges the result can never be in are never used. */
+	while (!this->ranges.empty() && this->ranges.back().low > last_max) this->ranges.pop_back();
+	if (!this->ranges.empty()) this->ranges.back().high = std::min(this->ranges.back().high, last_max);
+
+	if (known) {
+		/* The result is always the same. */
+		const auto &lower = std::lower_bound(this->ranges.begin(), this->ranges.end(), last_value, RangeHighComparator);
+		this->range_table.push_back(lower != this->ranges.end() && lower->low <= last_value ? lower->group : this->default_group);
+		this->range_table_base = last_value;
+		return;
+	}
+
+	if (this->ranges.size() < 2) return;
+	uint64_t span = (uint64_t)this->ranges.back().high - this->ranges.front().low + 1;
+	if (span > DSG_MAX_RANGE_TABLE_SIZE) return;
+
+	this->range_table_base = this->ranges.front().low;
+	this->range_table.resize(span, this->default_group);
+	for (const DeterministicSpriteGroupRange &range : this->ranges) {
+		std::fill(this->range_table.begin() + (range.low - this->range_table_base), this->range_table.begin() + (range.high - this->range_table_base + 1), range.group);
+	}
+}
+
+/**
+ * Compile the group after loading, so it is resolved faster.
+ */
+void DeterministicSpriteGroup::Compile()
+{
+	switch (this->size) {
+		case DSG_SIZE_BYTE:  this->CompileT<uint8_t,  int8_t> (); break;
+		case DSG_SIZE_WORD:  this->CompileT<uint16_t, int16_t>(); break;
+		case DSG_SIZE_DWORD: this->CompileT<uint32_t, int32_t>(); break;
+		default: NOT_REACHED();
+	}
+}
+
 
 const SpriteGroup *RandomizedSpriteGroup::Resolve(ResolverObject &object) const
 {
@@ -267,6 +625,8 @@ const SpriteGroup *RandomizedSpriteGroup::Resolve(ResolverObject &object) const
 		}
 	}
 
+	if (_newgrf_callback_trace != nullptr) TraceCallbackRead(object, this->var_scope, this->count, 0x5F, 0, (scope->GetRandomBits() << 8) | scope->GetTriggers(), true);
+
 	uint32_t mask = ((uint)this->groups.size() - 1) << this->lowest_randbit;
 	byte index = (scope->GetRandomBits() & mask) >> this->lowest_randbit;
 
@@ -276,6 +636,14 @@ const SpriteGroup *RandomizedSpriteGroup::Resolve(ResolverObject &object) const
 
 const SpriteGroup *RealSpriteGroup::Resolve(ResolverObject &object) const
 {
+	if (_newgrf_callback_trace != nullptr) {
+		/* Which of the groups is used depends on the state of the object, which is not recorded. */
+		auto is_callback = [](const SpriteGroup *group) { return group != nullptr && group->type == SGT_CALLBACK; };
+		if (std::any_of(this->loaded.begin(), this->loaded.end(), is_callback) || std::any_of(this->loading.begin(), this->loading.end(), is_callback)) {
+			TraceCallbackUncacheable(object);
+		}
+	}
+
 	return object.ResolveReal(this);
 }
 
@@ -163,6 +163,31 @@ struct DeterministicSpriteGroupRange {
 	uint32_t high;
 };
 
+/** Where the compiled instructions of a deterministic sprite group get the value to operate with from. */
+enum DeterministicSpriteGroupOperand : uint8_t {
+	DSGO_VARIABLE,   ///< Read the variable.
+	DSGO_CACHED,     ///< Read the variable once, later instructions reading the same variable reuse the value.
+	DSGO_LAST_VALUE, ///< Read variable \c parameter, with the last value as parameter (variable 0x7B).
+	DSGO_PROCEDURE,  ///< Call the subroutine (variable 0x7E).
+	DSGO_CONSTANT,   ///< The adjusted value does not depend on the game state.
+};
+
+/** Instruction of the compiled form of the adjusts of a deterministic sprite group. */
+struct DeterministicSpriteGroupInstruction {
+	DeterministicSpriteGroupOperand operand;
+	DeterministicSpriteGroupAdjustOperation operation;
+	DeterministicSpriteGroupAdjustType type;
+	byte variable;
+	byte parameter;
+	byte shift_num;
+	byte cache_slot;  ///< Slot of the value of a #DSGO_CACHED variable.
+	uint32_t and_mask;
+	uint32_t add_val;
+	uint32_t divmod_val;
+	uint32_t constant; ///< Adjusted value of a #DSGO_CONSTANT operand.
+	const SpriteGroup *subroutine;
+};
+
 
 struct DeterministicSpriteGroup : SpriteGroup {
 	DeterministicSpriteGroup() : SpriteGroup(SGT_DETERMINISTIC) {}
@@ -178,8 +203,19 @@ struct DeterministicSpriteGroup : SpriteGroup {
 
 	const SpriteGroup *error_group; // was first range, before sorting ranges
 
+	std::vector<DeterministicSpriteGroupInstruction> program; ///< Compiled #adjusts; evaluated instead of them when not empty.
+	std::vector<const SpriteGroup *> range_table; ///< Group for each value from #range_table_base, instead of searching #ranges.
+	uint32_t range_table_base;                    ///< Value of the first entry of #range_table.
+
+	void Compile();
+
 protected:
 	const SpriteGroup *Resolve(ResolverObject &object) const override;
+
+private:
+	template <typename U, typename S> void CompileT();
+	template <typename U, typename S> const SpriteGroup *ResolveCompiledT(ResolverObject &object) const;
+	const SpriteGroup *ResolveResult(ResolverObject &object, uint32_t value) const;
 };
 
 enum RandomizedSpriteGroupCompareMode {
@@ -348,11 +384,7 @@ struct ResolverObject {
 	 * Resolve callback.
 	 * @return Callback result.
 	 */
-	uint16_t ResolveCallback()
-	{
-		const SpriteGroup *result = Resolve();
-		return result != nullptr ? result->GetCallbackResult() : CALLBACK_FAILED;
-	}
+	uint16_t ResolveCallback();
 
 	virtual const SpriteGroup *ResolveReal(const RealSpriteGroup *group) const;
 
@@ -405,4 +437,6 @@ struct ResolverObject {
 	virtual uint32_t GetDebugID() const { return 0; }
 };
 
+uint32_t GetScopeVariable(ResolverObject &object, VarSpriteGroupScope scope, byte relative, byte variable, uint32_t parameter, bool *available);
+
 #endif /* NEWGRF_SPRITEGROUP_H */
@@ -77,6 +77,8 @@
 #include "timer/timer_game_realtime.h"
 #include "timer/timer_game_tick.h"
 #include "social_integration.h"
+#include "worker_pool.h"
+#include "tick_profiling.h"
 
 #include "linkgraph/linkgraphschedule.h"
 
@@ -305,6 +307,9 @@ static void ShutdownGame()
 	LinkGraphSchedule::Clear();
 	PoolBase::Clean(PT_ALL);
 
+	ShutdownWorkerPool();
+	ShutdownSpriteDecoder();
+
 	/* No NewGRFs were loaded when it was still bootstrapping. */
 	if (_game_mode != GM_BOOTSTRAP) ResetNewGRFData();
 
@@ -1447,6 +1452,7 @@ void StateGameLoop()
 	}
 
 	PerformanceMeasurer framerate(PFE_GAMELOOP);
+	TickProfileScope tick_profile(TPZ_GAMELOOP);
 	PerformanceAccumulator::Reset(PFE_GL_LANDSCAPE);
 
 	Layouter::ReduceLineCache();
@@ -0,0 +1,599 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file rail_junctions.cpp Handles the graph of rail junctions that assists the rail pathfinder.
+ *
+ * The graph describes the rail network as simply as possible: a train can go anywhere the
+ * track leads, regardless of owner, rail type, signals and 90 degree turns. Its nodes are the
+ * places where a train has a choice (or no way at all), and all places a train can have as
+ * destination, i.e. station, waypoint and depot tiles. Its edges are the stretches of track
+ * between two nodes, with the lowest cost the pathfinder could possibly assign to them.
+ *
+ * As the pathfinder only allows a subset of the moves of this graph, at a higher cost, the
+ * distance to a destination in the graph is a consistent lower bound of the pathfinder cost.
+ * Those distances are searched backwards from the destination on demand, and kept until the
+ * track layout changes. The graph itself is only updated around the changed tiles.
+ */
+
+#include "../stdafx.h"
+#include "../rail_map.h"
+#include "../station_map.h"
+#include "../tunnelbridge_map.h"
+#include "../tunnelbridge.h"
+#include "../landscape.h"
+#include "../track_func.h"
+#include "../base_station_base.h"
+#include "../console_func.h"
+#include "../debug.h"
+#include "pathfinder_type.h"
+#include "rail_junctions.h"
+
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "../safeguards.h"
+
+/** Node or edge index of unused entries. */
+static const uint32_t INVALID_RAIL_JUNCTION = UINT32_MAX;
+
+/** Maximum number of destinations to keep the distances of. */
+static const size_t MAX_RAIL_JUNCTION_DISTANCES = 16;
+
+/** A single move of a train over the track. */
+struct RailJunctionStep {
+	TileIndex tile; ///< Tile after the move.
+	Trackdir td;    ///< Trackdir after the move.
+	int cost;       ///< Lowest possible cost of the move.
+};
+
+/** All moves that can be made from a single position; there are at most three ways to continue. */
+using RailJunctionSteps = std::array<RailJunctionStep, 3>;
+
+static inline uint32_t GetRailStateKey(TileIndex tile, Trackdir td) { return (tile.base() << 4) | td; }
+static inline TileIndex GetRailStateTile(uint32_t key) { return TileIndex{key >> 4}; }
+static inline Trackdir GetRailStateTrackdir(uint32_t key) { return (Trackdir)(key & 0xF); }
+
+static inline TrackdirBits GetRailTrackdirs(TileIndex tile) { return TrackStatusToTrackdirBits(GetTileTrackStatus(tile, TRANSPORT_RAIL, 0)); }
+
+/**
+ * Get the lowest cost the pathfinder can assign to moving onto a trackdir.
+ * @param td Trackdir after the move.
+ * @param skipped Number of tunnel or bridge tiles skipped by the move.
+ * @return The cost of the move.
+ */
+static inline int GetRailStepCost(Trackdir td, uint skipped)
+{
+	return (IsDiagonalTrackdir(td) ? YAPF_TILE_LENGTH : YAPF_TILE_CORNER_LENGTH) + skipped * YAPF_TILE_LENGTH;
+}
+
+/**
+ * Whether a tile can be the destination of a train; positions on such tiles are always nodes.
+ * @param tile The tile to check.
+ * @return True for rail station, waypoint and depot tiles.
+ */
+static inline bool IsRailJunctionDestinationTile(TileIndex tile)
+{
+	return IsRailDepotTile(tile) || (IsTileType(tile, MP_STATION) && HasStationRail(tile));
+}
+
+/**
+ * Get the moves a train can make from a position. These are the moves of the track
+ * follower, except that owners, rail types and 90 degree turns are not checked, and
+ * that trains move through stations tile by tile instead of to the end of the platform.
+ * @param tile Tile of the position.
+ * @param td Trackdir of the position.
+ * @param[out] steps The possible moves.
+ * @return Number of possible moves.
+ */
+static uint GetRailJunctionSteps(TileIndex tile, Trackdir td, RailJunctionSteps &steps)
+{
+	DiagDirection exitdir = TrackdirToExitdir(td);
+
+	/* Trains can only reverse in depots. */
+	if (IsRailDepotTile(tile) && GetRailDepotDirection(tile) != exitdir) {
+		steps[0] = { tile, ReverseTrackdir(td), GetRailStepCost(ReverseTrackdir(td), 0) };
+		return 1;
+	}
+
+	TileIndex next;
+	uint skipped = 0;
+	if (IsTileType(tile, MP_TUNNELBRIDGE) && GetTunnelBridgeDirection(tile) == exitdir) {
+		next = GetOtherTunnelBridgeEnd(tile);
+		skipped = GetTunnelBridgeLength(tile, next);
+	} else {
+		next = TileAddByDiagDir(tile, exitdir);
+		/* Tunnels, bridges and depots can only be entered from one side. */
+		if (IsTileType(next, MP_TUNNELBRIDGE) && GetTunnelBridgeDirection(next) != exitdir) return 0;
+		if (IsRailDepotTile(next) && GetRailDepotDirection(next) != ReverseDiagDir(exitdir)) return 0;
+	}
+
+	uint count = 0;
+	for (Trackdir next_td : SetTrackdirBitIterator(GetRailTrackdirs(next) & DiagdirReachesTrackdirs(exitdir))) {
+		steps[count++] = { next, next_td, GetRailStepCost(next_td, skipped) };
+	}
+	return count;
+}
+
+/** A position where a train has a choice, or that can be a destination. */
+struct RailJunctionNode {
+	uint32_t key = INVALID_RAIL_JUNCTION; ///< Position of the node.
+	std::vector<uint32_t> out;            ///< Edges starting at this node.
+	std::vector<uint32_t> in;             ///< Edges ending at this node.
+};
+
+/** The track between two nodes, which a train can only follow one way. */
+struct RailJunctionEdge {
+	uint32_t from = INVALID_RAIL_JUNCTION; ///< Node the edge starts at.
+	uint32_t to = INVALID_RAIL_JUNCTION;   ///< Node the edge ends at.
+	int cost = 0;                          ///< Lowest possible cost of following the edge.
+	std::vector<TileIndex> tiles;          ///< Tiles with positions on the edge, including the tiles of both nodes.
+};
+
+/** The graph of rail junctions of the whole map. */
+struct RailJunctionGraph {
+	std::vector<RailJunctionNode> nodes;     ///< All nodes; unused nodes have an invalid key.
+	std::vector<uint32_t> free_nodes;        ///< Indices of unused nodes.
+	std::vector<RailJunctionEdge> edges;     ///< All edges; unused edges have an invalid start.
+	std::vector<uint32_t> free_edges;        ///< Indices of unused edges.
+	std::unordered_map<uint32_t, uint32_t> node_index;               ///< Node per position.
+	std::unordered_map<uint32_t, std::vector<uint32_t>> tile_edges;  ///< Edges per tile they pass.
+	std::vector<TileIndex> dirty_tiles;      ///< Tiles changed since the last update.
+	std::unordered_set<uint32_t> visited;    ///< Positions visited while tracing an edge.
+	bool initialized = false;                ///< Whether the graph has been built.
+	uint64_t version = 0;                    ///< Incremented whenever the graph changes.
+	size_t num_nodes = 0;                    ///< Number of used nodes.
+	size_t num_edges = 0;                    ///< Number of used edges.
+
+	/** Remove everything; the graph is built again when it is needed. */
+	void Clear()
+	{
+		this->nodes.clear();
+		this->free_nodes.clear();
+		this->edges.clear();
+		this->free_edges.clear();
+		this->node_index.clear();
+		this->tile_edges.clear();
+		this->dirty_tiles.clear();
+		this->initialized = false;
+		this->num_nodes = 0;
+		this->num_edges = 0;
+		this->version++;
+	}
+
+	/**
+	 * Whether a position is a node.
+	 * @param tile Tile of the position.
+	 * @param td Trackdir of the position.
+	 * @return True if the position is a node.
+	 */
+	static bool IsNode(TileIndex tile, Trackdir td)
+	{
+		RailJunctionSteps steps;
+		return IsRailJunctionDestinationTile(tile) || GetRailJunctionSteps(tile, td, steps) != 1;
+	}
+
+	void AddNode(uint32_t key)
+	{
+		uint32_t index;
+		if (this->free_nodes.empty()) {
+			index = static_cast<uint32_t>(this->nodes.size());
+			this->nodes.emplace_back();
+		} else {
+			index = this->free_nodes.back();
+			this->free_nodes.pop_back();
+		}
+		this->nodes[index].key = key;
+		this->node_index[key] = index;
+		this->num_nodes++;
+	}
+
+	void RemoveNode(uint32_t index)
+	{
+		RailJunctionNode &node = this->nodes[index];
+		while (!node.out.empty()) this->RemoveEdge(node.out.back());
+		while (!node.in.empty()) this->RemoveEdge(node.in.back());
+		this->node_index.erase(node.key);
+		node.key = INVALID_RAIL_JUNCTION;
+		this->free_nodes.push_back(index);
+		this->num_nodes--;
+	}
+
+	void AddEdge(RailJunctionEdge &&edge)
+	{
+		uint32_t index;
+		if (this->free_edges.empty()) {
+			index = static_cast<uint32_t>(this->edges.size());
+			this->edges.emplace_back();
+		} else {
+			index = this->free_edges.back();
+			this->free_edges.pop_back();
+		}
+
+		std::sort(edge.tiles.begin(), edge.tiles.end());
+		edge.tiles.erase(std::unique(edge.tiles.begin(), edge.tiles.end()), edge.tiles.end());
+		for (TileIndex tile : edge.tiles) this->tile_edges[tile.base()].push_back(index);
+		this->nodes[edge.from].out.push_back(index);
+		this->nodes[edge.to].in.push_back(index);
+		this->edges[index] = std::move(edge);
+		this->num_edges++;
+	}
+
+	void RemoveEdge(uint32_t index)
+	{
+		auto erase = [index](std::vector<uint32_t> &list) {
+			auto it = std::find(list.begin(), list.end(), index);
+			assert(it != list.end());
+			*it = list.back();
+			list.pop_back();
+		};
+
+		RailJunctionEdge &edge = this->edges[index];
+		for (TileIndex tile : edge.tiles) {
+			auto it = this->tile_edges.find(tile.base());
+			erase(it->second);
+			if (it->second.empty()) this->tile_edges.erase(it);
+		}
+		erase(this->nodes[edge.from].out);
+		erase(this->nodes[edge.to].in);
+
+		edge.from = INVALID_RAIL_JUNCTION;
+		edge.to = INVALID_RAIL_JUNCTION;
+		edge.tiles.clear();
+		this->free_edges.push_back(index);
+		this->num_edges--;
+	}
+
+	/**
+	 * (Re)create the edges starting at a node, by following the track until the next node.
+	 * @param index The node.
+	 */
+	void TraceNode(uint32_t index)
+	{
+		while (!this->nodes[index].out.empty()) this->RemoveEdge(this->nodes[index].out.back());
+
+		TileIndex tile = GetRailStateTile(this->nodes[index].key);
+		RailJunctionSteps first;
+		uint count = GetRailJunctionSteps(tile, GetRailStateTrackdir(this->nodes[index].key), first);
+		for (uint i = 0; i < count; i++) {
+			RailJunctionEdge edge;
+			edge.from = index;
+			edge.tiles.push_back(tile);
+
+			this->visited.clear();
+			RailJunctionStep step = first[i];
+			for (;;) {
+				edge.cost += step.cost;
+				edge.tiles.push_back(step.tile);
+
+				uint32_t key = GetRailStateKey(step.tile, step.td);
+				auto node = this->node_index.find(key);
+				if (node != this->node_index.end()) {
+					edge.to = node->second;
+					this->AddEdge(std::move(edge));
+					break;
+				}
+
+				/* A loop without any node; it does not lead anywhere. */
+				if (!this->visited.insert(key).second) break;
+
+				RailJunctionSteps next;
+				[[maybe_unused]] uint next_count = GetRailJunctionSteps(step.tile, step.td, next);
+				assert(next_count == 1);
+				step = next[0];
+			}
+		}
+	}
+
+	/** Build the graph of the whole map. */
+	void Build()
+	{
+		this->Clear();
+
+		for (TileIndex tile : Map::Iterate()) {
+			for (Trackdir td : SetTrackdirBitIterator(GetRailTrackdirs(tile))) {
+				if (IsNode(tile, td)) this->AddNode(GetRailStateKey(tile, td));
+			}
+		}
+		for (uint32_t index = 0; index < this->nodes.size(); index++) this->TraceNode(index);
+
+		this->initialized = true;
+		Debug(yapf, 2, "Built rail junction graph: {} nodes, {} edges", this->num_nodes, this->num_edges);
+	}
+
+	/**
+	 * Bring the graph up to date with the track layout. Only the nodes on the changed
+	 * tiles and their neighbours, and the edges passing them, are created again.
+	 */
+	void Update()
+	{
+		if (!this->initialized) {
+			this->Build();
+			return;
+		}
+		if (this->dirty_tiles.empty()) return;
+
+		/* The moves from a position depend on its own tile, the neighbouring tiles and the other end of a tunnel or bridge.
+		 * The other end of a tunnel or bridge is as much changed as the reported end, so its neighbours are affected too. */
+		std::vector<TileIndex> tiles;
+		auto add_with_neighbours = [&tiles](TileIndex tile) {
+			tiles.push_back(tile);
+			for (DiagDirection dir = DIAGDIR_BEGIN; dir < DIAGDIR_END; dir++) {
+				TileIndex neighbour = AddTileIndexDiffCWrap(tile, TileIndexDiffCByDiagDir(dir));
+				if (neighbour != INVALID_TILE) tiles.push_back(neighbour);
+			}
+		};
+		for (TileIndex tile : this->dirty_tiles) {
+			add_with_neighbours(tile);
+			if (IsTileType(tile, MP_TUNNELBRIDGE)) add_with_neighbours(GetOtherTunnelBridgeEnd(tile));
+		}
+		std::sort(tiles.begin(), tiles.end());
+		tiles.erase(std::unique(tiles.begin(), tiles.end()), tiles.end());
+		this->dirty_tiles.clear();
+
+		/* Edges passing a changed tile might now go elsewhere. */
+		std::vector<uint32_t> retrace;
+		for (TileIndex tile : tiles) {
+			auto it = this->tile_edges.find(tile.base());
+			if (it == this->tile_edges.end()) continue;
+			std::vector<uint32_t> edges = it->second;
+			for (uint32_t edge : edges) {
+				retrace.push_back(this->edges[edge].from);
+				this->RemoveEdge(edge);
+			}
+		}
+
+		/* Positions on changed tiles might have become nodes, or stopped being one. */
+		for (TileIndex tile : tiles) {
+			for (Trackdir td = TRACKDIR_BEGIN; td < TRACKDIR_END; td++) {
+				auto it = this->node_index.find(GetRailStateKey(tile, td));
+				if (it != this->node_index.end()) this->RemoveNode(it->second);
+			}
+		}
+		for (TileIndex tile : tiles) {
+			for (Trackdir td : SetTrackdirBitIterator(GetRailTrackdirs(tile))) {
+				if (!IsNode(tile, td)) continue;
+				uint32_t key = GetRailStateKey(tile, td);
+				this->AddNode(key);
+				retrace.push_back(this->node_index[key]);
+			}
+		}
+
+		std::sort(retrace.begin(), retrace.end());
+		retrace.erase(std::unique(retrace.begin(), retrace.end()), retrace.end());
+		for (uint32_t index : retrace) {
+			if (this->nodes[index].key != INVALID_RAIL_JUNCTION) this->TraceNode(index);
+		}
+
+		this->version++;
+		Debug(yapf, 4, "Updated rail junction graph around {} tiles, traced {} nodes", tiles.size(), retrace.size());
+	}
+};
+
+static RailJunctionGraph _rail_junctions; ///< The graph of rail junctions.
+
+/** Distances from positions to a single destination, searched backwards from the destination on demand. */
+class RailJunctionDistances {
+	using QueueItem = std::pair<int, uint32_t>; ///< Distance and node of an item of the search.
+
+	uint64_t version;                ///< Version of the graph the distances are for.
+	std::vector<int> node_distances; ///< Shortest distance found so far per node.
+	std::vector<bool> settled;       ///< Whether the distance of a node is final.
+	std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue; ///< Nodes to search from.
+	std::unordered_map<uint32_t, int> state_distances; ///< Distances of positions that are not a node.
+
+	int GetNodeDistance(uint32_t index);
+
+public:
+	RailJunctionDistances(const std::vector<uint32_t> &destinations);
+
+	/**
+	 * Whether the distances are for the current graph.
+	 * @return True if the track layout has not been changed.
+	 */
+	inline bool IsUpToDate() const { return this->version == _rail_junctions.version; }
+
+	int GetDistance(TileIndex tile, Trackdir td);
+};
+
+/**
+ * Start searching the distances to a destination.
+ * @param destinations The positions a train can reach its destination at.
+ */
+RailJunctionDistances::RailJunctionDistances(const std::vector<uint32_t> &destinations) : version(_rail_junctions.version)
+{
+	this->node_distances.resize(_rail_junctions.nodes.size(), RAIL_JUNCTION_UNREACHABLE);
+	this->settled.resize(_rail_junctions.nodes.size(), false);
+
+	for (uint32_t key : destinations) {
+		auto node = _rail_junctions.node_index.find(key);
+		if (node == _rail_junctions.node_index.end()) continue;
+		this->node_distances[node->second] = 0;
+		this->queue.emplace(0, node->second);
+	}
+}
+
+/**
+ * Get the distance from a node to the destination, searching further if needed.
+ * @param index The node.
+ * @return The distance, or #RAIL_JUNCTION_UNREACHABLE.
+ */
+int RailJunctionDistances::GetNodeDistance(uint32_t index)
+{
+	while (!this->settled[index]) {
+		if (this->queue.empty()) return RAIL_JUNCTION_UNREACHABLE;
+
+		auto [distance, current] = this->queue.top();
+		this->queue.pop();
+		if (this->settled[current]) continue;
+		this->settled[current] = true;
+
+		for (uint32_t e : _rail_junctions.nodes[current].in) {
+			const RailJunctionEdge &edge = _rail_junctions.edges[e];
+			int new_distance = distance + edge.cost;
+			if (new_distance < this->node_distances[edge.from]) {
+				this->node_distances[edge.from] = new_distance;
+				this->queue.emplace(new_distance, edge.from);
+			}
+		}
+	}
+	return this->node_distances[index];
+}
+
+/**
+ * Get the distance from a position to the destination.
+ * @param tile Tile of the position.
+ * @param td Trackdir of the position.
+ * @return The distance, or #RAIL_JUNCTION_UNREACHABLE.
+ */
+int RailJunctionDistances::GetDistance(TileIndex tile, Trackdir td)
+{
+	assert(this->IsUpToDate());
+
+	uint32_t key = GetRailStateKey(tile, td);
+	auto node = _rail_junctions.node_index.find(key);
+	if (node != _rail_junctions.node_index.end()) return this->GetNodeDistance(node->second);
+
+	auto known = this->state_distances.find(key);
+	if (known != this->state_distances.end()) return known->second;
+
+	/* Positions that are not a node have only one way to go; follow it to the next node. */
+	std::vector<std::pair<uint32_t, int>> walked;
+	int cost = 0;
+	int result = RAIL_JUNCTION_UNREACHABLE;
+	RailJunctionStep step = { tile, td, 0 };
+	for (;;) {
+		walked.emplace_back(key, cost);
+		this->state_distances[key] = RAIL_JUNCTION_UNREACHABLE;
+
+		RailJunctionSteps next;
+		if (GetRailJunctionSteps(step.tile, step.td, next) != 1) break;
+		step = next[0];
+		cost += step.cost;
+		key = GetRailStateKey(step.tile, step.td);
+
+		int remaining;
+		node = _rail_junctions.node_index.find(key);
+		if (node != _rail_junctions.node_index.end()) {
+			remaining = this->GetNodeDistance(node->second);
+		} else {
+			known = this->state_distances.find(key);
+			/* Either already known, or a loop without any node. */
+			if (known == this->state_distances.end()) continue;
+			remaining = known->second;
+		}
+		if (remaining != RAIL_JUNCTION_UNREACHABLE) result = cost + remaining;
+		break;
+	}
+
+	for (const auto &[walked_key, walked_cost] : walked) {
+		this->state_distances[walked_key] = (result == RAIL_JUNCTION_UNREACHABLE) ? RAIL_JUNCTION_UNREACHABLE : result - walked_cost;
+	}
+	return this->state_distances[GetRailStateKey(tile, td)];
+}
+
+/**
+ * Get the distance from a position to the destination. This is a lower bound of the cost
+ * the rail pathfinder assigns to any path from there, and it satisfies the triangle inequality.
+ * @param tile Tile of the position.
+ * @param td Trackdir of the position.
+ * @return The distance, or #RAIL_JUNCTION_UNREACHABLE if no track leads to the destination.
+ */
+int RailJunctionDistanceField::GetDistance(TileIndex tile, Trackdir td)
+{
+	return this->distances->GetDistance(tile, td);
+}
+
+/** Distances of the recently used destinations, the most recently used last. */
+static std::vector<std::pair<uint64_t, std::shared_ptr<RailJunctionDistances>>> _rail_junction_distances;
+
+/**
+ * Get the distances to a destination, from the cache if possible.
+ * @param id Unique identifier of the destination.
+ * @param get_destinations Procedure to get the positions a train can reach its destination at.
+ * @return The distances.
+ */
+template <typename F>
+static RailJunctionDistanceField GetRailJunctionDistances(uint64_t id, F get_destinations)
+{
+	_rail_junctions.Update();
+	if (!_rail_junction_distances.empty() && !_rail_junction_distances.front().second->IsUpToDate()) _rail_junction_distances.clear();
+
+	auto it = std::find_if(_rail_junction_distances.begin(), _rail_junction_distances.end(), [id](const auto &item) { return item.first == id; });
+	if (it != _rail_junction_distances.end()) {
+		std::rotate(it, it + 1, _rail_junction_distances.end());
+	} else {
+		if (_rail_junction_distances.size() == MAX_RAIL_JUNCTION_DISTANCES) _rail_junction_distances.erase(_rail_junction_distances.begin());
+		_rail_junction_distances.emplace_back(id, std::make_shared<RailJunctionDistances>(get_destinations()));
+	}
+	return RailJunctionDistanceField(_rail_junction_distances.back().second);
+}
+
+/**
+ * Get the distances to a rail station or waypoint.
+ * @param station The station or waypoint.
+ * @return The distances to any of its platform tiles.
+ */
+RailJunctionDistanceField GetRailJunctionDistances(StationID station)
+{
+	return GetRailJunctionDistances((uint64_t{1} << 32) | station, [station]() {
+		std::vector<uint32_t> destinations;
+		for (TileIndex tile : BaseStation::Get(station)->train_station) {
+			if (!IsTileType(tile, MP_STATION) || !HasStationTileRail(tile) || GetStationIndex(tile) != station) continue;
+			Trackdir td = TrackToTrackdir(GetRailStationTrack(tile));
+			destinations.push_back(GetRailStateKey(tile, td));
+			destinations.push_back(GetRailStateKey(tile, ReverseTrackdir(td)));
+		}
+		return destinations;
+	});
+}
+
+/**
+ * Get the distances to a rail depot.
+ * @param depot Tile of the depot.
+ * @return The distances to the depot.
+ */
+RailJunctionDistanceField GetRailJunctionDistances(TileIndex depot)
+{
+	assert(IsRailDepotTile(depot));
+	return GetRailJunctionDistances(depot.base(), [depot]() {
+		std::vector<uint32_t> destinations;
+		for (Trackdir td : SetTrackdirBitIterator(GetRailTrackdirs(depot))) destinations.push_back(GetRailStateKey(depot, td));
+		return destinations;
+	});
+}
+
+/**
+ * Mark the graph around a tile as changed, after the track layout has been changed.
+ * @param tile The changed tile, or #INVALID_TILE when the whole map has been changed.
+ */
+void InvalidateRailJunctions(TileIndex tile)
+{
+	if (tile == INVALID_TILE) {
+		_rail_junctions.Clear();
+	} else if (_rail_junctions.initialized) {
+		_rail_junctions.dirty_tiles.push_back(tile);
+	}
+}
+
+/** Drop the graph and all distances, e.g. when a new map is allocated. */
+void AllocateRailJunctions()
+{
+	_rail_junctions.Clear();
+	_rail_junctions.nodes.shrink_to_fit();
+	_rail_junctions.edges.shrink_to_fit();
+	_rail_junction_distances.clear();
+}
+
+/** Print the size of the graph of rail junctions to the console. */
+void PrintRailJunctionDebugInfo()
+{
+	IConsolePrint(CC_DEFAULT, "  Rail junction graph: {} nodes, {} edges, {} tiles with edges{}",
+			_rail_junctions.num_nodes, _rail_junctions.num_edges, _rail_junctions.tile_edges.size(), _rail_junctions.initialized ? "" : " (not built)");
+	IConsolePrint(CC_DEFAULT, "  Destinations with known distances: {}", _rail_junction_distances.size());
+}
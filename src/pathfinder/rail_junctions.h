@@ -0,0 +1,52 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file rail_junctions.h Handles the graph of rail junctions that assists the rail pathfinder. */
+
+#ifndef RAIL_JUNCTIONS_H
+#define RAIL_JUNCTIONS_H
+
+#include "../tile_type.h"
+#include "../track_type.h"
+#include "../station_type.h"
+
+#include <memory>
+
+/** Distance returned for positions from which the destination cannot be reached at all. */
+static const int RAIL_JUNCTION_UNREACHABLE = INT_MAX;
+
+class RailJunctionDistances;
+
+/**
+ * Lower bounds of the distance to a single destination, taken from the graph of rail junctions.
+ * An instance stays valid, and keeps its cached distances, until the track layout changes.
+ */
+class RailJunctionDistanceField {
+	std::shared_ptr<RailJunctionDistances> distances; ///< The distances that are being searched.
+
+public:
+	RailJunctionDistanceField() {}
+	RailJunctionDistanceField(std::shared_ptr<RailJunctionDistances> distances) : distances(std::move(distances)) {}
+
+	/**
+	 * Whether there are distances to look up.
+	 * @return True if a destination has been set.
+	 */
+	inline bool IsValid() const { return this->distances != nullptr; }
+
+	int GetDistance(TileIndex tile, Trackdir td);
+};
+
+RailJunctionDistanceField GetRailJunctionDistances(StationID station);
+RailJunctionDistanceField GetRailJunctionDistances(TileIndex depot);
+
+void InvalidateRailJunctions(TileIndex tile);
+void AllocateRailJunctions();
+
+void PrintRailJunctionDebugInfo();
+
+#endif /* RAIL_JUNCTIONS_H */
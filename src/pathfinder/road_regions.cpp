@@ -0,0 +1,478 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file road_regions.cpp Handles dividing the roads in the map into square regions to assist pathfinding. */
+
+#include "stdafx.h"
+#include "map_func.h"
+#include "road_regions.h"
+#include "tilearea_type.h"
+#include "road_map.h"
+#include "tunnelbridge_map.h"
+#include "debug.h"
+
+#include "safeguards.h"
+
+using TRoadRegionTraversabilityBits = uint16_t;
+constexpr TRoadRegionPatchLabel FIRST_REGION_LABEL = 1;
+constexpr TRoadRegionPatchLabel INVALID_ROAD_REGION_PATCH = 0;
+
+static_assert(sizeof(TRoadRegionTraversabilityBits) * 8 == ROAD_REGION_EDGE_LENGTH);
+
+static inline int GetRoadRegionX(TileIndex tile) { return TileX(tile) / ROAD_REGION_EDGE_LENGTH; }
+static inline int GetRoadRegionY(TileIndex tile) { return TileY(tile) / ROAD_REGION_EDGE_LENGTH; }
+
+static inline int GetRoadRegionMapSizeX() { return Map::SizeX() / ROAD_REGION_EDGE_LENGTH; }
+static inline int GetRoadRegionMapSizeY() { return Map::SizeY() / ROAD_REGION_EDGE_LENGTH; }
+
+static inline TRoadRegionIndex GetRoadRegionIndex(int region_x, int region_y) { return GetRoadRegionMapSizeX() * region_y + region_x; }
+
+/** Incremented whenever road regions get connected or disconnected; network IDs of older versions are outdated. */
+static uint64_t _road_network_version = 1;
+/** Last network ID that has been handed out. */
+static TRoadNetworkID _last_road_network_id = INVALID_ROAD_NETWORK;
+
+/**
+ * Get the road bits of a tile, with tunnels and bridges only having the road bit of their entrance.
+ * @param tile The tile to get the road bits of.
+ * @param rtt Whether to get the road or the tram track.
+ * @return The road bits.
+ */
+static inline RoadBits GetRegionRoadBits(TileIndex tile, RoadTramType rtt) { return GetAnyRoadBits(tile, rtt, false); }
+
+/**
+ * Whether two neighbouring tiles are connected by road, regardless of one way roads, road types and owners.
+ * @param tile The tile to move from.
+ * @param side The side of the tile to move over.
+ * @param rtt Whether to check the road or the tram track.
+ * @return The tile that can be reached, or INVALID_TILE.
+ */
+static inline TileIndex GetConnectedRoadTile(TileIndex tile, DiagDirection side, RoadTramType rtt)
+{
+	if ((GetRegionRoadBits(tile, rtt) & DiagDirToRoadBits(side)) == ROAD_NONE) return INVALID_TILE;
+	TileIndex neighbour = AddTileIndexDiffCWrap(tile, TileIndexDiffCByDiagDir(side));
+	if (neighbour == INVALID_TILE || (GetRegionRoadBits(neighbour, rtt) & DiagDirToRoadBits(ReverseDiagDir(side))) == ROAD_NONE) return INVALID_TILE;
+	return neighbour;
+}
+
+/**
+ * Represents a square section of the map of a fixed size. Within this square individual unconnected patches of road
+ * are identified using a Connected Component Labeling (CCL) algorithm, separately for road and tram track. As with
+ * water regions, all information stored in this class applies only to tiles within the square section, plus the
+ * first tile of the neighbouring regions.
+ *
+ * Road vehicles can turn around on almost any road, so patches do not take one way roads into account; two
+ * patches are either connected in both directions or not at all.
+ */
+class RoadRegion
+{
+private:
+	/** Connected component labels and connections of either road or tram track. */
+	struct Layer {
+		std::array<TRoadRegionTraversabilityBits, DIAGDIR_END> edge_traversability_bits{};
+		TRoadRegionPatchLabel number_of_patches = 0; // 0 = no road, 1 = one single patch of road, etc...
+		std::array<TRoadRegionPatchLabel, ROAD_REGION_NUMBER_OF_TILES> tile_patch_labels{};
+		std::vector<std::pair<TRoadRegionPatchLabel, TileIndex>> cross_region_links; ///< Other ends of tunnels and bridges leaving the region, per patch.
+		std::vector<std::pair<uint64_t, TRoadNetworkID>> networks; ///< Version and ID of the network of each patch.
+
+		/**
+		 * Whether the patches of the layer connect to the same tiles outside of the region as another layer.
+		 * @param other The other layer.
+		 * @return True if the networks of the patches are unaffected by changing between the layers.
+		 */
+		bool HasSameConnections(const Layer &other) const
+		{
+			if (this->number_of_patches != other.number_of_patches || this->cross_region_links != other.cross_region_links) return false;
+			if (this->edge_traversability_bits != other.edge_traversability_bits) return false;
+
+			/* Patches connecting to the edges must keep their label. */
+			for (int i = 0; i < ROAD_REGION_EDGE_LENGTH; i++) {
+				const int edges[] = { i * ROAD_REGION_EDGE_LENGTH, i * ROAD_REGION_EDGE_LENGTH + ROAD_REGION_EDGE_LENGTH - 1, i, ROAD_REGION_NUMBER_OF_TILES - ROAD_REGION_EDGE_LENGTH + i };
+				for (int index : edges) {
+					if (this->tile_patch_labels[index] != other.tile_patch_labels[index]) return false;
+				}
+			}
+			return true;
+		}
+	};
+
+	std::array<Layer, 2> layers;
+	const OrthogonalTileArea tile_area;
+	bool initialized = false;
+	bool dirty = false;
+
+	/**
+	 * Returns the local index of the tile within the region. The N corner represents 0,
+	 * the x direction is positive in the SW direction, and Y is positive in the SE direction.
+	 * @param tile Tile within the road region.
+	 * @returns The local index.
+	 */
+	inline int GetLocalIndex(TileIndex tile) const
+	{
+		assert(this->tile_area.Contains(tile));
+		return (TileX(tile) - TileX(this->tile_area.tile)) + ROAD_REGION_EDGE_LENGTH * (TileY(tile) - TileY(this->tile_area.tile));
+	}
+
+	/**
+	 * Performs the connected component labeling of a single layer.
+	 * @param rtt Whether to label the road or the tram track.
+	 */
+	void UpdateLayer(RoadTramType rtt)
+	{
+		Layer &layer = this->layers[rtt];
+		layer.tile_patch_labels.fill(INVALID_ROAD_REGION_PATCH);
+		layer.edge_traversability_bits.fill(0);
+		layer.cross_region_links.clear();
+
+		TRoadRegionPatchLabel current_label = 1;
+		TRoadRegionPatchLabel highest_assigned_label = 0;
+
+		/* Perform connected component labeling. This uses a flooding algorithm that expands until no
+		 * additional tiles can be added. Only tiles inside the road region are considered. */
+		for (const TileIndex start_tile : this->tile_area) {
+			static std::vector<TileIndex> tiles_to_check;
+			tiles_to_check.clear();
+			tiles_to_check.push_back(start_tile);
+
+			bool increase_label = false;
+			while (!tiles_to_check.empty()) {
+				const TileIndex tile = tiles_to_check.back();
+				tiles_to_check.pop_back();
+
+				if (GetRegionRoadBits(tile, rtt) == ROAD_NONE) continue;
+				if (layer.tile_patch_labels[GetLocalIndex(tile)] != INVALID_ROAD_REGION_PATCH) continue;
+
+				layer.tile_patch_labels[GetLocalIndex(tile)] = current_label;
+				highest_assigned_label = current_label;
+				increase_label = true;
+
+				for (DiagDirection side = DIAGDIR_BEGIN; side < DIAGDIR_END; side++) {
+					const TileIndex neighbour = GetConnectedRoadTile(tile, side, rtt);
+					if (neighbour == INVALID_TILE) continue;
+					if (this->tile_area.Contains(neighbour)) {
+						tiles_to_check.push_back(neighbour);
+					} else {
+						const int local_x_or_y = DiagDirToAxis(side) == AXIS_X ? TileY(tile) - TileY(this->tile_area.tile) : TileX(tile) - TileX(this->tile_area.tile);
+						SetBit(layer.edge_traversability_bits[side], local_x_or_y);
+					}
+				}
+
+				if (IsTileType(tile, MP_TUNNELBRIDGE)) {
+					const TileIndex other_end = GetOtherTunnelBridgeEnd(tile);
+					if (this->tile_area.Contains(other_end)) {
+						tiles_to_check.push_back(other_end);
+					} else {
+						layer.cross_region_links.emplace_back(current_label, other_end);
+					}
+				}
+			}
+
+			if (increase_label) current_label++;
+		}
+
+		layer.number_of_patches = highest_assigned_label;
+	}
+
+public:
+	RoadRegion(int region_x, int region_y)
+		: tile_area(TileXY(region_x * ROAD_REGION_EDGE_LENGTH, region_y * ROAD_REGION_EDGE_LENGTH), ROAD_REGION_EDGE_LENGTH, ROAD_REGION_EDGE_LENGTH)
+	{}
+
+	OrthogonalTileIterator begin() const { return this->tile_area.begin(); }
+	OrthogonalTileIterator end() const { return this->tile_area.end(); }
+
+	bool IsInitialized() const { return this->initialized; }
+
+	/**
+	 * Marks the region as changed.
+	 * @return True if the region has to be added to the list of changed regions.
+	 */
+	bool Invalidate()
+	{
+		if (!this->initialized || this->dirty) return false;
+		Debug(map, 3, "Invalidated road region ({},{})", GetRoadRegionX(this->tile_area.tile), GetRoadRegionY(this->tile_area.tile));
+		this->dirty = true;
+		return true;
+	}
+
+	TRoadRegionTraversabilityBits GetEdgeTraversabilityBits(RoadTramType rtt, DiagDirection side) const { return this->layers[rtt].edge_traversability_bits[side]; }
+	int NumberOfPatches(RoadTramType rtt) const { return this->layers[rtt].number_of_patches; }
+	const std::vector<std::pair<TRoadRegionPatchLabel, TileIndex>> &GetCrossRegionLinks(RoadTramType rtt) const { return this->layers[rtt].cross_region_links; }
+
+	/**
+	 * Returns the patch label that was assigned to the tile.
+	 * @param rtt Whether to get the label of the road or the tram track.
+	 * @param tile The tile of which we want to retrieve the label.
+	 * @returns The label assigned to the tile.
+	 */
+	TRoadRegionPatchLabel GetLabel(RoadTramType rtt, TileIndex tile) const
+	{
+		assert(this->tile_area.Contains(tile));
+		return this->layers[rtt].tile_patch_labels[GetLocalIndex(tile)];
+	}
+
+	/**
+	 * Get the network of a patch, as far as it is known.
+	 * @param rtt Whether to get the network of the road or the tram track.
+	 * @param label The patch.
+	 * @return The version and the ID of the network.
+	 */
+	std::pair<uint64_t, TRoadNetworkID> &GetNetwork(RoadTramType rtt, TRoadRegionPatchLabel label)
+	{
+		return this->layers[rtt].networks[label];
+	}
+
+	/**
+	 * Performs the connected component labeling of the road and tram track. When a changed region
+	 * connects differently to its neighbours than before, all known networks become outdated.
+	 */
+	void ForceUpdate()
+	{
+		Debug(map, 3, "Updating road region ({},{})", GetRoadRegionX(this->tile_area.tile), GetRoadRegionY(this->tile_area.tile));
+
+		for (RoadTramType rtt : _roadtramtypes) {
+			Layer old_layer;
+			if (this->initialized) old_layer = this->layers[rtt];
+
+			this->UpdateLayer(rtt);
+
+			Layer &layer = this->layers[rtt];
+			if (this->initialized && layer.HasSameConnections(old_layer)) {
+				layer.networks = std::move(old_layer.networks);
+			} else {
+				if (this->initialized) _road_network_version++;
+				layer.networks.assign(layer.number_of_patches + 1, { 0, INVALID_ROAD_NETWORK });
+			}
+		}
+
+		this->initialized = true;
+		this->dirty = false;
+	}
+
+	/**
+	 * Updates the patch labels and other data, but only if the region is not yet initialized.
+	 */
+	inline void UpdateIfNotInitialized()
+	{
+		if (!this->initialized) ForceUpdate();
+	}
+};
+
+static std::vector<RoadRegion> _road_regions;
+static std::vector<TRoadRegionIndex> _dirty_road_regions; ///< Regions that have been invalidated since they were last updated.
+
+static TileIndex GetTileIndexFromLocalCoordinate(int region_x, int region_y, int local_x, int local_y)
+{
+	assert(local_x >= 0 && local_x < ROAD_REGION_EDGE_LENGTH);
+	assert(local_y >= 0 && local_y < ROAD_REGION_EDGE_LENGTH);
+	return TileXY(ROAD_REGION_EDGE_LENGTH * region_x + local_x, ROAD_REGION_EDGE_LENGTH * region_y + local_y);
+}
+
+static TileIndex GetEdgeTileCoordinate(int region_x, int region_y, DiagDirection side, int x_or_y)
+{
+	assert(x_or_y >= 0 && x_or_y < ROAD_REGION_EDGE_LENGTH);
+	switch (side) {
+		case DIAGDIR_NE: return GetTileIndexFromLocalCoordinate(region_x, region_y, 0, x_or_y);
+		case DIAGDIR_SW: return GetTileIndexFromLocalCoordinate(region_x, region_y, ROAD_REGION_EDGE_LENGTH - 1, x_or_y);
+		case DIAGDIR_NW: return GetTileIndexFromLocalCoordinate(region_x, region_y, x_or_y, 0);
+		case DIAGDIR_SE: return GetTileIndexFromLocalCoordinate(region_x, region_y, x_or_y, ROAD_REGION_EDGE_LENGTH - 1);
+		default: NOT_REACHED();
+	}
+}
+
+static RoadRegion &GetUpdatedRoadRegion(uint16_t region_x, uint16_t region_y)
+{
+	RoadRegion &result = _road_regions[GetRoadRegionIndex(region_x, region_y)];
+	result.UpdateIfNotInitialized();
+	return result;
+}
+
+static RoadRegion &GetUpdatedRoadRegion(TileIndex tile)
+{
+	RoadRegion &result = _road_regions[GetRoadRegionIndex(tile)];
+	result.UpdateIfNotInitialized();
+	return result;
+}
+
+/** Update all regions that have been changed, so the known networks are either still correct or outdated. */
+static void UpdateDirtyRoadRegions()
+{
+	for (TRoadRegionIndex index : _dirty_road_regions) _road_regions[index].ForceUpdate();
+	_dirty_road_regions.clear();
+}
+
+/**
+ * Returns the index of the road region a tile is part of.
+ * @param tile The tile to get the road region of.
+ * @return The index of the road region.
+ */
+TRoadRegionIndex GetRoadRegionIndex(TileIndex tile)
+{
+	return GetRoadRegionIndex(GetRoadRegionX(tile), GetRoadRegionY(tile));
+}
+
+/**
+ * Returns road region patch information for the provided tile.
+ * @param tile The tile for which the information will be calculated.
+ * @param rtt Whether to get the patch of the road or the tram track.
+ */
+RoadRegionPatchDesc GetRoadRegionPatchInfo(TileIndex tile, RoadTramType rtt)
+{
+	const RoadRegion &region = GetUpdatedRoadRegion(tile);
+	return RoadRegionPatchDesc{ GetRoadRegionX(tile), GetRoadRegionY(tile), region.GetLabel(rtt, tile) };
+}
+
+/**
+ * Marks the road region that tile is part of as invalid.
+ * @param tile Tile within the road region that we wish to invalidate.
+ */
+void InvalidateRoadRegion(TileIndex tile)
+{
+	if (!IsValidTile(tile)) return;
+	const TRoadRegionIndex road_region_index = GetRoadRegionIndex(tile);
+	if (_road_regions[road_region_index].Invalidate()) _dirty_road_regions.push_back(road_region_index);
+
+	/* When updating the road region we look into the first tile of adjacent road regions to determine edge
+	 * traversability. This means that if we invalidate any region edge tiles we might also change the traversability
+	 * of the adjacent region. This code ensures the adjacent regions also get invalidated in such a case. */
+	for (DiagDirection side = DIAGDIR_BEGIN; side < DIAGDIR_END; side++) {
+		const TileIndex neighbour = AddTileIndexDiffCWrap(tile, TileIndexDiffCByDiagDir(side));
+		if (neighbour == INVALID_TILE) continue;
+		const TRoadRegionIndex adjacent_region_index = GetRoadRegionIndex(neighbour);
+		if (adjacent_region_index != road_region_index && _road_regions[adjacent_region_index].Invalidate()) _dirty_road_regions.push_back(adjacent_region_index);
+	}
+}
+
+/**
+ * Calls the provided callback function for all road region patches
+ * accessible from one particular side of the starting patch.
+ * @param road_region_patch Road patch within the road region to start searching from
+ * @param rtt Whether to look at the road or the tram track.
+ * @param side Side of the road region to look for neigboring patches of road
+ * @param func The function that will be called for each neighbor that is found
+ */
+static inline void VisitAdjacentRoadRegionPatchNeighbors(const RoadRegionPatchDesc &road_region_patch, RoadTramType rtt, DiagDirection side, TVisitRoadRegionPatchCallBack &func)
+{
+	const RoadRegion &current_region = GetUpdatedRoadRegion(road_region_patch.x, road_region_patch.y);
+
+	const TileIndexDiffC offset = TileIndexDiffCByDiagDir(side);
+	const int nx = road_region_patch.x + offset.x;
+	const int ny = road_region_patch.y + offset.y;
+
+	if (nx < 0 || ny < 0 || nx >= GetRoadRegionMapSizeX() || ny >= GetRoadRegionMapSizeY()) return;
+
+	const RoadRegion &neighboring_region = GetUpdatedRoadRegion(nx, ny);
+	const DiagDirection opposite_side = ReverseDiagDir(side);
+
+	/* Indicates via which local x or y coordinates (depends on the "side" parameter) we can cross over into the adjacent region. */
+	const TRoadRegionTraversabilityBits traversability_bits = current_region.GetEdgeTraversabilityBits(rtt, side)
+		& neighboring_region.GetEdgeTraversabilityBits(rtt, opposite_side);
+	if (traversability_bits == 0) return;
+
+	if (current_region.NumberOfPatches(rtt) == 1 && neighboring_region.NumberOfPatches(rtt) == 1) {
+		func(RoadRegionPatchDesc{ nx, ny, FIRST_REGION_LABEL }); // No further checks needed because we know there is just one patch for both adjacent regions
+		return;
+	}
+
+	/* Multiple road patches can be reached from the current patch. Check each edge tile individually. */
+	static std::vector<TRoadRegionPatchLabel> unique_labels; // static and vector-instead-of-map for performance reasons
+	unique_labels.clear();
+	for (int x_or_y = 0; x_or_y < ROAD_REGION_EDGE_LENGTH; ++x_or_y) {
+		if (!HasBit(traversability_bits, x_or_y)) continue;
+
+		const TileIndex current_edge_tile = GetEdgeTileCoordinate(road_region_patch.x, road_region_patch.y, side, x_or_y);
+		const TRoadRegionPatchLabel current_label = current_region.GetLabel(rtt, current_edge_tile);
+		if (current_label != road_region_patch.label) continue;
+
+		const TileIndex neighbor_edge_tile = GetEdgeTileCoordinate(nx, ny, opposite_side, x_or_y);
+		const TRoadRegionPatchLabel neighbor_label = neighboring_region.GetLabel(rtt, neighbor_edge_tile);
+		if (std::find(unique_labels.begin(), unique_labels.end(), neighbor_label) == unique_labels.end()) unique_labels.push_back(neighbor_label);
+	}
+	for (TRoadRegionPatchLabel unique_label : unique_labels) func(RoadRegionPatchDesc{ nx, ny, unique_label });
+}
+
+/**
+ * Calls the provided callback function on all accessible road region patches in
+ * each cardinal direction, plus any others that are reachable via tunnels and bridges.
+ * @param road_region_patch Road patch within the road region to start searching from
+ * @param rtt Whether to look at the road or the tram track.
+ * @param callback The function that will be called for each accessible road patch that is found
+ */
+void VisitRoadRegionPatchNeighbors(const RoadRegionPatchDesc &road_region_patch, RoadTramType rtt, TVisitRoadRegionPatchCallBack &callback)
+{
+	const RoadRegion &current_region = GetUpdatedRoadRegion(road_region_patch.x, road_region_patch.y);
+
+	/* Visit adjacent road region patches in each cardinal direction */
+	for (DiagDirection side = DIAGDIR_BEGIN; side < DIAGDIR_END; side++) VisitAdjacentRoadRegionPatchNeighbors(road_region_patch, rtt, side, callback);
+
+	/* Visit neigboring road patches accessible via cross-region tunnels and bridges */
+	for (const auto &[label, other_end] : current_region.GetCrossRegionLinks(rtt)) {
+		if (label == road_region_patch.label) callback(GetRoadRegionPatchInfo(other_end, rtt));
+	}
+}
+
+/**
+ * Get the network of connected road or tram track a tile is part of. Two tiles with
+ * the same network are connected, ignoring one way roads, road types and owners.
+ * Tiles with different networks can never be reached from each other.
+ * @param tile The tile to get the network of.
+ * @param rtt Whether to get the network of the road or the tram track.
+ * @return The network, or #INVALID_ROAD_NETWORK if the tile has no road or tram track.
+ */
+TRoadNetworkID GetRoadNetworkID(TileIndex tile, RoadTramType rtt)
+{
+	if (!IsValidTile(tile)) return INVALID_ROAD_NETWORK;
+	UpdateDirtyRoadRegions();
+
+	const RoadRegionPatchDesc start = GetRoadRegionPatchInfo(tile, rtt);
+	if (start.label == INVALID_ROAD_REGION_PATCH) return INVALID_ROAD_NETWORK;
+
+	auto &start_network = _road_regions[GetRoadRegionIndex(start.x, start.y)].GetNetwork(rtt, start.label);
+	if (start_network.first == _road_network_version) return start_network.second;
+
+	/* Flood all patches that can be reached with a new network. Regions that are updated on the way
+	 * have never been updated before, so this does not change the version. */
+	const TRoadNetworkID network = ++_last_road_network_id;
+	const uint64_t version = _road_network_version;
+	start_network = { version, network };
+
+	std::vector<RoadRegionPatchDesc> patches_to_check = { start };
+	TVisitRoadRegionPatchCallBack visit_func = [&](const RoadRegionPatchDesc &neighbour) {
+		auto &neighbour_network = _road_regions[GetRoadRegionIndex(neighbour.x, neighbour.y)].GetNetwork(rtt, neighbour.label);
+		if (neighbour_network.first == version) return;
+		neighbour_network = { version, network };
+		patches_to_check.push_back(neighbour);
+	};
+	while (!patches_to_check.empty()) {
+		const RoadRegionPatchDesc patch = patches_to_check.back();
+		patches_to_check.pop_back();
+		VisitRoadRegionPatchNeighbors(patch, rtt, visit_func);
+	}
+	assert(version == _road_network_version);
+
+	Debug(map, 4, "Flooded road network {} from road region ({},{})", network, start.x, start.y);
+	return network;
+}
+
+/**
+ * Allocates the appropriate amount of road regions for the current map size
+ */
+void AllocateRoadRegions()
+{
+	_road_regions.clear();
+	_dirty_road_regions.clear();
+	_road_regions.reserve(static_cast<size_t>(GetRoadRegionMapSizeX()) * GetRoadRegionMapSizeY());
+	_road_network_version++;
+
+	Debug(map, 2, "Allocating {} x {} road regions", GetRoadRegionMapSizeX(), GetRoadRegionMapSizeY());
+
+	for (int region_y = 0; region_y < GetRoadRegionMapSizeY(); region_y++) {
+		for (int region_x = 0; region_x < GetRoadRegionMapSizeX(); region_x++) {
+			_road_regions.emplace_back(region_x, region_y);
+		}
+	}
+}
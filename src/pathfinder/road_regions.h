@@ -0,0 +1,54 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+ /** @file road_regions.h Handles dividing the roads in the map into regions to assist pathfinding. */
+
+#ifndef ROAD_REGIONS_H
+#define ROAD_REGIONS_H
+
+#include "tile_type.h"
+#include "map_func.h"
+#include "road.h"
+
+#include <functional>
+
+using TRoadRegionPatchLabel = uint8_t;
+using TRoadRegionIndex = uint;
+using TRoadNetworkID = uint32_t;
+
+constexpr int ROAD_REGION_EDGE_LENGTH = 16;
+constexpr int ROAD_REGION_NUMBER_OF_TILES = ROAD_REGION_EDGE_LENGTH * ROAD_REGION_EDGE_LENGTH;
+
+/** Network of tiles without any road, which is not connected to anything. */
+constexpr TRoadNetworkID INVALID_ROAD_NETWORK = 0;
+
+/**
+ * Describes a single interconnected patch of road or tram track within a particular road region.
+ */
+struct RoadRegionPatchDesc
+{
+	int x; ///< The X coordinate of the road region, i.e. X=2 is the 3rd road region along the X-axis
+	int y; ///< The Y coordinate of the road region, i.e. Y=2 is the 3rd road region along the Y-axis
+	TRoadRegionPatchLabel label; ///< Unique label identifying the patch within the region
+
+	bool operator==(const RoadRegionPatchDesc &other) const { return x == other.x && y == other.y && label == other.label; }
+	bool operator!=(const RoadRegionPatchDesc &other) const { return !(*this == other); }
+};
+
+TRoadRegionIndex GetRoadRegionIndex(TileIndex tile);
+
+RoadRegionPatchDesc GetRoadRegionPatchInfo(TileIndex tile, RoadTramType rtt);
+TRoadNetworkID GetRoadNetworkID(TileIndex tile, RoadTramType rtt);
+
+void InvalidateRoadRegion(TileIndex tile);
+
+using TVisitRoadRegionPatchCallBack = std::function<void(const RoadRegionPatchDesc &)>;
+void VisitRoadRegionPatchNeighbors(const RoadRegionPatchDesc &road_region_patch, RoadTramType rtt, TVisitRoadRegionPatchCallBack &callback);
+
+void AllocateRoadRegions();
+
+#endif /* ROAD_REGIONS_H */
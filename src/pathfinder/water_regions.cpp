@@ -212,6 +212,7 @@ public:
 };
 
 std::vector<WaterRegion> _water_regions;
+uint32_t _water_regions_version = 0; ///< Changed whenever any water region is invalidated.
 
 TileIndex GetTileIndexFromLocalCoordinate(int region_x, int region_y, int local_x, int local_y)
 {
@@ -293,6 +294,16 @@ WaterRegionPatchDesc GetWaterRegionPatchInfo(TileIndex tile)
 	return WaterRegionPatchDesc{ GetWaterRegionX(tile), GetWaterRegionY(tile), region.GetLabel(tile)};
 }
 
+/**
+ * Get the version of the water regions. Any result derived from the water regions is
+ * still valid as long as the version did not change.
+ * @return The version of the water regions.
+ */
+uint32_t GetWaterRegionsVersion()
+{
+	return _water_regions_version;
+}
+
 /**
  * Marks the water region that tile is part of as invalid.
  * @param tile Tile within the water region that we wish to invalidate.
@@ -302,6 +313,7 @@ void InvalidateWaterRegion(TileIndex tile)
 	if (!IsValidTile(tile)) return;
 	const int water_region_index = GetWaterRegionIndex(tile);
 	_water_regions[water_region_index].Invalidate();
+	_water_regions_version++;
 
 	/* When updating the water region we look into the first tile of adjacent water regions to determine edge
 	 * traversability. This means that if we invalidate any region edge tiles we might also change the traversability
@@ -389,6 +401,7 @@ void VisitWaterRegionPatchNeighbors(const WaterRegionPatchDesc &water_region_pat
 void AllocateWaterRegions()
 {
 	_water_regions.clear();
+	_water_regions_version++;
 	_water_regions.reserve(static_cast<size_t>(GetWaterRegionMapSizeX()) * GetWaterRegionMapSizeY());
 
 	Debug(map, 2, "Allocating {} x {} water regions", GetWaterRegionMapSizeX(), GetWaterRegionMapSizeY());
@@ -57,6 +57,7 @@ TileIndex GetWaterRegionCenterTile(const WaterRegionDesc &water_region);
 WaterRegionDesc GetWaterRegionInfo(TileIndex tile);
 WaterRegionPatchDesc GetWaterRegionPatchInfo(TileIndex tile);
 
+uint32_t GetWaterRegionsVersion();
 void InvalidateWaterRegion(TileIndex tile);
 
 using TVisitWaterRegionPatchCallBack = std::function<void(const WaterRegionPatchDesc &)>;
@@ -19,4 +19,17 @@
  */
 void YapfNotifyTrackLayoutChange(TileIndex tile, Track track);
 
+/** Statistics of the caches of rail segment costs. */
+struct YapfSegmentCacheStats {
+	uint64_t hits = 0;          ///< Number of times the cost of a segment was taken from a cache.
+	uint64_t misses = 0;        ///< Number of times the cost of a segment had to be calculated for a cache.
+	uint64_t invalidated = 0;   ///< Number of cached segment costs dropped due to a change of the track layout near them.
+	uint64_t flushed = 0;       ///< Number of cached segment costs dropped due to flushing a whole cache.
+	uint64_t flushes = 0;       ///< Number of times a whole cache was flushed.
+	size_t segments = 0;        ///< Number of segments currently stored in the caches.
+	size_t index_entries = 0;   ///< Number of entries currently in the tile indices of the caches.
+};
+
+YapfSegmentCacheStats YapfGetSegmentCacheStats();
+
 #endif /* YAPF_CACHE_H */
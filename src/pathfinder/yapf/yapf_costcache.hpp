@@ -11,6 +11,9 @@
 #define YAPF_COSTCACHE_HPP
 
 #include "../../timer/timer_game_calendar.h"
+#include "yapf_cache.h"
+
+#include <unordered_map>
 
 /**
  * CYapfSegmentCostCacheNoneT - the formal only yapf cost cache provider that implements
@@ -40,6 +43,14 @@ public:
 	inline void PfNodeCacheFlush(Node &)
 	{
 	}
+
+	/**
+	 * Called by the cost provider when the segment cost of the given node has been calculated.
+	 *  There is no cache to store it in.
+	 */
+	inline void PfNodeCacheStore(Node &, const std::vector<TileIndex> &)
+	{
+	}
 };
 
 
@@ -87,6 +98,14 @@ public:
 	inline void PfNodeCacheFlush(Node &)
 	{
 	}
+
+	/**
+	 * Called by the cost provider when the segment cost of the given node has been calculated.
+	 *  Local data does not outlive the pathfinder run, so there is nothing to invalidate later.
+	 */
+	inline void PfNodeCacheStore(Node &, const std::vector<TileIndex> &)
+	{
+	}
 };
 
 
@@ -100,10 +119,36 @@ public:
 struct CSegmentCostCacheBase
 {
 	static int   s_rail_change_counter;
+	static std::vector<CSegmentCostCacheBase *> s_caches; ///< All segment cost caches, to notify them of changed tiles.
+	static YapfSegmentCacheStats s_stats;                 ///< Statistics of all segment cost caches together.
 
-	static void NotifyTrackLayoutChange(TileIndex, Track)
+	inline CSegmentCostCacheBase()
 	{
-		s_rail_change_counter++;
+		s_caches.push_back(this);
+	}
+
+	virtual ~CSegmentCostCacheBase()
+	{
+		s_caches.erase(std::find(s_caches.begin(), s_caches.end(), this));
+	}
+
+	/**
+	 * Drop the cached cost of all segments that contain the given tile, or end next to it.
+	 * @param tile The tile that changed.
+	 */
+	virtual void InvalidateTile(TileIndex tile) = 0;
+
+	/** Get the number of segments and tile index entries in this cache. */
+	virtual void AddSizes(YapfSegmentCacheStats &stats) const = 0;
+
+	static void NotifyTrackLayoutChange(TileIndex tile, Track)
+	{
+		if (tile == INVALID_TILE) {
+			/* Unknown what changed, so flush everything. */
+			s_rail_change_counter++;
+			return;
+		}
+		for (CSegmentCostCacheBase *cache : s_caches) cache->InvalidateTile(tile);
 	}
 };
 
@@ -117,25 +162,42 @@ struct CSegmentCostCacheBase
  *  of the segment (origin tile and exit-dir from this tile).
  *  Different CYapfCachedCostT types can share the same type of CSegmentCostCacheT.
  *  Look at CYapfRailSegment (yapf_node_rail.hpp) for the segment example
+ *
+ *  Besides that it keeps an index from tiles to the segments that cover them, so a
+ *  change of the track layout only drops the segments that are affected by it. The
+ *  dropped segments stay in the hash-map and storage, as nodes of a running or just
+ *  finished search may still point to them; they are recalculated on their next use.
  */
 template <class Tsegment>
 struct CSegmentCostCacheT : public CSegmentCostCacheBase {
 	static const int C_HASH_BITS = 14;
+	/** Number of entries in the tile index after which the whole cache is flushed, to get rid of stale entries. */
+	static const size_t C_MAX_INDEX_ENTRIES = 1 << 21;
 
 	typedef CHashTableT<Tsegment, C_HASH_BITS> HashTable;
 	typedef SmallArray<Tsegment> Heap;
 	typedef typename Tsegment::Key Key;    ///< key to hash table
+	typedef std::unordered_map<uint32_t, std::vector<Tsegment *>> TileIndexMap;
 
 	HashTable    m_map;
 	Heap         m_heap;
+	TileIndexMap m_tile_index;        ///< Segments per tile that they cover; may contain duplicates and segments that do not cover the tile anymore.
+	size_t       m_tile_index_entries = 0; ///< Number of segments in #m_tile_index.
 
 	inline CSegmentCostCacheT() {}
 
 	/** flush (clear) the cache */
 	inline void Flush()
 	{
+		for (uint i = 0; i < m_heap.Length(); i++) {
+			if (m_heap[i].m_cost >= 0) s_stats.flushed++;
+		}
+		s_stats.flushes++;
+
 		m_map.Clear();
 		m_heap.Clear();
+		m_tile_index.clear();
+		m_tile_index_entries = 0;
 	}
 
 	inline Tsegment &Get(Key &key, bool *found)
@@ -146,10 +208,48 @@ struct CSegmentCostCacheT : public CSegmentCostCacheBase {
 			item = new (m_heap.Append()) Tsegment(key);
 			m_map.Push(*item);
 		} else {
-			*found = true;
+			*found = item->m_cost >= 0;
 		}
 		return *item;
 	}
+
+	/**
+	 * Register the tiles whose change invalidates the cost of a segment.
+	 * @param segment The segment with a freshly calculated cost.
+	 * @param tiles The tiles it covers, and the tile where it could have continued.
+	 */
+	void AddTiles(Tsegment &segment, const std::vector<TileIndex> &tiles)
+	{
+		if (m_tile_index_entries + tiles.size() > C_MAX_INDEX_ENTRIES) {
+			/* Too many stale entries; the whole cache gets flushed before the next search, so skip registering. */
+			s_rail_change_counter++;
+			return;
+		}
+		for (TileIndex tile : tiles) {
+			m_tile_index[tile.base()].push_back(&segment);
+		}
+		m_tile_index_entries += tiles.size();
+	}
+
+	void InvalidateTile(TileIndex tile) override
+	{
+		auto it = m_tile_index.find(tile.base());
+		if (it == m_tile_index.end()) return;
+
+		for (Tsegment *segment : it->second) {
+			if (segment->m_cost < 0) continue;
+			segment->Invalidate();
+			s_stats.invalidated++;
+		}
+		m_tile_index_entries -= it->second.size();
+		m_tile_index.erase(it);
+	}
+
+	void AddSizes(YapfSegmentCacheStats &stats) const override
+	{
+		stats.segments += m_heap.Length();
+		stats.index_entries += m_tile_index_entries;
+	}
 };
 
 /**
@@ -206,6 +306,11 @@ public:
 		bool found;
 		CachedData &item = m_global_cache.Get(key, &found);
 		Yapf().ConnectNodeToCachedData(n, item);
+		if (found) {
+			Cache::s_stats.hits++;
+		} else {
+			Cache::s_stats.misses++;
+		}
 		return found;
 	}
 
@@ -216,6 +321,18 @@ public:
 	inline void PfNodeCacheFlush(Node &)
 	{
 	}
+
+	/**
+	 * Called by the cost provider when the segment cost of the given node has been calculated.
+	 *  Remembers the tiles of the segment, so the cost gets dropped when one of them changes.
+	 * @param n The node with the calculated segment.
+	 * @param tiles The tiles covered by the segment, and the tile where it could have continued.
+	 */
+	inline void PfNodeCacheStore(Node &n, const std::vector<TileIndex> &tiles)
+	{
+		if (!Yapf().CanUseGlobalCache(n)) return;
+		m_global_cache.AddTiles(*n.m_segment, tiles);
+	}
 };
 
 #endif /* YAPF_COSTCACHE_HPP */
@@ -56,6 +56,7 @@ protected:
 	int m_max_cost;
 	bool m_disable_cache;
 	std::vector<int> m_sig_look_ahead_costs;
+	std::vector<TileIndex> m_segment_tiles; ///< Tiles of the segment being calculated, for invalidating its cached cost.
 
 public:
 	bool          m_stopped_on_first_two_way_signal;
@@ -323,6 +324,8 @@ public:
 
 		TrackFollower tf_local(v, Yapf().GetCompatibleRailTypes());
 
+		m_segment_tiles.clear();
+
 		if (!has_parent) {
 			/* We will jump to the middle of the cost calculator assuming that segment cache is not used. */
 			assert(!is_cached_segment);
@@ -369,6 +372,17 @@ public:
 
 no_entry_cost: // jump here at the beginning if the node has no parent (it is the first node)
 
+			/* Remember the tile, and the tiles skipped to get here, for the cache. */
+			m_segment_tiles.push_back(cur.tile);
+			if (tf->m_tiles_skipped > 0) {
+				TileIndexDiff diff = TileOffsByDiagDir(TrackdirToExitdir(ReverseTrackdir(cur.td)));
+				TileIndex skipped = cur.tile;
+				for (int i = 0; i < tf->m_tiles_skipped; i++) {
+					skipped += diff;
+					m_segment_tiles.push_back(skipped);
+				}
+			}
+
 			/* All other tile costs will be calculated here. */
 			segment_cost += Yapf().OneTileCost(cur.tile, cur.td);
 
@@ -569,6 +583,9 @@ no_entry_cost: // jump here at the beginning if the node has no parent (it is th
 			segment.m_end_segment_reason = end_segment_reason & ESRB_CACHED_MASK;
 			/* Save end of segment back to the node. */
 			n.SetLastTileTrackdir(cur.tile, cur.td);
+			/* The segment also changes when the tile it could continue on changes. */
+			m_segment_tiles.push_back(TileAddByDiagDir(cur.tile, TrackdirToExitdir(cur.td)));
+			Yapf().PfNodeCacheStore(n, m_segment_tiles);
 		}
 
 		/* Do we have an excuse why not to continue pathfinding in this direction? */
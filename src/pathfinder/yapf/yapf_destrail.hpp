@@ -119,6 +119,7 @@ protected:
 	TrackdirBits m_destTrackdirs;
 	StationID    m_dest_station_id;
 	bool         m_any_depot;
+	RailJunctionDistanceField m_junctions; ///< Distances to the destination over the junction graph, if known.
 
 	/** to access inherited path finder */
 	Tpf &Yapf()
@@ -160,6 +161,15 @@ public:
 				m_destTrackdirs = TrackStatusToTrackdirBits(GetTileTrackStatus(v->dest_tile, TRANSPORT_RAIL, 0));
 				break;
 		}
+
+		/* The junction graph knows the distances to stations, waypoints and single depots. */
+		if (m_dest_station_id != INVALID_STATION) {
+			m_junctions = GetRailJunctionDistances(m_dest_station_id);
+		} else if (!m_any_depot && IsValidTile(m_destTile) && IsRailDepotTile(m_destTile)) {
+			m_junctions = GetRailJunctionDistances(m_destTile);
+		} else {
+			m_junctions = RailJunctionDistanceField();
+		}
 		CYapfDestinationRailBase::SetDestination(v);
 	}
 
@@ -210,6 +220,20 @@ public:
 		int dxy = abs(dx - dy);
 		int d = dmin * YAPF_TILE_CORNER_LENGTH + (dxy - 1) * (YAPF_TILE_LENGTH / 2);
 		n.m_estimate = n.m_cost + d;
+
+		if (m_junctions.IsValid()) {
+			/* The distance over the junction graph is usually a lot closer to the real cost than the
+			 * distance as the crow flies, so far fewer nodes are expanded on the way to the destination. */
+			int distance = m_junctions.GetDistance(tile, n.GetLastTrackdir());
+			if (distance == RAIL_JUNCTION_UNREACHABLE) {
+				/* No track leads to the destination from here; look at all other ways first. */
+				n.m_estimate += YAPF_INFINITE_PENALTY;
+			} else {
+				n.m_estimate = std::max(n.m_estimate, n.m_cost + distance);
+			}
+			/* Both estimates never decrease along a path, but mixing them could. */
+			n.m_estimate = std::max(n.m_estimate, n.m_parent->m_estimate);
+		}
 		assert(n.m_estimate >= n.m_parent->m_estimate);
 		return true;
 	}
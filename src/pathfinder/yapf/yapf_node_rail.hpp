@@ -92,6 +92,18 @@ struct CYapfRailSegment
 		return m_key.GetTile();
 	}
 
+	/**
+	 * Forget the calculated cost, so it is recalculated on the next use.
+	 * The last tile is kept, as nodes of the last search may still refer to it.
+	 */
+	inline void Invalidate()
+	{
+		m_cost = -1;
+		m_last_signal_tile = INVALID_TILE;
+		m_last_signal_td = INVALID_TRACKDIR;
+		m_end_segment_reason = ESRB_NONE;
+	}
+
 	inline CYapfRailSegment *GetHashNext()
 	{
 		return m_hash_next;
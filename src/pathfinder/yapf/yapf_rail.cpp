@@ -11,11 +11,13 @@
 
 #include "yapf.hpp"
 #include "yapf_cache.h"
+#include "../rail_junctions.h"
 #include "yapf_node_rail.hpp"
 #include "yapf_costrail.hpp"
 #include "yapf_destrail.hpp"
 #include "../../viewport_func.h"
 #include "../../newgrf_station.h"
+#include "../../tick_profiling.h"
 
 #include "../../safeguards.h"
 
@@ -56,6 +58,7 @@ private:
 	TileIndex m_res_fail_tile;    ///< The tile where the reservation failed
 	Trackdir  m_res_fail_td;      ///< The trackdir where the reservation failed
 	TileIndex m_origin_tile;      ///< Tile our reservation will originate from
+	std::vector<TileIndex> m_res_tiles; ///< Tiles of the reserved path, for invalidating their cached segments
 
 	bool FindSafePositionProc(TileIndex tile, Trackdir td)
 	{
@@ -67,6 +70,12 @@ private:
 		return true;
 	}
 
+	bool CollectTileProc(TileIndex tile, Trackdir)
+	{
+		m_res_tiles.push_back(tile);
+		return true;
+	}
+
 	/** Reserve a railway platform. Tile contains the failed tile on abort. */
 	bool ReserveRailStationPlatform(TileIndex &tile, DiagDirection dir)
 	{
@@ -178,7 +187,13 @@ public:
 		if (target != nullptr) target->okay = true;
 
 		if (Yapf().CanUseGlobalCache(*m_res_node)) {
-			YapfNotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
+			/* Only the segments along the reserved path are affected. Collect the tiles
+			 * first, as invalidating them changes the segments the nodes refer to. */
+			m_res_tiles.clear();
+			for (Node *node = m_res_node; node->m_parent != nullptr; node = node->m_parent) {
+				node->IterateTiles(Yapf().GetVehicle(), Yapf(), *this, &CYapfReserveTrack<Types>::CollectTileProc);
+			}
+			for (TileIndex tile : m_res_tiles) CSegmentCostCacheBase::NotifyTrackLayoutChange(tile, INVALID_TRACK);
 		}
 
 		return true;
@@ -534,6 +549,8 @@ struct CYapfAnySafeTileRail2 : CYapfT<CYapfRail_TypesT<CYapfAnySafeTileRail2, CF
 
 Track YapfTrainChooseTrack(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool reserve_track, PBSTileInfo *target, TileIndex *dest)
 {
+	TickProfileScope tick_profile(TPZ_YAPF_TRAIN, v->index);
+
 	/* default is YAPF type 2 */
 	typedef Trackdir (*PfnChooseRailTrack)(const Train*, TileIndex, DiagDirection, TrackBits, bool&, bool, PBSTileInfo*, TileIndex*);
 	PfnChooseRailTrack pfnChooseRailTrack = &CYapfRail1::stChooseRailTrack;
@@ -638,10 +655,24 @@ bool YapfTrainFindNearestSafeTile(const Train *v, TileIndex tile, Trackdir td, b
 	return pfnFindNearestSafeTile(v, tile, td, override_railtype);
 }
 
-/** if any track changes, this counter is incremented - that will invalidate segment cost cache */
+/** if the whole track layout may have changed, this counter is incremented - that will flush segment cost cache */
 int CSegmentCostCacheBase::s_rail_change_counter = 0;
+std::vector<CSegmentCostCacheBase *> CSegmentCostCacheBase::s_caches;
+YapfSegmentCacheStats CSegmentCostCacheBase::s_stats;
 
 void YapfNotifyTrackLayoutChange(TileIndex tile, Track track)
 {
 	CSegmentCostCacheBase::NotifyTrackLayoutChange(tile, track);
+	InvalidateRailJunctions(tile);
+}
+
+/**
+ * Get the statistics of the rail segment cost caches.
+ * @return Statistics since the start of the game, and the current sizes of the caches.
+ */
+YapfSegmentCacheStats YapfGetSegmentCacheStats()
+{
+	YapfSegmentCacheStats stats = CSegmentCostCacheBase::s_stats;
+	for (const CSegmentCostCacheBase *cache : CSegmentCostCacheBase::s_caches) cache->AddSizes(stats);
+	return stats;
 }
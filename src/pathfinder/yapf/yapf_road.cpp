@@ -11,6 +11,8 @@
 #include "yapf.hpp"
 #include "yapf_node_road.hpp"
 #include "../../roadstop_base.h"
+#include "../road_regions.h"
+#include "../../tick_profiling.h"
 
 #include "../../safeguards.h"
 
@@ -256,6 +258,30 @@ public:
 		return m_dest_station != INVALID_STATION ? Station::GetIfValid(m_dest_station) : nullptr;
 	}
 
+	/**
+	 * Check whether the destination can possibly be reached from a tile, i.e. whether
+	 * any destination tile is part of the same road network as the given tile.
+	 * @param v The vehicle to find a path for.
+	 * @param tile The tile to start searching from.
+	 * @return False if there is no connection by road at all.
+	 */
+	bool IsDestinationConnected(const RoadVehicle *v, TileIndex tile) const
+	{
+		RoadTramType rtt = GetRoadTramType(v->roadtype);
+		TRoadNetworkID network = GetRoadNetworkID(tile, rtt);
+		if (network == INVALID_ROAD_NETWORK) return true;
+
+		if (m_dest_station == INVALID_STATION) return GetRoadNetworkID(m_destTile, rtt) == network;
+
+		const Station *st = GetDestinationStation();
+		if (st == nullptr) return true;
+
+		for (const RoadStop *rs = st->GetPrimaryRoadStop(v); rs != nullptr; rs = rs->next) {
+			if (GetRoadNetworkID(rs->xy, rtt) == network) return true;
+		}
+		return false;
+	}
+
 protected:
 	/** to access inherited path finder */
 	Tpf &Yapf()
@@ -324,6 +350,9 @@ public:
 	typedef typename Node::Key Key;                      ///< key to hash tables
 
 protected:
+	bool m_restrict_to_region = false; ///< Whether the search should not leave the road region of the origin.
+	TRoadRegionIndex m_road_region; ///< The road region of the origin.
+
 	/** to access inherited path finder */
 	inline Tpf &Yapf()
 	{
@@ -341,10 +370,22 @@ public:
 	{
 		TrackFollower F(Yapf().GetVehicle());
 		if (F.Follow(old_node.m_segment_last_tile, old_node.m_segment_last_td)) {
+			if (m_restrict_to_region && GetRoadRegionIndex(F.m_new_tile) != m_road_region) return;
 			Yapf().AddMultipleNodes(&old_node, F);
 		}
 	}
 
+	/**
+	 * Restricts the search to the road region of a tile. Used when the destination
+	 * cannot be reached, so only the nearby roads are searched for a way closer to it.
+	 * @param tile The tile whose road region may not be left.
+	 */
+	inline void RestrictSearch(TileIndex tile)
+	{
+		m_restrict_to_region = true;
+		m_road_region = GetRoadRegionIndex(tile);
+	}
+
 	/** return debug report character to identify the transportation type */
 	inline char TransportTypeChar() const
 	{
@@ -378,6 +419,10 @@ public:
 		Yapf().SetOrigin(src_tile, src_trackdirs);
 		Yapf().SetDestination(v);
 
+		/* A vehicle that cannot reach its destination would search the whole road network
+		 * for the best way towards it; only look at the roads around the vehicle instead. */
+		if (!Yapf().IsDestinationConnected(v, src_tile)) Yapf().RestrictSearch(src_tile);
+
 		/* find the best path */
 		path_found = Yapf().FindPath(v);
 
@@ -525,6 +570,8 @@ struct CYapfRoadAnyDepot2 : CYapfT<CYapfRoad_TypesT<CYapfRoadAnyDepot2, CRoadNod
 
 Trackdir YapfRoadVehicleChooseTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, TrackdirBits trackdirs, bool &path_found, RoadVehPathCache &path_cache)
 {
+	TickProfileScope tick_profile(TPZ_YAPF_ROAD, v->index);
+
 	/* default is YAPF type 2 */
 	typedef Trackdir (*PfnChooseRoadTrack)(const RoadVehicle*, TileIndex, DiagDirection, bool &path_found, RoadVehPathCache &path_cache);
 	PfnChooseRoadTrack pfnChooseRoadTrack = &CYapfRoad2::stChooseRoadTrack; // default: ExitDir, allow 90-deg
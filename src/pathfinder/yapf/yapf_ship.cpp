@@ -16,6 +16,7 @@
 #include "yapf_node_ship.hpp"
 #include "yapf_ship_regions.h"
 #include "../water_regions.h"
+#include "../../tick_profiling.h"
 
 #include "../../safeguards.h"
 
@@ -438,6 +439,8 @@ struct CYapfShip : CYapfT<CYapfShip_TypesT<CYapfShip, CFollowTrackWater, CShipNo
 /** Ship controller helper - path finder invoker. */
 Track YapfShipChooseTrack(const Ship *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, ShipPathCache &path_cache)
 {
+	TickProfileScope tick_profile(TPZ_YAPF_SHIP, v->index);
+
 	Trackdir td_ret = CYapfShip::ChooseShipTrack(v, tile, enterdir, tracks, path_found, path_cache);
 	return (td_ret != INVALID_TRACKDIR) ? TrackdirToTrack(td_ret) : INVALID_TRACK;
 }
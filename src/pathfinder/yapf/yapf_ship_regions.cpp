@@ -9,6 +9,7 @@
 
 #include "../../stdafx.h"
 #include "../../ship.h"
+#include "../../timer/timer_game_tick.h"
 
 #include "yapf.hpp"
 #include "yapf_ship_regions.h"
@@ -299,6 +300,18 @@ struct CYapfRegionWater : CYapfT<CYapfRegion_TypesT<CYapfRegionWater, CRegionNod
 	explicit CYapfRegionWater(int max_nodes) { m_max_search_nodes = max_nodes; }
 };
 
+/**
+ * Key of a request for a water region path. The search only depends on the water regions, the destination
+ * of the ship and the patch it starts in, so all ships with the same key get the same path.
+ * Contains whether the destination is a station, the station or tile, the start patch and the maximum length.
+ */
+using WaterRegionPathRequest = std::tuple<bool, uint32_t, int, int, TWaterRegionPatchLabel, int>;
+
+/** Paths that have been found during the current tick, shared by ships with the same destination. */
+static std::map<WaterRegionPathRequest, std::vector<WaterRegionPatchDesc>> _water_region_paths;
+static TimerGameTick::TickCounter _water_region_paths_tick = 0; ///< Tick the paths have been found in.
+static uint32_t _water_region_paths_version = 0; ///< Version of the water regions the paths have been found with.
+
 /**
  * Finds a path at the water region level. Note that the starting region is always included if the path was found.
  * @param v The ship to find a path for.
@@ -308,5 +321,20 @@ struct CYapfRegionWater : CYapfT<CYapfRegion_TypesT<CYapfRegionWater, CRegionNod
  */
 std::vector<WaterRegionPatchDesc> YapfShipFindWaterRegionPath(const Ship *v, TileIndex start_tile, int max_returned_path_length)
 {
-	return CYapfRegionWater::FindWaterRegionPath(v, start_tile, max_returned_path_length);
+	/* Ships sharing orders tend to ask for the same path many times; only search once per tick, as long as the water does not change. */
+	if (_water_region_paths_tick != TimerGameTick::counter || _water_region_paths_version != GetWaterRegionsVersion()) {
+		_water_region_paths.clear();
+		_water_region_paths_tick = TimerGameTick::counter;
+		_water_region_paths_version = GetWaterRegionsVersion();
+	}
+
+	const bool to_station = v->current_order.IsType(OT_GOTO_STATION);
+	const WaterRegionPatchDesc start = GetWaterRegionPatchInfo(start_tile);
+	const WaterRegionPathRequest request{ to_station, to_station ? v->current_order.GetDestination() : v->dest_tile.base(), start.x, start.y, start.label, max_returned_path_length };
+
+	auto it = _water_region_paths.find(request);
+	if (it == _water_region_paths.end()) {
+		it = _water_region_paths.emplace(request, CYapfRegionWater::FindWaterRegionPath(v, start_tile, max_returned_path_length)).first;
+	}
+	return it->second;
 }
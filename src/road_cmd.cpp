@@ -14,6 +14,7 @@
 #include "command_func.h"
 #include "company_func.h"
 #include "pathfinder/yapf/yapf_cache.h"
+#include "pathfinder/road_regions.h"
 #include "depot_base.h"
 #include "newgrf.h"
 #include "autoslope.h"
@@ -378,6 +379,8 @@ static CommandCost RemoveRoad(TileIndex tile, DoCommandFlag flags, RoadBits piec
 
 				SetRoadType(other_end, rtt, INVALID_ROADTYPE);
 				SetRoadType(tile,      rtt, INVALID_ROADTYPE);
+				InvalidateRoadRegion(other_end);
+				InvalidateRoadRegion(tile);
 
 				/* If the owner of the bridge sells all its road, also move the ownership
 				 * to the owner of the other roadtype, unless the bridge owner is a town. */
@@ -402,6 +405,7 @@ static CommandCost RemoveRoad(TileIndex tile, DoCommandFlag flags, RoadBits piec
 				/* A full diagonal road tile has two road bits. */
 				UpdateCompanyRoadInfrastructure(existing_rt, GetRoadOwner(tile, rtt), -2);
 				SetRoadType(tile, rtt, INVALID_ROADTYPE);
+				InvalidateRoadRegion(tile);
 				MarkTileDirtyByTile(tile);
 			}
 		}
@@ -471,6 +475,7 @@ static CommandCost RemoveRoad(TileIndex tile, DoCommandFlag flags, RoadBits piec
 						if (rtt == RTT_ROAD) SetDisallowedRoadDirections(tile, DRD_NONE);
 						SetRoadBits(tile, ROAD_NONE, rtt);
 						SetRoadType(tile, rtt, INVALID_ROADTYPE);
+						InvalidateRoadRegion(tile);
 						MarkTileDirtyByTile(tile);
 					}
 				} else {
@@ -479,6 +484,7 @@ static CommandCost RemoveRoad(TileIndex tile, DoCommandFlag flags, RoadBits piec
 					 * onewayness, so they cannot remove it either. */
 					if (rtt == RTT_ROAD) SetDisallowedRoadDirections(tile, DRD_NONE);
 					SetRoadBits(tile, present, rtt);
+					InvalidateRoadRegion(tile);
 					MarkTileDirtyByTile(tile);
 				}
 			}
@@ -518,6 +524,7 @@ static CommandCost RemoveRoad(TileIndex tile, DoCommandFlag flags, RoadBits piec
 				} else {
 					SetRoadType(tile, rtt, INVALID_ROADTYPE);
 				}
+				InvalidateRoadRegion(tile);
 				MarkTileDirtyByTile(tile);
 				YapfNotifyTrackLayoutChange(tile, railtrack);
 			}
@@ -780,6 +787,7 @@ CommandCost CmdBuildRoad(DoCommandFlag flags, TileIndex tile, RoadBits pieces, R
 				bool reserved = HasBit(GetRailReservationTrackBits(tile), railtrack);
 				MakeRoadCrossing(tile, company, company, GetTileOwner(tile), roaddir, GetRailType(tile), rtt == RTT_ROAD ? rt : INVALID_ROADTYPE, (rtt == RTT_TRAM) ? rt : INVALID_ROADTYPE, town_id);
 				SetCrossingReservation(tile, reserved);
+				InvalidateRoadRegion(tile);
 				UpdateLevelCrossing(tile, false);
 				MarkDirtyAdjacentLevelCrossingTiles(tile, GetCrossingRoadAxis(tile));
 				MarkTileDirtyByTile(tile);
@@ -902,6 +910,7 @@ do_clear:;
 				SetRoadType(tile, rtt, rt);
 				SetRoadOwner(other_end, rtt, company);
 				SetRoadOwner(tile, rtt, company);
+				InvalidateRoadRegion(other_end);
 
 				/* Mark tiles dirty that have been repaved */
 				if (IsBridge(tile)) {
@@ -935,6 +944,7 @@ do_clear:;
 					GetDisallowedRoadDirections(tile) ^ toggle_drd : DRD_NONE);
 		}
 
+		InvalidateRoadRegion(tile);
 		MarkTileDirtyByTile(tile);
 	}
 	return cost;
@@ -1203,6 +1213,7 @@ CommandCost CmdBuildRoadDepot(DoCommandFlag flags, TileIndex tile, RoadType rt,
 			UpdateCompanyRoadInfrastructure(rt, _current_company, ROAD_DEPOT_TRACKBIT_FACTOR);
 		}
 
+		InvalidateRoadRegion(tile);
 		MarkTileDirtyByTile(tile);
 	}
 
@@ -2619,4 +2630,5 @@ extern const TileTypeProcs _tile_type_road_procs = {
 	VehicleEnter_Road,       // vehicle_enter_tile_proc
 	GetFoundation_Road,      // get_foundation_proc
 	TerraformTile_Road,      // terraform_tile_proc
+	nullptr,                 // tile_loop_idle_proc
 };
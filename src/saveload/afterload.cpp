@@ -581,6 +581,8 @@ bool AfterLoadGame()
 	/* This needs to be done even before conversion, because some conversions will destroy objects
 	 * that otherwise won't exist in the tree. */
 	RebuildViewportKdtree();
+	/* The vehicle tile hash was sized for the map before loading; size it for the loaded map before any vehicle is added to it. */
+	ResetVehicleHash();
 
 	if (IsSavegameVersionBefore(SLV_98)) _gamelog.GRFAddList(_grfconfig);
 
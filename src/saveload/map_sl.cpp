@@ -71,25 +71,13 @@ struct MAPTChunkHandler : ChunkHandler {
 
 	void Load() const override
 	{
-		std::array<byte, MAP_SL_BUF_SIZE> buf;
-		uint size = Map::Size();
-
-		for (TileIndex i = 0; i != size;) {
-			SlCopy(buf.data(), MAP_SL_BUF_SIZE, SLE_UINT8);
-			for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) Tile(i++).type() = buf[j];
-		}
+		SlCopy(Tile::GetPlanes().type, Map::Size(), SLE_UINT8);
 	}
 
 	void Save() const override
 	{
-		std::array<byte, MAP_SL_BUF_SIZE> buf;
-		uint size = Map::Size();
-
-		SlSetLength(size);
-		for (TileIndex i = 0; i != size;) {
-			for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = Tile(i++).type();
-			SlCopy(buf.data(), MAP_SL_BUF_SIZE, SLE_UINT8);
-		}
+		SlSetLength(Map::Size());
+		SlCopy(Tile::GetPlanes().type, Map::Size(), SLE_UINT8);
 	}
 };
 
@@ -98,25 +86,13 @@ struct MAPHChunkHandler : ChunkHandler {
 
 	void Load() const override
 	{
-		std::array<byte, MAP_SL_BUF_SIZE> buf;
-		uint size = Map::Size();
-
-		for (TileIndex i = 0; i != size;) {
-			SlCopy(buf.data(), MAP_SL_BUF_SIZE, SLE_UINT8);
-			for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) Tile(i++).height() = buf[j];
-		}
+		SlCopy(Tile::GetPlanes().height, Map::Size(), SLE_UINT8);
 	}
 
 	void Save() const override
 	{
-		std::array<byte, MAP_SL_BUF_SIZE> buf;
-		uint size = Map::Size();
-
-		SlSetLength(size);
-		for (TileIndex i = 0; i != size;) {
-			for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = Tile(i++).height();
-			SlCopy(buf.data(), MAP_SL_BUF_SIZE, SLE_UINT8);
-		}
+		SlSetLength(Map::Size());
+		SlCopy(Tile::GetPlanes().height, Map::Size(), SLE_UINT8);
 	}
 };
 
@@ -125,25 +101,13 @@ struct MAPOChunkHandler : ChunkHandler {
 
 	void Load() const override
 	{
-		std::array<byte, MAP_SL_BUF_SIZE> buf;
-		uint size = Map::Size();
-
-		for (TileIndex i = 0; i != size;) {
-			SlCopy(buf.data(), MAP_SL_BUF_SIZE, SLE_UINT8);
-			for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) Tile(i++).m1() = buf[j];
-		}
+		SlCopy(Tile::GetPlanes().m1, Map::Size(), SLE_UINT8);
 	}
 
 	void Save() const override
 	{
-		std::array<byte, MAP_SL_BUF_SIZE> buf;
-		uint size = Map::Size();
-
-		SlSetLength(size);
-		for (TileIndex i = 0; i != size;) {
-			for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = Tile(i++).m1();
-			SlCopy(buf.data(), MAP_SL_BUF_SIZE, SLE_UINT8);
-		}
+		SlSetLength(Map::Size());
+		SlCopy(Tile::GetPlanes().m1, Map::Size(), SLE_UINT8);
 	}
 };
 
@@ -152,28 +116,16 @@ struct MAP2ChunkHandler : ChunkHandler {
 
 	void Load() const override
 	{
-		std::array<uint16_t, MAP_SL_BUF_SIZE> buf;
-		uint size = Map::Size();
-
-		for (TileIndex i = 0; i != size;) {
-			SlCopy(buf.data(), MAP_SL_BUF_SIZE,
-				/* In those versions the m2 was 8 bits */
-				IsSavegameVersionBefore(SLV_5) ? SLE_FILE_U8 | SLE_VAR_U16 : SLE_UINT16
-			);
-			for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) Tile(i++).m2() = buf[j];
-		}
+		SlCopy(Tile::GetPlanes().m2, Map::Size(),
+			/* In those versions the m2 was 8 bits */
+			IsSavegameVersionBefore(SLV_5) ? SLE_FILE_U8 | SLE_VAR_U16 : SLE_UINT16
+		);
 	}
 
 	void Save() const override
 	{
-		std::array<uint16_t, MAP_SL_BUF_SIZE> buf;
-		uint size = Map::Size();
-
-		SlSetLength(static_cast<uint32_t>(size) * sizeof(uint16_t));
-		for (TileIndex i = 0; i != size;) {
-			for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = Tile(i++).m2();
-			SlCopy(buf.data(), MAP_SL_BUF_SIZE, SLE_UINT16);
-		}
+		SlSetLength(static_cast<uint32_t>(Map::Size()) * sizeof(uint16_t));
+		SlCopy(Tile::GetPlanes().m2, Map::Size(), SLE_UINT16);
 	}
 };
 
@@ -182,25 +134,13 @@ struct M3LOChunkHandler : ChunkHandler {
 
 	void Load() const override
 	{
-		std::array<byte, MAP_SL_BUF_SIZE> buf;
-		uint size = Map::Size();
-
-		for (TileIndex i = 0; i != size;) {
-			SlCopy(buf.data(), MAP_SL_BUF_SIZE, SLE_UINT8);
-			for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) Tile(i++).m3() = buf[j];
-		}
+		SlCopy(Tile::GetPlanes().m3, Map::Size(), SLE_UINT8);
 	}
 
 	void Save() const override
 	{
-		std::array<byte, MAP_SL_BUF_SIZE> buf;
-		uint size = Map::Size();
-
-		SlSetLength(size);
-		for (TileIndex i = 0; i != size;) {
-			for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = Tile(i++).m3();
-			SlCopy(buf.data(), MAP_SL_BUF_SIZE, SLE_UINT8);
-		}
+		SlSetLength(Map::Size());
+		SlCopy(Tile::GetPlanes().m3, Map::Size(), SLE_UINT8);
 	}
 };
 
@@ -209,25 +149,13 @@ struct M3HIChunkHandler : ChunkHandler {
 
 	void Load() const override
 	{
-		std::array<byte, MAP_SL_BUF_SIZE> buf;
-		uint size = Map::Size();
-
-		for (TileIndex i = 0; i != size;) {
-			SlCopy(buf.data(), MAP_SL_BUF_SIZE, SLE_UINT8);
-			for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) Tile(i++).m4() = buf[j];
-		}
+		SlCopy(Tile::GetPlanes().m4, Map::Size(), SLE_UINT8);
 	}
 
 	void Save() const override
 	{
-		std::array<byte, MAP_SL_BUF_SIZE> buf;
-		uint size = Map::Size();
-
-		SlSetLength(size);
-		for (TileIndex i = 0; i != size;) {
-			for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = Tile(i++).m4();
-			SlCopy(buf.data(), MAP_SL_BUF_SIZE, SLE_UINT8);
-		}
+		SlSetLength(Map::Size());
+		SlCopy(Tile::GetPlanes().m4, Map::Size(), SLE_UINT8);
 	}
 };
 
@@ -236,25 +164,13 @@ struct MAP5ChunkHandler : ChunkHandler {
 
 	void Load() const override
 	{
-		std::array<byte, MAP_SL_BUF_SIZE> buf;
-		uint size = Map::Size();
-
-		for (TileIndex i = 0; i != size;) {
-			SlCopy(buf.data(), MAP_SL_BUF_SIZE, SLE_UINT8);
-			for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) Tile(i++).m5() = buf[j];
-		}
+		SlCopy(Tile::GetPlanes().m5, Map::Size(), SLE_UINT8);
 	}
 
 	void Save() const override
 	{
-		std::array<byte, MAP_SL_BUF_SIZE> buf;
-		uint size = Map::Size();
-
-		SlSetLength(size);
-		for (TileIndex i = 0; i != size;) {
-			for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = Tile(i++).m5();
-			SlCopy(buf.data(), MAP_SL_BUF_SIZE, SLE_UINT8);
-		}
+		SlSetLength(Map::Size());
+		SlCopy(Tile::GetPlanes().m5, Map::Size(), SLE_UINT8);
 	}
 };
 
@@ -278,23 +194,14 @@ struct MAPEChunkHandler : ChunkHandler {
 				}
 			}
 		} else {
-			for (TileIndex i = 0; i != size;) {
-				SlCopy(buf.data(), MAP_SL_BUF_SIZE, SLE_UINT8);
-				for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) Tile(i++).m6() = buf[j];
-			}
+			SlCopy(Tile::GetPlanes().m6, size, SLE_UINT8);
 		}
 	}
 
 	void Save() const override
 	{
-		std::array<byte, MAP_SL_BUF_SIZE> buf;
-		uint size = Map::Size();
-
-		SlSetLength(size);
-		for (TileIndex i = 0; i != size;) {
-			for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = Tile(i++).m6();
-			SlCopy(buf.data(), MAP_SL_BUF_SIZE, SLE_UINT8);
-		}
+		SlSetLength(Map::Size());
+		SlCopy(Tile::GetPlanes().m6, Map::Size(), SLE_UINT8);
 	}
 };
 
@@ -303,25 +210,13 @@ struct MAP7ChunkHandler : ChunkHandler {
 
 	void Load() const override
 	{
-		std::array<byte, MAP_SL_BUF_SIZE> buf;
-		uint size = Map::Size();
-
-		for (TileIndex i = 0; i != size;) {
-			SlCopy(buf.data(), MAP_SL_BUF_SIZE, SLE_UINT8);
-			for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) Tile(i++).m7() = buf[j];
-		}
+		SlCopy(Tile::GetPlanes().m7, Map::Size(), SLE_UINT8);
 	}
 
 	void Save() const override
 	{
-		std::array<byte, MAP_SL_BUF_SIZE> buf;
-		uint size = Map::Size();
-
-		SlSetLength(size);
-		for (TileIndex i = 0; i != size;) {
-			for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = Tile(i++).m7();
-			SlCopy(buf.data(), MAP_SL_BUF_SIZE, SLE_UINT8);
-		}
+		SlSetLength(Map::Size());
+		SlCopy(Tile::GetPlanes().m7, Map::Size(), SLE_UINT8);
 	}
 };
 
@@ -330,25 +225,13 @@ struct MAP8ChunkHandler : ChunkHandler {
 
 	void Load() const override
 	{
-		std::array<uint16_t, MAP_SL_BUF_SIZE> buf;
-		uint size = Map::Size();
-
-		for (TileIndex i = 0; i != size;) {
-			SlCopy(buf.data(), MAP_SL_BUF_SIZE, SLE_UINT16);
-			for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) Tile(i++).m8() = buf[j];
-		}
+		SlCopy(Tile::GetPlanes().m8, Map::Size(), SLE_UINT16);
 	}
 
 	void Save() const override
 	{
-		std::array<uint16_t, MAP_SL_BUF_SIZE> buf;
-		uint size = Map::Size();
-
-		SlSetLength(static_cast<uint32_t>(size) * sizeof(uint16_t));
-		for (TileIndex i = 0; i != size;) {
-			for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = Tile(i++).m8();
-			SlCopy(buf.data(), MAP_SL_BUF_SIZE, SLE_UINT16);
-		}
+		SlSetLength(static_cast<uint32_t>(Map::Size()) * sizeof(uint16_t));
+		SlCopy(Tile::GetPlanes().m8, Map::Size(), SLE_UINT16);
 	}
 };
 
@@ -42,6 +42,7 @@
 #include "../string_func.h"
 #include "../fios.h"
 #include "../error.h"
+#include "../worker_pool.h"
 #include <atomic>
 #ifdef __EMSCRIPTEN__
 #	include <emscripten.h>
@@ -113,6 +114,28 @@ struct ReadBuffer {
 		return *this->bufp++;
 	}
 
+	/**
+	 * Read a number of bytes at once.
+	 * @param ptr The memory to read them into.
+	 * @param length The number of bytes to read.
+	 */
+	void CopyBytes(byte *ptr, size_t length)
+	{
+		while (length > 0) {
+			if (this->bufp == this->bufe) {
+				*ptr++ = this->ReadByte();
+				length--;
+				continue;
+			}
+
+			size_t to_copy = std::min<size_t>(length, this->bufe - this->bufp);
+			memcpy(ptr, this->bufp, to_copy);
+			this->bufp += to_copy;
+			ptr += to_copy;
+			length -= to_copy;
+		}
+	}
+
 	/**
 	 * Get the size of the memory dump made so far.
 	 * @return The size.
@@ -158,6 +181,28 @@ struct MemoryDumper {
 		*this->buf++ = b;
 	}
 
+	/**
+	 * Write a number of bytes at once into the dumper.
+	 * @param ptr The bytes to write.
+	 * @param length The number of bytes to write.
+	 */
+	void CopyBytes(const byte *ptr, size_t length)
+	{
+		while (length > 0) {
+			if (this->buf == this->bufe) {
+				this->WriteByte(*ptr++);
+				length--;
+				continue;
+			}
+
+			size_t to_copy = std::min<size_t>(length, this->bufe - this->buf);
+			memcpy(this->buf, ptr, to_copy);
+			this->buf += to_copy;
+			ptr += to_copy;
+			length -= to_copy;
+		}
+	}
+
 	/**
 	 * Flush this dumper into a writer.
 	 * @param writer The filter we want to use.
@@ -757,11 +802,40 @@ static void SlCopyBytes(void *ptr, size_t length)
 	switch (_sl.action) {
 		case SLA_LOAD_CHECK:
 		case SLA_LOAD:
-			for (; length != 0; length--) *p++ = SlReadByte();
+			_sl.reader->CopyBytes(p, length);
 			break;
 		case SLA_SAVE:
-			for (; length != 0; length--) SlWriteByte(*p++);
+			_sl.dumper->CopyBytes(p, length);
+			break;
+		default: NOT_REACHED();
+	}
+}
+
+/**
+ * Save/Load 16 bits numbers in bulk, instead of one by one through #SlSaveLoadConv.
+ * The savegame stores them in big endian byte order.
+ * @param ptr The numbers being manipulated.
+ * @param length The number of numbers.
+ */
+static void SlCopyUint16s(uint16_t *ptr, size_t length)
+{
+	switch (_sl.action) {
+		case SLA_LOAD_CHECK:
+		case SLA_LOAD:
+			SlCopyBytes(ptr, length * sizeof(uint16_t));
+			for (size_t i = 0; i < length; i++) ptr[i] = FROM_BE16(ptr[i]);
 			break;
+		case SLA_SAVE: {
+			std::array<uint16_t, 2048> buf;
+			while (length > 0) {
+				size_t count = std::min(length, buf.size());
+				for (size_t i = 0; i < count; i++) buf[i] = TO_BE16(ptr[i]);
+				SlCopyBytes(buf.data(), count * sizeof(uint16_t));
+				ptr += count;
+				length -= count;
+			}
+			break;
+		}
 		default: NOT_REACHED();
 	}
 }
@@ -996,6 +1070,8 @@ static void SlCopyInternal(void *object, size_t length, VarType conv)
 	 * conversion is needed, use specialized copy-copy function to speed up things */
 	if (conv == SLE_INT8 || conv == SLE_UINT8) {
 		SlCopyBytes(object, length);
+	} else if (conv == SLE_INT16 || conv == SLE_UINT16) {
+		SlCopyUint16s(static_cast<uint16_t *>(object), length);
 	} else {
 		byte *a = (byte*)object;
 		byte mem_size = SlCalcConvMemLen(conv);
@@ -2094,7 +2170,9 @@ static void SlSaveChunk(const ChunkHandler &ch)
 static void SlSaveChunks()
 {
 	for (auto &ch : ChunkHandlers()) {
+		auto start = std::chrono::steady_clock::now();
 		SlSaveChunk(ch);
+		Debug(sl, 3, "Saved chunk {} in {} us", ch.get().GetName(), std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
 	}
 
 	/* Terminator */
@@ -2124,7 +2202,9 @@ static void SlLoadChunks()
 
 		ch = SlFindChunkHandler(id);
 		if (ch == nullptr) SlErrorCorrupt("Unknown chunk type");
+		auto start = std::chrono::steady_clock::now();
 		SlLoadChunk(*ch);
+		Debug(sl, 3, "Loaded chunk {} in {} us", ch->GetName(), std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
 	}
 }
 
@@ -2356,6 +2436,271 @@ struct NoCompSaveFilter : SaveFilter {
 	}
 };
 
+/********************************************
+ ********** START OF BLOCK CODE *************
+ ********************************************/
+
+/** Amount of uncompressed data in a single block of the block compressed formats. */
+static const size_t SAVE_BLOCK_SIZE = 8 * MEMORY_CHUNK_SIZE;
+/** Number of blocks that are compressed or decompressed at once. */
+static const size_t SAVE_BLOCK_BATCH = 16;
+
+/**
+ * Compress a single block of a block compressed savegame.
+ * @param in                The data to compress.
+ * @param in_len            The amount of data to compress.
+ * @param[out] out          The compressed data.
+ * @param compression_level The requested level of compression.
+ * @return Whether compressing succeeded.
+ */
+typedef bool BlockCompressProc(const byte *in, size_t in_len, std::vector<byte> &out, byte compression_level);
+
+/**
+ * Decompress a single block of a block compressed savegame.
+ * @param in      The compressed data.
+ * @param in_len  The amount of compressed data.
+ * @param out     The buffer to decompress into.
+ * @param out_len The exact amount of data the block decompresses into.
+ * @return Whether decompressing succeeded.
+ */
+typedef bool BlockDecompressProc(const byte *in, size_t in_len, byte *out, size_t out_len);
+
+/**
+ * Get the largest size a block can have after compressing it.
+ * @param len The amount of data to compress.
+ * @return The largest possible size of the compressed data.
+ */
+typedef size_t BlockBoundProc(size_t len);
+
+/**
+ * Filter reading a savegame that has been split into independently compressed blocks.
+ * Each block is prefixed by its uncompressed and compressed size, and the last block
+ * is followed by a block with an uncompressed size of 0. Batches of blocks are
+ * decompressed in parallel by the worker threads.
+ * @tparam Tdecompress The procedure to decompress a single block.
+ * @tparam Tbound      The procedure to get the largest valid compressed size of a block.
+ */
+template <BlockDecompressProc Tdecompress, BlockBoundProc Tbound>
+struct BlockLoadFilter : LoadFilter {
+	std::vector<byte> input;       ///< Compressed data of the current batch.
+	std::vector<byte> output;      ///< Decompressed data of the current batch.
+	size_t output_pos = 0;         ///< Position in #output that has not been read yet.
+	bool finished = false;         ///< Whether the end marker has been read.
+
+	/**
+	 * Initialise this filter.
+	 * @param chain The next filter in this chain.
+	 */
+	BlockLoadFilter(std::shared_ptr<LoadFilter> chain) : LoadFilter(chain)
+	{
+	}
+
+	/**
+	 * Read exactly the given amount of bytes from the next filter.
+	 * @param buf The bytes to read.
+	 * @param len The number of bytes to read.
+	 */
+	void ReadExactly(byte *buf, size_t len)
+	{
+		while (len > 0) {
+			size_t read = this->chain->Read(buf, len);
+			if (read == 0) SlErrorCorrupt("Unexpected end of compressed block");
+			buf += read;
+			len -= read;
+		}
+	}
+
+	/** Read and decompress the next batch of blocks. */
+	void ReadBatch()
+	{
+		struct Block {
+			size_t in_offset;  ///< Offset of the compressed data in #input.
+			size_t in_len;     ///< Size of the compressed data.
+			size_t out_offset; ///< Offset of the decompressed data in #output.
+			size_t out_len;    ///< Size of the decompressed data.
+		};
+		std::vector<Block> blocks;
+
+		this->input.clear();
+		size_t out_len = 0;
+		while (blocks.size() < SAVE_BLOCK_BATCH) {
+			uint32_t hdr[2];
+			this->ReadExactly((byte *)hdr, sizeof(hdr));
+			size_t block_out_len = FROM_BE32(hdr[0]);
+			size_t block_in_len = FROM_BE32(hdr[1]);
+			if (block_out_len == 0) {
+				this->finished = true;
+				break;
+			}
+			/* Check the compressed size as well, so a corrupt header cannot make us allocate huge amounts of memory. */
+			if (block_out_len > SAVE_BLOCK_SIZE || block_in_len == 0 || block_in_len > Tbound(block_out_len)) SlErrorCorrupt("Invalid compressed block size");
+
+			blocks.push_back({ this->input.size(), block_in_len, out_len, block_out_len });
+			this->input.resize(this->input.size() + block_in_len);
+			this->ReadExactly(this->input.data() + blocks.back().in_offset, block_in_len);
+			out_len += block_out_len;
+		}
+
+		this->output.resize(out_len);
+		this->output_pos = 0;
+
+		std::vector<uint8_t> success(blocks.size(), false);
+		ParallelFor(blocks.size(), [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				const Block &b = blocks[i];
+				success[i] = Tdecompress(this->input.data() + b.in_offset, b.in_len, this->output.data() + b.out_offset, b.out_len);
+			}
+		});
+		for (uint8_t s : success) {
+			if (!s) SlErrorCorrupt("Decompressing block failed");
+		}
+	}
+
+	size_t Read(byte *buf, size_t size) override
+	{
+		size_t read = 0;
+		while (read < size) {
+			if (this->output_pos == this->output.size()) {
+				if (this->finished) break;
+				this->ReadBatch();
+				continue;
+			}
+
+			size_t len = std::min(size - read, this->output.size() - this->output_pos);
+			memcpy(buf + read, this->output.data() + this->output_pos, len);
+			this->output_pos += len;
+			read += len;
+		}
+		return read;
+	}
+
+	void Reset() override
+	{
+		this->input.clear();
+		this->output.clear();
+		this->output_pos = 0;
+		this->finished = false;
+		this->chain->Reset();
+	}
+};
+
+/**
+ * Filter splitting a savegame into independently compressed blocks, so they can be
+ * compressed and decompressed in parallel by the worker threads.
+ * @tparam Tcompress The procedure to compress a single block.
+ * @see BlockLoadFilter for the layout of the data.
+ */
+template <BlockCompressProc Tcompress>
+struct BlockSaveFilter : SaveFilter {
+	byte compression_level;                ///< The requested level of compression.
+	std::vector<byte> input;               ///< Uncompressed data of the current batch.
+	std::vector<std::vector<byte>> output; ///< Compressed data of each block of the current batch.
+
+	/**
+	 * Initialise this filter.
+	 * @param chain             The next filter in this chain.
+	 * @param compression_level The requested level of compression.
+	 */
+	BlockSaveFilter(std::shared_ptr<SaveFilter> chain, byte compression_level) : SaveFilter(chain), compression_level(compression_level), output(SAVE_BLOCK_BATCH)
+	{
+		this->input.reserve(SAVE_BLOCK_SIZE * SAVE_BLOCK_BATCH);
+	}
+
+	/** Compress the blocks of the current batch and write them to the next filter. */
+	void WriteBatch()
+	{
+		if (this->input.empty()) return;
+
+		size_t count = CeilDiv(this->input.size(), SAVE_BLOCK_SIZE);
+		std::vector<uint8_t> success(count, false);
+		ParallelFor(count, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				size_t offset = i * SAVE_BLOCK_SIZE;
+				size_t len = std::min(SAVE_BLOCK_SIZE, this->input.size() - offset);
+				success[i] = Tcompress(this->input.data() + offset, len, this->output[i], this->compression_level);
+			}
+		});
+
+		for (size_t i = 0; i < count; i++) {
+			if (!success[i]) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "compressing block failed");
+
+			size_t offset = i * SAVE_BLOCK_SIZE;
+			uint32_t hdr[2] = { TO_BE32((uint32_t)std::min(SAVE_BLOCK_SIZE, this->input.size() - offset)), TO_BE32((uint32_t)this->output[i].size()) };
+			this->chain->Write((byte *)hdr, sizeof(hdr));
+			this->chain->Write(this->output[i].data(), this->output[i].size());
+		}
+		this->input.clear();
+	}
+
+	void Write(byte *buf, size_t size) override
+	{
+		while (size > 0) {
+			size_t len = std::min(size, SAVE_BLOCK_SIZE * SAVE_BLOCK_BATCH - this->input.size());
+			this->input.insert(this->input.end(), buf, buf + len);
+			buf += len;
+			size -= len;
+
+			if (this->input.size() == SAVE_BLOCK_SIZE * SAVE_BLOCK_BATCH) this->WriteBatch();
+		}
+	}
+
+	void Finish() override
+	{
+		this->WriteBatch();
+
+		uint32_t end_marker[2] = { 0, 0 };
+		this->chain->Write((byte *)end_marker, sizeof(end_marker));
+		this->chain->Finish();
+	}
+};
+
+/** Filter that returns a single byte that was already read from the next filter, before reading the rest of the data from it. */
+struct UnreadLoadFilter : LoadFilter {
+	byte unread;       ///< The byte that was already read.
+	bool has_unread;   ///< Whether #unread has not been returned yet.
+
+	/**
+	 * Initialise this filter.
+	 * @param chain  The next filter in this chain.
+	 * @param unread The byte that was already read from \a chain.
+	 */
+	UnreadLoadFilter(std::shared_ptr<LoadFilter> chain, byte unread) : LoadFilter(chain), unread(unread), has_unread(true)
+	{
+	}
+
+	size_t Read(byte *buf, size_t size) override
+	{
+		if (size == 0) return 0;
+		if (!this->has_unread) return this->chain->Read(buf, size);
+
+		this->has_unread = false;
+		buf[0] = this->unread;
+		return 1 + this->chain->Read(buf + 1, size - 1);
+	}
+};
+
+/**
+ * Create the load filter for a savegame that is either compressed as a single stream or in blocks.
+ * Both are saved with the same tag, so older versions of OpenTTD refuse block compressed savegames
+ * as corrupt data of that tag. As no block decompresses to more than #SAVE_BLOCK_SIZE, the blob of
+ * a block compressed savegame starts with a zero byte, which zlib and LZMA streams never do.
+ * @tparam Tstream     The load filter for the stream compressed savegame.
+ * @tparam Tdecompress The procedure to decompress a single block.
+ * @tparam Tbound      The procedure to get the largest valid compressed size of a block.
+ * @param chain The next filter in this chain.
+ * @return The filter for the compression of this savegame.
+ */
+template <typename Tstream, BlockDecompressProc Tdecompress, BlockBoundProc Tbound>
+static std::shared_ptr<LoadFilter> CreateStreamOrBlockLoadFilter(std::shared_ptr<LoadFilter> chain)
+{
+	byte first;
+	if (chain->Read(&first, 1) != 1) SlErrorCorrupt("Unexpected end of savegame");
+
+	chain = std::make_shared<UnreadLoadFilter>(chain, first);
+	if (first == 0) return std::make_shared<BlockLoadFilter<Tdecompress, Tbound>>(chain);
+	return std::make_shared<Tstream>(chain);
+}
+
 /********************************************
  ********** START OF ZLIB CODE **************
  ********************************************/
@@ -2475,6 +2820,38 @@ struct ZlibSaveFilter : SaveFilter {
 	}
 };
 
+/**
+ * Compress a single block with zlib.
+ * @copydoc BlockCompressProc
+ */
+static bool ZlibCompressBlock(const byte *in, size_t in_len, std::vector<byte> &out, byte compression_level)
+{
+	uLongf out_len = compressBound((uLong)in_len);
+	out.resize(out_len);
+	if (compress2(out.data(), &out_len, in, (uLong)in_len, compression_level) != Z_OK) return false;
+	out.resize(out_len);
+	return true;
+}
+
+/**
+ * Decompress a single block with zlib.
+ * @copydoc BlockDecompressProc
+ */
+static bool ZlibDecompressBlock(const byte *in, size_t in_len, byte *out, size_t out_len)
+{
+	uLongf len = (uLongf)out_len;
+	return uncompress(out, &len, in, (uLong)in_len) == Z_OK && len == out_len;
+}
+
+/**
+ * Get the largest size of a block compressed with zlib.
+ * @copydoc BlockBoundProc
+ */
+static size_t ZlibBlockBound(size_t len)
+{
+	return compressBound((uLong)len);
+}
+
 #endif /* WITH_ZLIB */
 
 /********************************************
@@ -2594,6 +2971,41 @@ struct LZMASaveFilter : SaveFilter {
 	}
 };
 
+/**
+ * Compress a single block with LZMA.
+ * @copydoc BlockCompressProc
+ */
+static bool LZMACompressBlock(const byte *in, size_t in_len, std::vector<byte> &out, byte compression_level)
+{
+	out.resize(lzma_stream_buffer_bound(in_len));
+	size_t out_pos = 0;
+	if (lzma_easy_buffer_encode(compression_level, LZMA_CHECK_CRC32, nullptr, in, in_len, out.data(), &out_pos, out.size()) != LZMA_OK) return false;
+	out.resize(out_pos);
+	return true;
+}
+
+/**
+ * Decompress a single block with LZMA.
+ * @copydoc BlockDecompressProc
+ */
+static bool LZMADecompressBlock(const byte *in, size_t in_len, byte *out, size_t out_len)
+{
+	/* The same limit as the stream decoder of LZMALoadFilter; savegames are never written with presets that need more. */
+	uint64_t memlimit = 1 << 28;
+	size_t in_pos = 0;
+	size_t out_pos = 0;
+	return lzma_stream_buffer_decode(&memlimit, 0, nullptr, in, &in_pos, in_len, out, &out_pos, out_len) == LZMA_OK && in_pos == in_len && out_pos == out_len;
+}
+
+/**
+ * Get the largest size of a block compressed with LZMA.
+ * @copydoc BlockBoundProc
+ */
+static size_t LZMABlockBound(size_t len)
+{
+	return lzma_stream_buffer_bound(len);
+}
+
 #endif /* WITH_LIBLZMA */
 
 /*******************************************
@@ -2613,6 +3025,9 @@ struct SaveLoadFormat {
 	byte max_compression;                 ///< the maximum compression level of this format
 };
 
+/** Number of block formats at the end of #_saveload_formats; they are not considered when picking the default format. */
+static const size_t NUM_BLOCK_SAVELOAD_FORMATS = 2;
+
 /** The different saveload formats known/understood by OpenTTD. */
 static const SaveLoadFormat _saveload_formats[] = {
 #if defined(WITH_LZO)
@@ -2627,7 +3042,7 @@ static const SaveLoadFormat _saveload_formats[] = {
 	/* After level 6 the speed reduction is significant (1.5x to 2.5x slower per level), but the reduction in filesize is
 	 * fairly insignificant (~1% for each step). Lower levels become ~5-10% bigger by each level than level 6 while level
 	 * 1 is "only" 3 times as fast. Level 0 results in uncompressed savegames at about 8 times the cost of "none". */
-	{"zlib",   TO_BE32X('OTTZ'), CreateLoadFilter<ZlibLoadFilter>,   CreateSaveFilter<ZlibSaveFilter>,   0, 6, 9},
+	{"zlib",   TO_BE32X('OTTZ'), CreateStreamOrBlockLoadFilter<ZlibLoadFilter, ZlibDecompressBlock, ZlibBlockBound>, CreateSaveFilter<ZlibSaveFilter>, 0, 6, 9},
 #else
 	{"zlib",   TO_BE32X('OTTZ'), nullptr,                            nullptr,                            0, 0, 0},
 #endif
@@ -2637,9 +3052,24 @@ static const SaveLoadFormat _saveload_formats[] = {
 	 * The next significant reduction in file size is at level 4, but that is already 4 times slower. Level 3 is primarily 50%
 	 * slower while not improving the filesize, while level 0 and 1 are faster, but don't reduce savegame size much.
 	 * It's OTTX and not e.g. OTTL because liblzma is part of xz-utils and .tar.xz is preferred over .tar.lzma. */
-	{"lzma",   TO_BE32X('OTTX'), CreateLoadFilter<LZMALoadFilter>,   CreateSaveFilter<LZMASaveFilter>,   0, 2, 9},
+	{"lzma",   TO_BE32X('OTTX'), CreateStreamOrBlockLoadFilter<LZMALoadFilter, LZMADecompressBlock, LZMABlockBound>, CreateSaveFilter<LZMASaveFilter>, 0, 2, 9},
 #else
 	{"lzma",   TO_BE32X('OTTX'), nullptr,                            nullptr,                            0, 0, 0},
+#endif
+	/* The block formats below are never the default, see NUM_BLOCK_SAVELOAD_FORMATS. They share their tag with the
+	 * stream format, so loading is done by the entries above; those tell both apart by the first byte of the data. */
+#if defined(WITH_ZLIB)
+	/* The same as zlib, but split in independent blocks of 1 MiB that are (de)compressed by the worker threads.
+	 * Not the default, as it only helps when worker threads are enabled and makes the savegame slightly bigger. */
+	{"zlib-mt", TO_BE32X('OTTZ'), nullptr,                            CreateSaveFilter<BlockSaveFilter<ZlibCompressBlock>>, 0, 6, 9},
+#else
+	{"zlib-mt", TO_BE32X('OTTZ'), nullptr,                            nullptr,                            0, 0, 0},
+#endif
+#if defined(WITH_LIBLZMA)
+	/* The same as lzma, but split in independent blocks of 1 MiB that are (de)compressed by the worker threads. */
+	{"lzma-mt", TO_BE32X('OTTX'), nullptr,                            CreateSaveFilter<BlockSaveFilter<LZMACompressBlock>>, 0, 2, 9},
+#else
+	{"lzma-mt", TO_BE32X('OTTX'), nullptr,                            nullptr,                            0, 0, 0},
 #endif
 };
 
@@ -2652,7 +3082,7 @@ static const SaveLoadFormat _saveload_formats[] = {
  */
 static const SaveLoadFormat *GetSavegameFormat(const std::string &full_name, byte *compression_level)
 {
-	const SaveLoadFormat *def = lastof(_saveload_formats);
+	const SaveLoadFormat *def = lastof(_saveload_formats) - NUM_BLOCK_SAVELOAD_FORMATS;
 
 	/* find default savegame format, the highest one with which files can be written */
 	while (!def->init_write) def--;
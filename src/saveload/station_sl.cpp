@@ -342,12 +342,14 @@ public:
 		for (uint32_t j = 0; j < num_flows; ++j) {
 			SlObject(&flow, this->GetLoadDescription());
 			if (fs == nullptr || prev_source != flow.source) {
-				fs = &(ge->flows.insert(std::make_pair(flow.source, FlowStat(flow.via, flow.share, flow.restricted))).first->second);
+				fs = &ge->flows.emplace_back(flow.source, FlowStat(flow.via, flow.share, flow.restricted)).second;
 			} else {
 				fs->AppendShare(flow.via, flow.share, flow.restricted);
 			}
 			prev_source = flow.source;
 		}
+		/* Appending and sorting once avoids moving all later flows for every inserted one. Flows are saved in order of their origin, so this normally sorts nothing. */
+		ge->flows.SortByOrigin();
 	}
 };
 
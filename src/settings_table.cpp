@@ -50,6 +50,8 @@
 #include "void_map.h"
 #include "station_func.h"
 #include "station_base.h"
+#include "worker_pool.h"
+#include "newgrf_callback_cache.h"
 
 #include "table/strings.h"
 #include "table/settings.h"
@@ -21,6 +21,12 @@
 #include "video/video_driver.hpp"
 #include "spritecache.h"
 #include "spritecache_internal.h"
+#include "console_func.h"
+#include "thread.h"
+#include "worker_pool.h"
+
+#include <chrono>
+#include <condition_variable>
 
 #include "table/sprites.h"
 #include "table/strings.h"
@@ -92,17 +98,55 @@ SpriteFile &OpenCachedSpriteFile(const std::string &filename, Subdirectory subdi
 	return *file;
 }
 
-struct MemBlock {
-	size_t size;
-	byte data[];
+/** Header in front of every sprite in the sprite cache. */
+struct SpriteChunk {
+	uint32_t slab; ///< Index of the slab the chunk is in.
+	uint32_t size; ///< Number of bytes requested for the sprite.
+	byte data[];   ///< The sprite.
+};
+
+/* The chunk sizes are multiples of 16, so this keeps the sprites aligned. */
+static_assert(sizeof(SpriteChunk) == 8);
+
+/**
+ * A block of memory that is split into chunks of the same size class.
+ * Chunks that have never been used are handed out in order; chunks that were freed are kept in a list.
+ */
+struct SpriteSlab {
+	byte *memory;           ///< Memory of the slab, or \c nullptr if this slab is not in use.
+	size_t size;            ///< Size of the memory.
+	void *free_list;        ///< First chunk that was freed; each free chunk points to the next one.
+	uint32_t chunks;        ///< Number of chunks that fit in the slab.
+	uint32_t carved;        ///< Number of chunks that have been handed out at least once.
+	uint32_t used;          ///< Number of chunks in use.
+	uint32_t partial_index; ///< Index in the list of slabs with free chunks of the size class, or \c UINT32_MAX.
+	uint8_t size_class;     ///< Size class of the chunks.
+};
+
+static const SpriteID SPRITE_LRU_END = UINT32_MAX; ///< End of a list of least recently used sprites.
+
+/** The slabs and least recently used sprites of a size class. */
+struct SpriteSizeClass {
+	std::vector<uint32_t> partial;   ///< Slabs with free chunks.
+	SpriteID lru_head = SPRITE_LRU_END; ///< Least recently used sprite of the size class.
+	SpriteID lru_tail = SPRITE_LRU_END; ///< Most recently used sprite of the size class.
 };
 
-static uint _sprite_lru_counter;
-static MemBlock *_spritecache_ptr;
-static uint _allocated_sprite_cache_size = 0;
-static int _compact_cache_counter;
+static const uint NUM_SPRITE_SIZE_CLASSES = 105;    ///< Number of size classes; enough for any 32 bit size.
+static const uint SPRITE_EVICT_ANY_ATTEMPTS = 16;   ///< Number of least recently used sprites removed before only removing sprites of the wanted size class.
 
-static void CompactSpriteCache();
+static uint64_t _sprite_lru_counter;
+static uint _sprite_cache_version; ///< Changed whenever cached sprites are moved or removed.
+static uint _allocated_sprite_cache_size = 0; ///< Maximum amount of memory of the slabs.
+static size_t _sprite_slab_size;              ///< Size of normal slabs; chunks larger than this get a slab of their own.
+static size_t _sprite_slab_memory = 0;        ///< Memory of all slabs, including the unused ones.
+static size_t _sprite_cache_used = 0;         ///< Number of bytes requested for the sprites in the sprite cache.
+static std::vector<SpriteSlab> _sprite_slabs;
+static std::vector<uint32_t> _unused_sprite_slabs; ///< Indices of #_sprite_slabs that are not in use.
+static std::vector<byte *> _empty_sprite_slabs;     ///< Memory of normal sized slabs that is not in use, to prevent freeing and allocating it again.
+static std::array<SpriteSizeClass, NUM_SPRITE_SIZE_CLASSES> _sprite_size_classes;
+
+static void DeleteEntryFromSpriteCache(uint item);
 
 /**
  * Skip the given amount of sprite graphics data.
@@ -440,6 +484,51 @@ static void *ReadRecolourSprite(SpriteFile &file, uint num)
 	return dest;
 }
 
+/**
+ * Decode a sprite that is not a map generator sprite, and encode it for the blitter.
+ * This does not use the sprite cache, so it can be called from the sprite decoder thread,
+ * as long as no other thread reads from the same file.
+ * @param file          The file to read the sprite from.
+ * @param file_pos      Position of the sprite in the file.
+ * @param control_flags Control flags of the sprite, see SpriteCacheCtrlFlags.
+ * @param sprite_type   Type of sprite.
+ * @param allocator     Allocator function to use.
+ * @param encoder       Sprite encoder to use.
+ * @return Encoded sprite data, or \c nullptr when the sprite could not be loaded or resized.
+ */
+static void *DecodeSprite(SpriteFile &file, size_t file_pos, byte control_flags, SpriteType sprite_type, AllocatorProc *allocator, SpriteEncoder *encoder)
+{
+	assert(sprite_type != SpriteType::MapGen && sprite_type != SpriteType::Recolour);
+
+	SpriteLoader::SpriteCollection sprite;
+	uint8_t sprite_avail = 0;
+	sprite[ZOOM_LVL_NORMAL].type = sprite_type;
+
+	SpriteLoaderGrf sprite_loader(file.GetContainerVersion());
+	if (encoder->Is32BppSupported()) {
+		/* Try for 32bpp sprites first. */
+		sprite_avail = sprite_loader.LoadSprite(sprite, file, file_pos, sprite_type, true, control_flags);
+	}
+	if (sprite_avail == 0) {
+		sprite_avail = sprite_loader.LoadSprite(sprite, file, file_pos, sprite_type, false, control_flags);
+	}
+	if (sprite_avail == 0) return nullptr;
+
+	if (!ResizeSprites(sprite, sprite_avail, encoder)) return nullptr;
+
+	if (sprite[ZOOM_LVL_NORMAL].type == SpriteType::Font && _font_zoom != ZOOM_LVL_NORMAL) {
+		/* Make ZOOM_LVL_NORMAL be ZOOM_LVL_GUI */
+		sprite[ZOOM_LVL_NORMAL].width  = sprite[_font_zoom].width;
+		sprite[ZOOM_LVL_NORMAL].height = sprite[_font_zoom].height;
+		sprite[ZOOM_LVL_NORMAL].x_offs = sprite[_font_zoom].x_offs;
+		sprite[ZOOM_LVL_NORMAL].y_offs = sprite[_font_zoom].y_offs;
+		sprite[ZOOM_LVL_NORMAL].data   = sprite[_font_zoom].data;
+		sprite[ZOOM_LVL_NORMAL].colours = sprite[_font_zoom].colours;
+	}
+
+	return encoder->Encode(sprite, allocator);
+}
+
 /**
  * Read a sprite from disk.
  * @param sc          Location of sprite.
@@ -463,26 +552,13 @@ static void *ReadSprite(const SpriteCache *sc, SpriteID id, SpriteType sprite_ty
 
 	Debug(sprite, 9, "Load sprite {}", id);
 
-	SpriteLoader::SpriteCollection sprite;
-	uint8_t sprite_avail = 0;
-	sprite[ZOOM_LVL_NORMAL].type = sprite_type;
-
-	SpriteLoaderGrf sprite_loader(file.GetContainerVersion());
-	if (sprite_type != SpriteType::MapGen && encoder->Is32BppSupported()) {
-		/* Try for 32bpp sprites first. */
-		sprite_avail = sprite_loader.LoadSprite(sprite, file, file_pos, sprite_type, true, sc->control_flags);
-	}
-	if (sprite_avail == 0) {
-		sprite_avail = sprite_loader.LoadSprite(sprite, file, file_pos, sprite_type, false, sc->control_flags);
-	}
+	if (sprite_type == SpriteType::MapGen) {
+		SpriteLoader::SpriteCollection sprite;
+		sprite[ZOOM_LVL_NORMAL].type = sprite_type;
 
-	if (sprite_avail == 0) {
-		if (sprite_type == SpriteType::MapGen) return nullptr;
-		if (id == SPR_IMG_QUERY) UserError("Okay... something went horribly wrong. I couldn't load the fallback sprite. What should I do?");
-		return (void*)GetRawSprite(SPR_IMG_QUERY, SpriteType::Normal, allocator, encoder);
-	}
+		SpriteLoaderGrf sprite_loader(file.GetContainerVersion());
+		if (sprite_loader.LoadSprite(sprite, file, file_pos, sprite_type, false, sc->control_flags) == 0) return nullptr;
 
-	if (sprite_type == SpriteType::MapGen) {
 		/* Ugly hack to work around the problem that the old landscape
 		 *  generator assumes that those sprites are stored uncompressed in
 		 *  the memory, and they are only read directly by the code, never
@@ -510,31 +586,221 @@ static void *ReadSprite(const SpriteCache *sc, SpriteID id, SpriteType sprite_ty
 		return s;
 	}
 
-	if (!ResizeSprites(sprite, sprite_avail, encoder)) {
-		if (id == SPR_IMG_QUERY) UserError("Okay... something went horribly wrong. I couldn't resize the fallback sprite. What should I do?");
+	void *s = DecodeSprite(file, file_pos, sc->control_flags, sprite_type, allocator, encoder);
+	if (s == nullptr) {
+		if (id == SPR_IMG_QUERY) UserError("Okay... something went horribly wrong. I couldn't load the fallback sprite. What should I do?");
 		return (void*)GetRawSprite(SPR_IMG_QUERY, SpriteType::Normal, allocator, encoder);
 	}
+	return s;
+}
 
-	if (sprite[ZOOM_LVL_NORMAL].type == SpriteType::Font && _font_zoom != ZOOM_LVL_NORMAL) {
-		/* Make ZOOM_LVL_NORMAL be ZOOM_LVL_GUI */
-		sprite[ZOOM_LVL_NORMAL].width  = sprite[_font_zoom].width;
-		sprite[ZOOM_LVL_NORMAL].height = sprite[_font_zoom].height;
-		sprite[ZOOM_LVL_NORMAL].x_offs = sprite[_font_zoom].x_offs;
-		sprite[ZOOM_LVL_NORMAL].y_offs = sprite[_font_zoom].y_offs;
-		sprite[ZOOM_LVL_NORMAL].data   = sprite[_font_zoom].data;
-		sprite[ZOOM_LVL_NORMAL].colours = sprite[_font_zoom].colours;
-	}
+/** Maximum number of sprites waiting to be decoded in the background; further sprites are not prefetched. */
+static const size_t SPRITE_DECODE_MAX_QUEUE = 4096;
 
-	return encoder->Encode(sprite, allocator);
+static thread_local bool _is_sprite_decoder_thread = false; ///< Whether the current thread is the sprite decoder thread.
+static thread_local size_t _decoded_sprite_size = 0;        ///< Size of the last sprite allocated by #DecodedSpriteAlloc on this thread.
+
+/**
+ * Sprite allocator of the sprite decoder thread, that remembers the size of the sprite.
+ * The sprite encoders allocate the whole sprite at once.
+ * @param size Size of the sprite.
+ * @return The allocated memory.
+ */
+static void *DecodedSpriteAlloc(size_t size)
+{
+	_decoded_sprite_size = size;
+	return MallocT<byte>(size);
 }
 
-struct GrfSpriteOffset {
-	size_t file_pos;
-	byte control_flags;
+/** A sprite that is decoded in the background. */
+struct SpriteDecodeJob {
+	SpriteID id;            ///< The sprite.
+	SpriteFile *file;       ///< File of the decoder thread to read the sprite from.
+	size_t file_pos;        ///< Position of the sprite in the file.
+	byte control_flags;     ///< Control flags of the sprite, see SpriteCacheCtrlFlags.
+	SpriteEncoder *encoder; ///< Sprite encoder to use.
+	void *data;             ///< Decoded sprite data allocated with malloc, or \c nullptr when decoding failed.
+	size_t size;            ///< Size of the decoded sprite data.
+	uint32_t decode_time;   ///< Time in microseconds it took to decode the sprite.
+};
+
+/**
+ * Thread that decodes the sprites that are expected to be drawn soon, so drawing does not have to wait for them.
+ * The decoded sprites are put into the sprite cache by the main thread.
+ */
+class SpriteDecoder {
+	std::thread thread;                 ///< The decoder thread, once started.
+	std::map<const SpriteFile *, std::unique_ptr<SpriteFile>> files; ///< Own handles of the files of the sprite cache, as reading moves the file position. Only used by the main thread.
+
+	std::mutex mutex;                   ///< Protects all variables below.
+	std::condition_variable work_cv;    ///< Signalled when a job is queued or the thread should stop.
+	std::condition_variable done_cv;    ///< Signalled when a job has been decoded.
+	std::deque<SpriteDecodeJob> queue;  ///< Jobs waiting to be decoded.
+	std::vector<SpriteDecodeJob> done;  ///< Jobs that have been decoded.
+	SpriteID busy = 0;                  ///< Sprite that is being decoded, if #is_busy.
+	bool is_busy = false;               ///< Whether a sprite is being decoded.
+	bool exit = false;                  ///< Whether the thread should stop.
+
+	/** Main loop of the decoder thread. */
+	void DecoderLoop()
+	{
+		_is_sprite_decoder_thread = true;
+
+		std::unique_lock<std::mutex> lock(this->mutex);
+		for (;;) {
+			this->work_cv.wait(lock, [&]() { return this->exit || !this->queue.empty(); });
+			if (this->exit) return;
+
+			SpriteDecodeJob job = this->queue.front();
+			this->queue.pop_front();
+			this->busy = job.id;
+			this->is_busy = true;
+
+			lock.unlock();
+			auto start = std::chrono::steady_clock::now();
+			job.data = DecodeSprite(*job.file, job.file_pos, job.control_flags, SpriteType::Normal, &DecodedSpriteAlloc, job.encoder);
+			job.size = job.data != nullptr ? _decoded_sprite_size : 0;
+			job.decode_time = (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+			lock.lock();
+
+			this->done.push_back(job);
+			this->is_busy = false;
+			this->done_cv.notify_all();
+		}
+	}
+
+	/**
+	 * Entry point of the decoder thread.
+	 * @param decoder The decoder the thread belongs to.
+	 */
+	static void DecoderThunk(SpriteDecoder *decoder)
+	{
+		decoder->DecoderLoop();
+	}
+
+public:
+	~SpriteDecoder()
+	{
+		this->Shutdown();
+	}
+
+	/**
+	 * Queue a sprite for decoding in the background.
+	 * @param id The sprite.
+	 * @param sc The sprite cache entry of the sprite.
+	 * @param encoder Sprite encoder to use.
+	 * @return True iff the sprite has been queued.
+	 */
+	bool Queue(SpriteID id, const SpriteCache *sc, SpriteEncoder *encoder)
+	{
+		if (!this->thread.joinable() && !StartNewThread(&this->thread, "ottd:sprite", &SpriteDecoder::DecoderThunk, this)) return false;
+
+		std::unique_ptr<SpriteFile> &file = this->files[sc->file];
+		if (file == nullptr) file = std::make_unique<SpriteFile>(sc->file->GetFilename(), sc->file->GetSubdirectory(), sc->file->NeedsPaletteRemap());
+
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			if (this->queue.size() >= SPRITE_DECODE_MAX_QUEUE) return false;
+			this->queue.push_back({ id, file.get(), sc->file_pos, sc->control_flags, encoder, nullptr, 0, 0 });
+		}
+		this->work_cv.notify_one();
+		return true;
+	}
+
+	/**
+	 * Get the result of a queued sprite that is needed right now.
+	 * When the sprite is being decoded, this waits until it is done.
+	 * @param id The sprite.
+	 * @param[out] job The decoded sprite.
+	 * @param[out] waited Whether this had to wait for the sprite to be decoded.
+	 * @return True iff the sprite has been decoded; false if it was still waiting in the queue, in which case it has been removed from it.
+	 */
+	bool Take(SpriteID id, SpriteDecodeJob &job, bool &waited)
+	{
+		std::unique_lock<std::mutex> lock(this->mutex);
+		auto queued = std::find_if(this->queue.begin(), this->queue.end(), [id](const SpriteDecodeJob &j) { return j.id == id; });
+		if (queued != this->queue.end()) {
+			this->queue.erase(queued);
+			waited = false;
+			return false;
+		}
+
+		waited = this->is_busy && this->busy == id;
+		this->done_cv.wait(lock, [&]() { return !this->is_busy || this->busy != id; });
+
+		auto it = std::find_if(this->done.begin(), this->done.end(), [id](const SpriteDecodeJob &j) { return j.id == id; });
+		if (it == this->done.end()) return false;
+		job = *it;
+		*it = this->done.back();
+		this->done.pop_back();
+		return true;
+	}
+
+	/**
+	 * Get all sprites that have been decoded.
+	 * @param[out] jobs Empty vector to add the decoded sprites to.
+	 */
+	void TakeDone(std::vector<SpriteDecodeJob> &jobs)
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		jobs.swap(this->done);
+	}
+
+	/**
+	 * Forget all queued and decoded sprites, and wait for the sprite that is being decoded.
+	 * Afterwards the files of the sprite cache can be closed, and the blitter can be changed.
+	 */
+	void Flush()
+	{
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			this->queue.clear();
+			this->done_cv.wait(lock, [&]() { return !this->is_busy; });
+			for (SpriteDecodeJob &job : this->done) free(job.data);
+			this->done.clear();
+		}
+		this->files.clear();
+	}
+
+	/** Flush the decoder and stop its thread; it will be started again when needed. */
+	void Shutdown()
+	{
+		this->Flush();
+		if (!this->thread.joinable()) return;
+
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->exit = true;
+		}
+		this->work_cv.notify_all();
+		this->thread.join();
+		this->exit = false;
+	}
+};
+
+static SpriteDecoder _sprite_decoder; ///< The decoder of the sprites that are prefetched.
+static bool _sprite_prefetch_mode = false; ///< Whether sprites that are not cached are queued for decoding instead of loaded, see #SetSpritePrefetchMode.
+
+/** Statistics of loading sprites into the sprite cache. */
+struct SpriteCacheStats {
+	uint64_t hits;               ///< Number of sprites that were found in the sprite cache.
+	uint64_t misses;             ///< Number of sprites that were not found in the sprite cache.
+	uint64_t evictions;          ///< Number of sprites removed from the sprite cache to make space for others.
+	uint64_t sync_loads;         ///< Number of sprites that were loaded while drawing waited for them.
+	uint64_t sync_time;          ///< Microseconds drawing waited for sprites to be loaded, including waits for the decoder thread.
+	uint64_t prefetch_queued;    ///< Number of sprites queued for decoding in the background.
+	uint64_t prefetch_installed; ///< Number of sprites decoded in the background that were put into the cache before they were needed.
+	uint64_t prefetch_dropped;   ///< Number of sprites decoded in the background that were thrown away, as decoding failed or the cache was full.
+	uint64_t prefetch_used;      ///< Number of sprites decoded in the background that were drawn.
+	uint64_t prefetch_waits;     ///< Number of times drawing waited for the decoder thread to finish a sprite.
+	uint64_t time_saved;         ///< Microseconds of decoding drawing did not have to wait for, thanks to prefetching.
 };
 
+static SpriteCacheStats _sprite_cache_stats{};
+static std::chrono::steady_clock::time_point _sprite_cache_stats_start = std::chrono::steady_clock::now(); ///< Moment the statistics were last reset.
+
 /** Map from sprite numbers to position in the GRF file. */
-static std::map<uint32_t, GrfSpriteOffset> _grf_sprite_offsets;
+static GrfSpriteOffsets _grf_sprite_offsets;
 
 /**
  * Get the file offset for a specific sprite in the sprite section of a GRF.
@@ -547,12 +813,14 @@ size_t GetGRFSpriteOffset(uint32_t id)
 }
 
 /**
- * Parse the sprite section of GRFs.
- * @param container_version Container version of the GRF we're currently processing.
+ * Parse the sprite section of a GRF, without touching any global state.
+ * This can be called from any thread, as long as \a file is only used by that thread.
+ * @param file The GRF, positioned at the offset of the sprite section just after the header.
+ * @param[out] offsets The offsets of the sprites in the sprite section.
  */
-void ReadGRFSpriteOffsets(SpriteFile &file)
+void ScanGRFSpriteOffsets(SpriteFile &file, GrfSpriteOffsets &offsets)
 {
-	_grf_sprite_offsets.clear();
+	offsets.clear();
 
 	if (file.GetContainerVersion() >= 2) {
 		/* Seek to sprite section of the GRF. */
@@ -567,7 +835,7 @@ void ReadGRFSpriteOffsets(SpriteFile &file)
 		uint32_t id, prev_id = 0;
 		while ((id = file.ReadDword()) != 0) {
 			if (id != prev_id) {
-				_grf_sprite_offsets[prev_id] = offset;
+				offsets[prev_id] = offset;
 				offset.file_pos = file.GetPos() - 4;
 				offset.control_flags = 0;
 			}
@@ -590,13 +858,30 @@ void ReadGRFSpriteOffsets(SpriteFile &file)
 			}
 			file.SkipBytes(length);
 		}
-		if (prev_id != 0) _grf_sprite_offsets[prev_id] = offset;
+		if (prev_id != 0) offsets[prev_id] = offset;
 
 		/* Continue processing the data section. */
 		file.SeekTo(old_pos, SEEK_SET);
 	}
 }
 
+/**
+ * Parse the sprite section of GRFs.
+ * @param file The GRF, positioned at the offset of the sprite section just after the header.
+ * @param scanned The offsets of this GRF as found by #ScanGRFSpriteOffsets earlier, or \c nullptr to parse the sprite section now.
+ */
+void ReadGRFSpriteOffsets(SpriteFile &file, const GrfSpriteOffsets *scanned)
+{
+	if (scanned == nullptr) {
+		ScanGRFSpriteOffsets(file, _grf_sprite_offsets);
+		return;
+	}
+
+	/* Skip the offset of the sprite section, as if it was parsed. */
+	if (file.GetContainerVersion() >= 2) file.ReadDword();
+	_grf_sprite_offsets = *scanned;
+}
+
 
 /**
  * Load a real or recolour sprite.
@@ -663,6 +948,7 @@ bool LoadNextSprite(int load_index, SpriteFile &file, uint file_sprite_id)
 	}
 
 	SpriteCache *sc = AllocateSpriteCache(load_index);
+	if (sc->ptr != nullptr) DeleteEntryFromSpriteCache(load_index);
 	sc->file = &file;
 	sc->file_pos = file_pos;
 	sc->ptr = data;
@@ -681,6 +967,8 @@ void DupSprite(SpriteID old_spr, SpriteID new_spr)
 	SpriteCache *scnew = AllocateSpriteCache(new_spr); // may reallocate: so put it first
 	SpriteCache *scold = GetSpriteCache(old_spr);
 
+	if (scnew->ptr != nullptr) DeleteEntryFromSpriteCache(new_spr);
+
 	scnew->file = scold->file;
 	scnew->file_pos = scold->file_pos;
 	scnew->ptr = nullptr;
@@ -690,187 +978,317 @@ void DupSprite(SpriteID old_spr, SpriteID new_spr)
 }
 
 /**
- * S_FREE_MASK is used to mask-out lower bits of MemBlock::size
- * If they are non-zero, the block is free.
- * S_FREE_MASK has to ensure MemBlock is correctly aligned -
- * it means 8B (S_FREE_MASK == 7) on 64bit systems!
+ * Get the size class of a chunk.
+ * There are four size classes per power of two, so at most a fifth of a chunk is not used.
+ * @param size Size of the chunk.
+ * @return The smallest size class that fits the chunk.
  */
-static const size_t S_FREE_MASK = sizeof(size_t) - 1;
+uint GetSpriteSizeClass(size_t size)
+{
+	assert(size <= (size_t)UINT32_MAX + 1);
+	if (size <= 64) return 0;
 
-/* to make sure nobody adds things to MemBlock without checking S_FREE_MASK first */
-static_assert(sizeof(MemBlock) == sizeof(size_t));
-/* make sure it's a power of two */
-static_assert((sizeof(size_t) & (sizeof(size_t) - 1)) == 0);
+	uint bit = FindLastBit(size - 1);
+	uint quarter = (uint)((size - (1ULL << bit) - 1) >> (bit - 2));
+	return (bit - 6) * 4 + quarter + 1;
+}
 
-static inline MemBlock *NextBlock(MemBlock *block)
+/**
+ * Get the size of the chunks of a size class.
+ * @param size_class The size class.
+ * @return The size of the chunks.
+ */
+size_t GetSpriteSizeClassSize(uint size_class)
 {
-	return (MemBlock*)((byte*)block + (block->size & ~S_FREE_MASK));
+	assert(size_class < NUM_SPRITE_SIZE_CLASSES);
+	if (size_class == 0) return 64;
+
+	uint bit = 6 + (size_class - 1) / 4;
+	return (1ULL << bit) + ((size_class - 1) % 4 + 1) * (1ULL << (bit - 2));
 }
 
-static size_t GetSpriteCacheUsage()
+static inline SpriteChunk *GetSpriteChunk(void *ptr)
 {
-	size_t tot_size = 0;
-	MemBlock *s;
-
-	for (s = _spritecache_ptr; s->size != 0; s = NextBlock(s)) {
-		if (!(s->size & S_FREE_MASK)) tot_size += s->size;
-	}
+	return reinterpret_cast<SpriteChunk *>(static_cast<byte *>(ptr) - sizeof(SpriteChunk));
+}
 
-	return tot_size;
+/**
+ * Get the size class a sprite in the sprite cache is in.
+ * @param sc The sprite.
+ * @return The size class.
+ */
+static inline SpriteSizeClass &GetSizeClassOfSprite(const SpriteCache *sc)
+{
+	return _sprite_size_classes[_sprite_slabs[GetSpriteChunk(sc->ptr)->slab].size_class];
 }
 
+static size_t GetSpriteCacheUsage()
+{
+	return _sprite_cache_used;
+}
 
-void IncreaseSpriteLRU()
+/**
+ * Mark a sprite in the sprite cache as the most recently used one of its size class.
+ * @param id The sprite.
+ */
+static void LinkSpriteLRU(SpriteID id)
 {
-	/* Increase all LRU values */
-	if (_sprite_lru_counter > 16384) {
-		SpriteID i;
+	SpriteCache *sc = GetSpriteCache(id);
+	SpriteSizeClass &cls = GetSizeClassOfSprite(sc);
+
+	sc->lru = ++_sprite_lru_counter;
+	sc->lru_prev = cls.lru_tail;
+	sc->lru_next = SPRITE_LRU_END;
+	if (cls.lru_tail != SPRITE_LRU_END) {
+		GetSpriteCache(cls.lru_tail)->lru_next = id;
+	} else {
+		cls.lru_head = id;
+	}
+	cls.lru_tail = id;
+}
 
-		Debug(sprite, 5, "Fixing lru {}, inuse={}", _sprite_lru_counter, GetSpriteCacheUsage());
+/**
+ * Remove a sprite from the list of least recently used sprites of its size class.
+ * @param id The sprite.
+ */
+static void UnlinkSpriteLRU(SpriteID id)
+{
+	SpriteCache *sc = GetSpriteCache(id);
+	SpriteSizeClass &cls = GetSizeClassOfSprite(sc);
 
-		for (i = 0; i != _spritecache_items; i++) {
-			SpriteCache *sc = GetSpriteCache(i);
-			if (sc->ptr != nullptr) {
-				if (sc->lru >= 0) {
-					sc->lru = -1;
-				} else if (sc->lru != -32768) {
-					sc->lru--;
-				}
-			}
-		}
-		_sprite_lru_counter = 0;
+	if (sc->lru_prev != SPRITE_LRU_END) {
+		GetSpriteCache(sc->lru_prev)->lru_next = sc->lru_next;
+	} else {
+		cls.lru_head = sc->lru_next;
 	}
-
-	/* Compact sprite cache every now and then. */
-	if (++_compact_cache_counter >= 740) {
-		CompactSpriteCache();
-		_compact_cache_counter = 0;
+	if (sc->lru_next != SPRITE_LRU_END) {
+		GetSpriteCache(sc->lru_next)->lru_prev = sc->lru_prev;
+	} else {
+		cls.lru_tail = sc->lru_prev;
 	}
+	sc->lru = 0;
 }
 
 /**
- * Called when holes in the sprite cache should be removed.
- * That is accomplished by moving the cached data.
+ * Mark a sprite in the sprite cache as used.
+ * @param id The sprite.
  */
-static void CompactSpriteCache()
+static inline void TouchSpriteLRU(SpriteID id)
 {
-	MemBlock *s;
+	SpriteCache *sc = GetSpriteCache(id);
+	if (sc->lru == 0) return; // Not in a list, so never removed from the cache.
 
-	Debug(sprite, 3, "Compacting sprite cache, inuse={}", GetSpriteCacheUsage());
+	if (sc->lru_next == SPRITE_LRU_END) {
+		sc->lru = ++_sprite_lru_counter;
+		return;
+	}
+	UnlinkSpriteLRU(id);
+	LinkSpriteLRU(id);
+}
 
-	for (s = _spritecache_ptr; s->size != 0;) {
-		if (s->size & S_FREE_MASK) {
-			MemBlock *next = NextBlock(s);
-			MemBlock temp;
-			SpriteID i;
+/**
+ * Add a slab for a size class.
+ * @param size_class The size class.
+ * @return True iff the slab could be added without exceeding the size of the sprite cache.
+ */
+static bool AddSpriteSlab(uint size_class)
+{
+	size_t chunk_size = GetSpriteSizeClassSize(size_class);
+	size_t size = std::max(chunk_size, _sprite_slab_size);
 
-			/* Since free blocks are automatically coalesced, this should hold true. */
-			assert(!(next->size & S_FREE_MASK));
+	byte *memory = nullptr;
+	if (size == _sprite_slab_size && !_empty_sprite_slabs.empty()) {
+		memory = _empty_sprite_slabs.back();
+		_empty_sprite_slabs.pop_back();
+	} else {
+		/* Empty slabs only wait for reuse; give their memory to slabs of other sizes when needed. */
+		while (_sprite_slab_memory + size > _allocated_sprite_cache_size && !_empty_sprite_slabs.empty()) {
+			delete[] _empty_sprite_slabs.back();
+			_empty_sprite_slabs.pop_back();
+			_sprite_slab_memory -= _sprite_slab_size;
+		}
+		if (_sprite_slab_memory + size > _allocated_sprite_cache_size) return false;
+		memory = new (std::nothrow) byte[size];
+		if (memory == nullptr) return false;
+		_sprite_slab_memory += size;
+	}
 
-			/* If the next block is the sentinel block, we can safely return */
-			if (next->size == 0) break;
+	uint32_t index;
+	if (!_unused_sprite_slabs.empty()) {
+		index = _unused_sprite_slabs.back();
+		_unused_sprite_slabs.pop_back();
+	} else {
+		index = (uint32_t)_sprite_slabs.size();
+		_sprite_slabs.emplace_back();
+	}
 
-			/* Locate the sprite belonging to the next pointer. */
-			for (i = 0; GetSpriteCache(i)->ptr != next->data; i++) {
-				assert(i != _spritecache_items);
-			}
+	SpriteSizeClass &cls = _sprite_size_classes[size_class];
+	SpriteSlab &slab = _sprite_slabs[index];
+	slab.memory = memory;
+	slab.size = size;
+	slab.free_list = nullptr;
+	slab.chunks = (uint32_t)(size / chunk_size);
+	slab.carved = 0;
+	slab.used = 0;
+	slab.partial_index = (uint32_t)cls.partial.size();
+	slab.size_class = size_class;
+	cls.partial.push_back(index);
+	return true;
+}
 
-			GetSpriteCache(i)->ptr = s->data; // Adjust sprite array entry
-			/* Swap this and the next block */
-			temp = *s;
-			memmove(s, next, next->size);
-			s = NextBlock(s);
-			*s = temp;
+/**
+ * Remove a slab from the list of slabs with free chunks of its size class.
+ * @param index The slab.
+ */
+static void RemovePartialSpriteSlab(uint32_t index)
+{
+	SpriteSlab &slab = _sprite_slabs[index];
+	std::vector<uint32_t> &partial = _sprite_size_classes[slab.size_class].partial;
+
+	uint32_t last = partial.back();
+	partial[slab.partial_index] = last;
+	_sprite_slabs[last].partial_index = slab.partial_index;
+	partial.pop_back();
+	slab.partial_index = UINT32_MAX;
+}
 
-			/* Coalesce free blocks */
-			while (NextBlock(s)->size & S_FREE_MASK) {
-				s->size += NextBlock(s)->size & ~S_FREE_MASK;
-			}
-		} else {
-			s = NextBlock(s);
-		}
+/**
+ * Stop using a slab; normal sized slabs are kept for reuse, others are freed.
+ * @param index The slab.
+ */
+static void ReleaseSpriteSlab(uint32_t index)
+{
+	SpriteSlab &slab = _sprite_slabs[index];
+	if (slab.size == _sprite_slab_size) {
+		_empty_sprite_slabs.push_back(slab.memory);
+	} else {
+		delete[] slab.memory;
+		_sprite_slab_memory -= slab.size;
 	}
+	slab.memory = nullptr;
+	_unused_sprite_slabs.push_back(index);
 }
 
 /**
- * Delete a single entry from the sprite cache.
- * @param item Entry to delete.
+ * Free the memory of a sprite in the sprite cache.
+ * @param ptr The sprite.
  */
-static void DeleteEntryFromSpriteCache(uint item)
+static void FreeSprite(void *ptr)
 {
-	/* Mark the block as free (the block must be in use) */
-	MemBlock *s = (MemBlock*)GetSpriteCache(item)->ptr - 1;
-	assert(!(s->size & S_FREE_MASK));
-	s->size |= S_FREE_MASK;
-	GetSpriteCache(item)->ptr = nullptr;
-
-	/* And coalesce adjacent free blocks */
-	for (s = _spritecache_ptr; s->size != 0; s = NextBlock(s)) {
-		if (s->size & S_FREE_MASK) {
-			while (NextBlock(s)->size & S_FREE_MASK) {
-				s->size += NextBlock(s)->size & ~S_FREE_MASK;
-			}
-		}
+	SpriteChunk *chunk = GetSpriteChunk(ptr);
+	uint32_t index = chunk->slab;
+	SpriteSlab &slab = _sprite_slabs[index];
+	_sprite_cache_used -= chunk->size;
+
+	*reinterpret_cast<void **>(chunk) = slab.free_list;
+	slab.free_list = chunk;
+
+	if (--slab.used == 0) {
+		if (slab.partial_index != UINT32_MAX) RemovePartialSpriteSlab(index);
+		ReleaseSpriteSlab(index);
+	} else if (slab.partial_index == UINT32_MAX) {
+		std::vector<uint32_t> &partial = _sprite_size_classes[slab.size_class].partial;
+		slab.partial_index = (uint32_t)partial.size();
+		partial.push_back(index);
 	}
 }
 
-static void DeleteEntryFromSpriteCache()
+static void InstallDecodedSprites();
+
+/**
+ * Called once per tick. Puts the sprites that have been decoded in the background into the sprite cache.
+ */
+void IncreaseSpriteLRU()
 {
-	uint best = UINT_MAX;
-	int cur_lru;
+	InstallDecodedSprites();
+}
 
-	Debug(sprite, 3, "DeleteEntryFromSpriteCache, inuse={}", GetSpriteCacheUsage());
+/**
+ * Delete a single entry from the sprite cache.
+ * @param item Entry to delete.
+ */
+static void DeleteEntryFromSpriteCache(uint item)
+{
+	SpriteCache *sc = GetSpriteCache(item);
+	if (sc->lru != 0) UnlinkSpriteLRU(item);
+	FreeSprite(sc->ptr);
+	sc->ptr = nullptr;
+	sc->prefetched = false;
+	_sprite_cache_version++;
+}
 
-	cur_lru = 0xffff;
-	for (SpriteID i = 0; i != _spritecache_items; i++) {
-		SpriteCache *sc = GetSpriteCache(i);
-		if (sc->type != SpriteType::Recolour && sc->ptr != nullptr && sc->lru < cur_lru) {
-			cur_lru = sc->lru;
-			best = i;
+/**
+ * Delete the least recently used sprite from the sprite cache to make space for another one.
+ * @param size_class When not \c UINT_MAX, delete the least recently used sprite of this size class if there is one.
+ */
+static void DeleteLeastRecentlyUsedSprite(uint size_class)
+{
+	Debug(sprite, 3, "DeleteLeastRecentlyUsedSprite, inuse={}", GetSpriteCacheUsage());
+
+	SpriteID best = SPRITE_LRU_END;
+	if (size_class != UINT_MAX) best = _sprite_size_classes[size_class].lru_head;
+	if (best == SPRITE_LRU_END) {
+		uint64_t best_lru = UINT64_MAX;
+		for (const SpriteSizeClass &cls : _sprite_size_classes) {
+			if (cls.lru_head != SPRITE_LRU_END && GetSpriteCache(cls.lru_head)->lru < best_lru) {
+				best = cls.lru_head;
+				best_lru = GetSpriteCache(best)->lru;
+			}
 		}
 	}
 
 	/* Display an error message and die, in case we found no sprite at all.
 	 * This shouldn't really happen, unless all sprites are locked. */
-	if (best == UINT_MAX) FatalError("Out of sprite memory");
+	if (best == SPRITE_LRU_END) FatalError("Out of sprite memory");
 
 	DeleteEntryFromSpriteCache(best);
+	_sprite_cache_stats.evictions++;
 }
 
-void *AllocSprite(size_t mem_req)
+/**
+ * Allocate memory in the sprite cache, without removing other sprites from it.
+ * @param mem_req Number of bytes to allocate.
+ * @return The allocated memory, or \c nullptr when there is no space.
+ */
+static void *TryAllocSprite(size_t mem_req)
 {
-	mem_req += sizeof(MemBlock);
+	if (mem_req > UINT32_MAX - sizeof(SpriteChunk)) return nullptr;
 
-	/* Align this to correct boundary. This also makes sure at least one
-	 * bit is not used, so we can use it for other things. */
-	mem_req = Align(mem_req, S_FREE_MASK + 1);
+	uint size_class = GetSpriteSizeClass(mem_req + sizeof(SpriteChunk));
+	SpriteSizeClass &cls = _sprite_size_classes[size_class];
+	if (cls.partial.empty() && !AddSpriteSlab(size_class)) return nullptr;
 
-	for (;;) {
-		MemBlock *s;
+	uint32_t index = cls.partial.back();
+	SpriteSlab &slab = _sprite_slabs[index];
 
-		for (s = _spritecache_ptr; s->size != 0; s = NextBlock(s)) {
-			if (s->size & S_FREE_MASK) {
-				size_t cur_size = s->size & ~S_FREE_MASK;
+	SpriteChunk *chunk;
+	if (slab.free_list != nullptr) {
+		chunk = static_cast<SpriteChunk *>(slab.free_list);
+		slab.free_list = *reinterpret_cast<void **>(chunk);
+	} else {
+		chunk = reinterpret_cast<SpriteChunk *>(slab.memory + slab.carved * GetSpriteSizeClassSize(size_class));
+		slab.carved++;
+	}
+	if (++slab.used == slab.chunks) RemovePartialSpriteSlab(index);
 
-				/* Is the block exactly the size we need or
-				 * big enough for an additional free block? */
-				if (cur_size == mem_req ||
-						cur_size >= mem_req + sizeof(MemBlock)) {
-					/* Set size and in use */
-					s->size = mem_req;
+	chunk->slab = index;
+	chunk->size = (uint32_t)mem_req;
+	_sprite_cache_used += mem_req;
+	return chunk->data;
+}
 
-					/* Do we need to inject a free block too? */
-					if (cur_size != mem_req) {
-						NextBlock(s)->size = (cur_size - mem_req) | S_FREE_MASK;
-					}
+void *AllocSprite(size_t mem_req)
+{
+	if (mem_req > UINT32_MAX - sizeof(SpriteChunk)) FatalError("Out of sprite memory");
+	uint size_class = GetSpriteSizeClass(mem_req + sizeof(SpriteChunk));
 
-					return s->data;
-				}
-			}
-		}
+	for (uint attempt = 0;; attempt++) {
+		void *ptr = TryAllocSprite(mem_req);
+		if (ptr != nullptr) return ptr;
 
-		/* Reached sentinel, but no block found yet. Delete some old entry. */
-		DeleteEntryFromSpriteCache();
+		/* No space; delete the least recently used sprites until a slab is empty. When that takes too long,
+		 * delete the least recently used sprites of the same size class instead, which always makes space. */
+		DeleteLeastRecentlyUsedSprite(attempt < SPRITE_EVICT_ANY_ATTEMPTS ? UINT_MAX : size_class);
 	}
 }
 
@@ -927,6 +1345,94 @@ static void *HandleInvalidSpriteRequest(SpriteID sprite, SpriteType requested, S
 	}
 }
 
+/**
+ * Queue a sprite that is not in the sprite cache for decoding in the background, instead of loading it.
+ * @param sprite The sprite.
+ * @param sc The sprite cache entry of the sprite.
+ * @return A placeholder for the sprite, which is good enough to find out which sprites are needed.
+ */
+static void *PrefetchSprite(SpriteID sprite, SpriteCache *sc)
+{
+	if (!sc->decoding && sc->file != nullptr && _sprite_decoder.Queue(sprite, sc, BlitterFactory::GetCurrentBlitter())) {
+		sc->decoding = true;
+		_sprite_cache_stats.prefetch_queued++;
+	}
+
+	return GetRawSprite(SPR_IMG_QUERY, SpriteType::Normal);
+}
+
+/**
+ * Load a sprite into the sprite cache. When the sprite has been queued for decoding
+ * in the background, that result is used instead; waiting for it when it is being decoded.
+ * @param sc Location of sprite.
+ * @param id Sprite number.
+ * @param type Type of sprite.
+ * @return The sprite in the sprite cache.
+ */
+static void *LoadSpriteIntoCache(SpriteCache *sc, SpriteID id, SpriteType type)
+{
+	auto start = std::chrono::steady_clock::now();
+	auto elapsed = [&start]() { return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count(); };
+
+	void *ptr = nullptr;
+	sc->prefetched = false;
+	if (sc->decoding) {
+		sc->decoding = false;
+
+		SpriteDecodeJob job;
+		bool waited;
+		if (_sprite_decoder.Take(id, job, waited)) {
+			/* A font sprite might have been queued as normal sprite before its type changed. */
+			if (job.data != nullptr && type == SpriteType::Normal) {
+				uint64_t wait_time = elapsed();
+				ptr = AllocSprite(job.size);
+				memcpy(ptr, job.data, job.size);
+				_sprite_cache_stats.prefetch_used++;
+				_sprite_cache_stats.time_saved += job.decode_time - std::min<uint64_t>(job.decode_time, wait_time);
+			}
+			if (waited) _sprite_cache_stats.prefetch_waits++;
+			free(job.data);
+		}
+	}
+
+	if (ptr == nullptr) {
+		ptr = ReadSprite(sc, id, type, AllocSprite, nullptr);
+		_sprite_cache_stats.sync_loads++;
+	}
+	_sprite_cache_stats.sync_time += elapsed();
+	return ptr;
+}
+
+/**
+ * Put the sprites that have been decoded in the background into the sprite cache,
+ * as long as there is space for them without removing other sprites.
+ */
+static void InstallDecodedSprites()
+{
+	static std::vector<SpriteDecodeJob> jobs;
+	_sprite_decoder.TakeDone(jobs);
+
+	for (SpriteDecodeJob &job : jobs) {
+		SpriteCache *sc = GetSpriteCache(job.id);
+		void *ptr = nullptr;
+		if (job.data != nullptr && sc->ptr == nullptr && sc->type == SpriteType::Normal) ptr = TryAllocSprite(job.size);
+
+		if (ptr != nullptr) {
+			memcpy(ptr, job.data, job.size);
+			sc->ptr = ptr;
+			LinkSpriteLRU(job.id);
+			sc->prefetched = true;
+			sc->decode_time = job.decode_time;
+			_sprite_cache_stats.prefetch_installed++;
+		} else {
+			_sprite_cache_stats.prefetch_dropped++;
+		}
+		sc->decoding = false;
+		free(job.data);
+	}
+	jobs.clear();
+}
+
 /**
  * Reads a sprite (from disk or sprite cache).
  * If the sprite is not available or of wrong type, a fallback sprite is returned.
@@ -955,11 +1461,23 @@ void *GetRawSprite(SpriteID sprite, SpriteType type, AllocatorProc *allocator, S
 	if (allocator == nullptr && encoder == nullptr) {
 		/* Load sprite into/from spritecache */
 
-		/* Update LRU */
-		sc->lru = ++_sprite_lru_counter;
-
 		/* Load the sprite, if it is not loaded, yet */
-		if (sc->ptr == nullptr) sc->ptr = ReadSprite(sc, sprite, type, AllocSprite, nullptr);
+		if (sc->ptr == nullptr) {
+			if (_sprite_prefetch_mode && type == SpriteType::Normal && sprite != SPR_IMG_QUERY) return PrefetchSprite(sprite, sc);
+			_sprite_cache_stats.misses++;
+			sc->ptr = LoadSpriteIntoCache(sc, sprite, type);
+			if (sc->ptr != nullptr) LinkSpriteLRU(sprite);
+			return sc->ptr;
+		}
+
+		/* Update LRU */
+		TouchSpriteLRU(sprite);
+		_sprite_cache_stats.hits++;
+		if (sc->prefetched && !_sprite_prefetch_mode) {
+			sc->prefetched = false;
+			_sprite_cache_stats.prefetch_used++;
+			_sprite_cache_stats.time_saved += sc->decode_time;
+		}
 
 		return sc->ptr;
 	} else {
@@ -969,6 +1487,27 @@ void *GetRawSprite(SpriteID sprite, SpriteType type, AllocatorProc *allocator, S
 }
 
 
+/**
+ * Stop using all slabs of the sprite cache.
+ * @param free_memory Whether to free all memory, instead of keeping the normal sized slabs for reuse.
+ */
+static void ReleaseAllSpriteSlabs(bool free_memory)
+{
+	for (uint32_t i = 0; i < _sprite_slabs.size(); i++) {
+		if (_sprite_slabs[i].memory != nullptr) ReleaseSpriteSlab(i);
+	}
+	_sprite_slabs.clear();
+	_unused_sprite_slabs.clear();
+	for (SpriteSizeClass &cls : _sprite_size_classes) cls = {};
+	_sprite_cache_used = 0;
+
+	if (free_memory) {
+		for (byte *memory : _empty_sprite_slabs) delete[] memory;
+		_sprite_slab_memory -= _empty_sprite_slabs.size() * _sprite_slab_size;
+		_empty_sprite_slabs.clear();
+	}
+}
+
 static void GfxInitSpriteCache()
 {
 	/* initialize sprite cache heap */
@@ -978,27 +1517,23 @@ static void GfxInitSpriteCache()
 	/* Remember 'target_size' from the previous allocation attempt, so we do not try to reach the target_size multiple times in case of failure. */
 	static uint last_alloc_attempt = 0;
 
-	if (_spritecache_ptr == nullptr || (_allocated_sprite_cache_size != target_size && target_size != last_alloc_attempt)) {
-		delete[] reinterpret_cast<byte *>(_spritecache_ptr);
+	if (_sprite_slab_size == 0 || (_allocated_sprite_cache_size != target_size && target_size != last_alloc_attempt)) {
+		ReleaseAllSpriteSlabs(true);
 
 		last_alloc_attempt = target_size;
 		_allocated_sprite_cache_size = target_size;
 
-		do {
+		/* The slabs are allocated when they are needed, but make sure the memory is there. */
+		for (;;) {
 			/* Try to allocate 50% more to make sure we do not allocate almost all available. */
-			_spritecache_ptr = reinterpret_cast<MemBlock *>(new(std::nothrow) byte[_allocated_sprite_cache_size + _allocated_sprite_cache_size / 2]);
-
-			if (_spritecache_ptr != nullptr) {
-				/* Allocation succeeded, but we wanted less. */
-				delete[] reinterpret_cast<byte *>(_spritecache_ptr);
-				_spritecache_ptr = reinterpret_cast<MemBlock *>(new byte[_allocated_sprite_cache_size]);
-			} else if (_allocated_sprite_cache_size < 2 * 1024 * 1024) {
-				UserError("Cannot allocate spritecache");
-			} else {
-				/* Try again to allocate half. */
-				_allocated_sprite_cache_size >>= 1;
-			}
-		} while (_spritecache_ptr == nullptr);
+			std::unique_ptr<byte[]> test(new(std::nothrow) byte[_allocated_sprite_cache_size + _allocated_sprite_cache_size / 2]);
+			if (test != nullptr) break;
+
+			if (_allocated_sprite_cache_size < 2 * 1024 * 1024) UserError("Cannot allocate spritecache");
+
+			/* Try again to allocate half. */
+			_allocated_sprite_cache_size >>= 1;
+		}
 
 		if (_allocated_sprite_cache_size != target_size) {
 			Debug(misc, 0, "Not enough memory to allocate {} MiB of spritecache. Spritecache was reduced to {} MiB.", target_size / 1024 / 1024, _allocated_sprite_cache_size / 1024 / 1024);
@@ -1008,33 +1543,47 @@ static void GfxInitSpriteCache()
 			msg.SetDParam(1, _allocated_sprite_cache_size);
 			ScheduleErrorMessage(msg);
 		}
-	}
 
-	/* A big free block */
-	_spritecache_ptr->size = (_allocated_sprite_cache_size - sizeof(MemBlock)) | S_FREE_MASK;
-	/* Sentinel block (identified by size == 0) */
-	NextBlock(_spritecache_ptr)->size = 0;
+		/* Slabs of at most 1/512th of the cache, so the slabs of the size classes that are barely used do not take much of small caches. */
+		_sprite_slab_size = 16 * 1024;
+		while (_sprite_slab_size < 1024 * 1024 && _sprite_slab_size * 2 * 512 <= _allocated_sprite_cache_size) _sprite_slab_size *= 2;
+	} else {
+		ReleaseAllSpriteSlabs(false);
+	}
 }
 
 void GfxInitSpriteMem()
 {
+	FlushSpriteDecoder();
 	GfxInitSpriteCache();
+	_sprite_cache_version++;
 
 	/* Reset the spritecache 'pool' */
 	free(_spritecache);
 	_spritecache_items = 0;
 	_spritecache = nullptr;
 
-	_compact_cache_counter = 0;
 	_sprite_files.clear();
 }
 
+/**
+ * Get the version of the sprite cache. Pointers to sprites that have been
+ * retrieved from the sprite cache stay valid as long as the version does not change.
+ * @return The version of the sprite cache.
+ */
+uint GetSpriteCacheVersion()
+{
+	return _sprite_cache_version;
+}
+
 /**
  * Remove all encoded sprites from the sprite cache without
  * discarding sprite location information.
  */
 void GfxClearSpriteCache()
 {
+	FlushSpriteDecoder();
+
 	/* Clear sprite ptr for all cached items */
 	for (uint i = 0; i != _spritecache_items; i++) {
 		SpriteCache *sc = GetSpriteCache(i);
@@ -1044,6 +1593,80 @@ void GfxClearSpriteCache()
 	VideoDriver::GetInstance()->ClearSystemSprites();
 }
 
+/**
+ * Forget all sprites that are queued for, or have been, decoded in the background.
+ * This must be done before the files of the sprite cache are closed or the blitter is changed.
+ */
+void FlushSpriteDecoder()
+{
+	_sprite_decoder.Flush();
+	for (uint i = 0; i != _spritecache_items; i++) GetSpriteCache(i)->decoding = false;
+}
+
+/** Stop the thread that decodes sprites in the background. */
+void ShutdownSpriteDecoder()
+{
+	_sprite_decoder.Shutdown();
+	for (uint i = 0; i != _spritecache_items; i++) GetSpriteCache(i)->decoding = false;
+}
+
+/**
+ * Check whether sprites can be prefetched, i.e. decoded in the background before they are drawn.
+ * @return True iff more than one thread may be used.
+ */
+bool IsSpritePrefetchAvailable()
+{
+	return GetWorkerThreadCount() > 1;
+}
+
+/**
+ * Start or stop prefetching sprites. While prefetching, sprites that are requested but not
+ * in the sprite cache are queued for decoding in the background, and a placeholder is returned.
+ * So drawing while prefetching finds the sprites that are needed, but does not draw anything useful.
+ * @param prefetch Whether to prefetch.
+ */
+void SetSpritePrefetchMode(bool prefetch)
+{
+	_sprite_prefetch_mode = prefetch && IsSpritePrefetchAvailable();
+}
+
+/**
+ * Check whether the current thread is the thread decoding sprites in the background.
+ * @return True iff called from the sprite decoder thread.
+ */
+bool IsSpriteDecoderThread()
+{
+	return _is_sprite_decoder_thread;
+}
+
+/** Print the statistics of loading sprites into the sprite cache to the console. */
+void ConPrintSpriteCacheStats()
+{
+	const SpriteCacheStats &stats = _sprite_cache_stats;
+	IConsolePrint(TC_SILVER, "Sprite cache: {} KiB used of {} KiB", GetSpriteCacheUsage() / 1024, _allocated_sprite_cache_size / 1024);
+	IConsolePrint(TC_GREEN, "Loads while drawing: {}, waited {} ms", stats.sync_loads, stats.sync_time / 1000);
+	IConsolePrint(TC_GREEN, "Prefetched sprites: {} queued, {} cached, {} dropped, {} drawn", stats.prefetch_queued, stats.prefetch_installed, stats.prefetch_dropped, stats.prefetch_used);
+	IConsolePrint(TC_GREEN, "Waits for the decoder thread: {}", stats.prefetch_waits);
+	IConsolePrint(TC_GREEN, "Time saved by prefetching: {} ms", stats.time_saved / 1000);
+
+	uint64_t lookups = stats.hits + stats.misses;
+	IConsolePrint(TC_GREEN, "Lookups: {}, hit rate {:.1f}%", lookups, lookups == 0 ? 0.0 : 100.0 * stats.hits / lookups);
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - _sprite_cache_stats_start).count();
+	IConsolePrint(TC_GREEN, "Evictions: {}, {:.1f} per second", stats.evictions, seconds <= 0 ? 0.0 : stats.evictions / seconds);
+
+	size_t in_use = _sprite_slab_memory - _empty_sprite_slabs.size() * _sprite_slab_size;
+	IConsolePrint(TC_GREEN, "Slabs: {} in use, {} empty, {} KiB allocated", _sprite_slabs.size() - _unused_sprite_slabs.size(), _empty_sprite_slabs.size(), _sprite_slab_memory / 1024);
+	IConsolePrint(TC_GREEN, "Fragmentation: {:.1f}% of the slabs in use is not used by sprites", in_use == 0 ? 0.0 : 100.0 * (in_use - _sprite_cache_used) / in_use);
+}
+
+/** Reset the statistics of loading sprites into the sprite cache. */
+void ResetSpriteCacheStats()
+{
+	_sprite_cache_stats = {};
+	_sprite_cache_stats_start = std::chrono::steady_clock::now();
+}
+
 /**
  * Remove all encoded font sprites from the sprite cache without
  * discarding sprite location information.
@@ -1057,4 +1680,4 @@ void GfxClearFontSpriteCache()
 	}
 }
 
-/* static */ ReusableBuffer<SpriteLoader::CommonPixel> SpriteLoader::Sprite::buffer[ZOOM_LVL_END];
+/* static */ thread_local ReusableBuffer<SpriteLoader::CommonPixel> SpriteLoader::Sprite::buffer[ZOOM_LVL_END];
@@ -58,12 +58,31 @@ inline const byte *GetNonSprite(SpriteID sprite, SpriteType type)
 
 void GfxInitSpriteMem();
 void GfxClearSpriteCache();
+uint GetSpriteCacheVersion();
 void GfxClearFontSpriteCache();
 void IncreaseSpriteLRU();
 
+void FlushSpriteDecoder();
+void ShutdownSpriteDecoder();
+bool IsSpritePrefetchAvailable();
+void SetSpritePrefetchMode(bool prefetch);
+bool IsSpriteDecoderThread();
+void ConPrintSpriteCacheStats();
+void ResetSpriteCacheStats();
+
 SpriteFile &OpenCachedSpriteFile(const std::string &filename, Subdirectory subdir, bool palette_remap);
 
-void ReadGRFSpriteOffsets(SpriteFile &file);
+/** Position of a sprite in the sprite section of a GRF, and which zoom levels it has. */
+struct GrfSpriteOffset {
+	size_t file_pos;
+	byte control_flags;
+};
+
+/** Map from sprite numbers to position in the GRF file. */
+using GrfSpriteOffsets = std::map<uint32_t, GrfSpriteOffset>;
+
+void ScanGRFSpriteOffsets(SpriteFile &file, GrfSpriteOffsets &offsets);
+void ReadGRFSpriteOffsets(SpriteFile &file, const GrfSpriteOffsets *scanned = nullptr);
 size_t GetGRFSpriteOffset(uint32_t id);
 bool LoadNextSprite(int load_index, SpriteFile &file, uint file_sprite_id);
 bool SkipSpriteData(SpriteFile &file, byte type, uint16_t num);
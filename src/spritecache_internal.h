@@ -25,10 +25,15 @@ struct SpriteCache {
 	size_t file_pos;
 	SpriteFile *file;    ///< The file the sprite in this entry can be found in.
 	uint32_t id;
-	int16_t lru;
+	uint64_t lru;        ///< Moment the sprite was last used, or 0 when the sprite is never removed from the cache.
+	SpriteID lru_prev;   ///< Sprite of the same size class that was used before this one, see #lru.
+	SpriteID lru_next;   ///< Sprite of the same size class that was used after this one, see #lru.
 	SpriteType type;     ///< In some cases a single sprite is misused by two NewGRFs. Once as real sprite and once as recolour sprite. If the recolour sprite gets into the cache it might be drawn as real sprite which causes enormous trouble.
 	bool warned;         ///< True iff the user has been warned about incorrect use of this sprite
 	byte control_flags;  ///< Control flags, see SpriteCacheCtrlFlags
+	bool decoding;       ///< True iff the sprite has been queued for decoding in the background, and the result has not been collected yet.
+	bool prefetched;     ///< True iff the sprite was decoded in the background and has not been used since.
+	uint32_t decode_time; ///< Time in microseconds it took to decode the sprite in the background.
 };
 
 inline bool IsMapgenSpriteID(SpriteID sprite)
@@ -36,6 +41,8 @@ inline bool IsMapgenSpriteID(SpriteID sprite)
 	return IsInsideMM(sprite, SPR_MAPGEN_BEGIN, SPR_MAPGEN_END);
 }
 
+uint GetSpriteSizeClass(size_t size);
+size_t GetSpriteSizeClassSize(uint size_class);
 void *AllocSprite(size_t mem_req);
 SpriteCache *AllocateSpriteCache(uint index);
 
@@ -34,6 +34,9 @@ extern const byte _palmap_w2d[];
  */
 static bool WarnCorruptSprite(const SpriteFile &file, size_t file_pos, int line)
 {
+	/* Showing an error is not possible from the background; the sprite will be loaded again on the main thread, which warns. */
+	if (IsSpriteDecoderThread()) return false;
+
 	static byte warning_level = 0;
 	if (warning_level == 0) {
 		SetDParamStr(0, file.GetSimplifiedFilename());
@@ -183,7 +186,7 @@ bool DecodeSingleSprite(SpriteLoader::Sprite *sprite, SpriteFile &file, size_t f
 		}
 
 		if (dest_size > sprite_size) {
-			static byte warning_level = 0;
+			static thread_local byte warning_level = 0;
 			Debug(sprite, warning_level, "Ignoring {} unused extra bytes from the sprite from {} at position {}", dest_size - sprite_size, file.GetSimplifiedFilename(), file_pos);
 			warning_level = 6;
 		}
@@ -17,6 +17,7 @@
  * It automatically detects and stores the container version upload opening the file.
  */
 class SpriteFile : public RandomAccessFile {
+	Subdirectory subdir;    ///< The sub directory the file was found in.
 	bool palette_remap;     ///< Whether or not a remap of the palette is required for this file.
 	byte container_version; ///< Container format of the sprite file.
 	size_t content_begin;   ///< The begin of the content of the sprite file, i.e. after the container metadata.
@@ -31,6 +32,12 @@ public:
 	 */
 	bool NeedsPaletteRemap() const { return this->palette_remap; }
 
+	/**
+	 * Get the sub directory the file was opened from.
+	 * @return The sub directory.
+	 */
+	Subdirectory GetSubdirectory() const { return this->subdir; }
+
 	/**
 	 * Get the version number of container type used by the file.
 	 * @return The version.
@@ -24,23 +24,43 @@ static const uint8_t MAX_STATION_RATING = 255;
 
 /**
  * Flow statistics telling how much flow should be sent along a link. This is
- * done by creating "flow shares" and using std::map's upper_bound() method to
- * look them up with a random number. A flow share is the difference between a
- * key in a map and the previous key. So one key in the map doesn't actually
- * mean anything by itself.
+ * done by creating "flow shares" and using upper_bound() to look them up with
+ * a random number. A flow share is the difference between a key in the shares
+ * map and the previous key. So one key in the map doesn't actually mean
+ * anything by itself.
  */
 class FlowStat {
 public:
-	typedef std::map<uint32_t, StationID> SharesMap;
-
-	static const SharesMap empty_sharesmap;
-
 	/**
-	 * Invalid constructor. This can't be called as a FlowStat must not be
-	 * empty. However, the constructor must be defined and reachable for
-	 * FlowStat to be used in a std::map.
+	 * Shares of the flow, as a vector of (cumulative share, station) pairs sorted by
+	 * share. Most flows only have a handful of shares, so this is both smaller and
+	 * faster to search than a tree.
 	 */
-	inline FlowStat() {NOT_REACHED();}
+	class SharesMap : public std::vector<std::pair<uint32_t, StationID>> {
+	public:
+		/**
+		 * Add a share after all existing ones.
+		 * @param share Cumulative share; must be larger than that of the last share.
+		 * @param st Station of the share.
+		 */
+		inline void Append(uint32_t share, StationID st)
+		{
+			assert(this->empty() || share > this->back().first);
+			this->emplace_back(share, st);
+		}
+
+		/**
+		 * Get the first share with a cumulative share larger than the given value.
+		 * @param share The value to look for.
+		 * @return The share, or end() if there is none.
+		 */
+		inline const_iterator upper_bound(uint32_t share) const
+		{
+			return std::upper_bound(this->begin(), this->end(), share, [](uint32_t s, const value_type &v) { return s < v.first; });
+		}
+	};
+
+	static const SharesMap empty_sharesmap;
 
 	/**
 	 * Create a FlowStat with an initial entry.
@@ -51,7 +71,7 @@ public:
 	inline FlowStat(StationID st, uint flow, bool restricted = false)
 	{
 		assert(flow > 0);
-		this->shares[flow] = st;
+		this->shares.Append(flow, st);
 		this->unrestricted = restricted ? 0 : flow;
 	}
 
@@ -66,7 +86,7 @@ public:
 	inline void AppendShare(StationID st, uint flow, bool restricted = false)
 	{
 		assert(flow > 0);
-		this->shares[(--this->shares.end())->first + flow] = st;
+		this->shares.Append(this->shares.back().first + flow, st);
 		if (!restricted) this->unrestricted += flow;
 	}
 
@@ -115,7 +135,7 @@ public:
 	inline StationID GetViaWithRestricted(bool &is_restricted) const
 	{
 		assert(!this->shares.empty());
-		uint rand = RandomRange((--this->shares.end())->first);
+		uint rand = RandomRange(this->shares.back().first);
 		is_restricted = rand >= this->unrestricted;
 		return this->shares.upper_bound(rand)->second;
 	}
@@ -144,9 +164,76 @@ private:
 	uint unrestricted; ///< Limit for unrestricted shares.
 };
 
-/** Flow descriptions by origin stations. */
-class FlowStatMap : public std::map<StationID, FlowStat> {
+/**
+ * Flow descriptions by origin stations, as a vector of (origin, flow) pairs sorted by
+ * origin. It can be used like a std::map, except that inserting and erasing flows
+ * invalidates all iterators.
+ */
+class FlowStatMap : public std::vector<std::pair<StationID, FlowStat>> {
+	typedef std::vector<std::pair<StationID, FlowStat>> Base;
+
+	/**
+	 * Get the first flow with an origin not before the given one.
+	 * @param origin Origin station to look for.
+	 * @return The flow, or end() if there is none.
+	 */
+	inline iterator LowerBound(StationID origin)
+	{
+		return std::lower_bound(this->begin(), this->end(), origin, [](const value_type &v, StationID o) { return v.first < o; });
+	}
+
 public:
+	using Base::erase;
+
+	/**
+	 * Find the flow of an origin station.
+	 * @param origin Origin station to look for.
+	 * @return The flow, or end() if there is none.
+	 */
+	inline iterator find(StationID origin)
+	{
+		iterator it = this->LowerBound(origin);
+		return (it != this->end() && it->first == origin) ? it : this->end();
+	}
+
+	/**
+	 * Find the flow of an origin station.
+	 * @param origin Origin station to look for.
+	 * @return The flow, or end() if there is none.
+	 */
+	inline const_iterator find(StationID origin) const
+	{
+		return const_cast<FlowStatMap *>(this)->find(origin);
+	}
+
+	/**
+	 * Add the flow of an origin station, unless that origin already has a flow.
+	 * @param value Origin and flow to add.
+	 * @return Iterator to the flow of the origin, and whether it was added.
+	 */
+	inline std::pair<iterator, bool> insert(const value_type &value)
+	{
+		iterator it = this->LowerBound(value.first);
+		if (it != this->end() && it->first == value.first) return { it, false };
+		return { this->Base::insert(it, value), true };
+	}
+
+	/**
+	 * Remove the flow of an origin station.
+	 * @param origin Origin station to remove the flow of.
+	 * @return Number of flows removed.
+	 */
+	inline size_type erase(StationID origin)
+	{
+		iterator it = this->find(origin);
+		if (it == this->end()) return 0;
+		this->erase(it);
+		return 1;
+	}
+
+	void Merge(FlowStatMap &other);
+	void SortByOrigin();
+
 	uint GetFlow() const;
 	uint GetFlowVia(StationID via) const;
 	uint GetFlowFrom(StationID from) const;
@@ -24,6 +24,7 @@
 #include "newgrf_station.h"
 #include "newgrf_canal.h" /* For the buoy */
 #include "pathfinder/yapf/yapf_cache.h"
+#include "pathfinder/road_regions.h"
 #include "road_internal.h" /* For drawing catenary/checking road removal */
 #include "autoslope.h"
 #include "water.h"
@@ -2057,6 +2058,7 @@ CommandCost CmdBuildRoadStop(DoCommandFlag flags, TileIndex tile, uint8_t width,
 				if (tram_rt == INVALID_ROADTYPE && RoadTypeIsTram(rt)) tram_rt = rt;
 				MakeRoadStop(cur_tile, st->owner, st->index, rs_type, road_rt, tram_rt, ddir);
 			}
+			InvalidateRoadRegion(cur_tile);
 			UpdateCompanyRoadInfrastructure(road_rt, road_owner, ROAD_STOP_TRACKBIT_FACTOR);
 			UpdateCompanyRoadInfrastructure(tram_rt, tram_owner, ROAD_STOP_TRACKBIT_FACTOR);
 			Company::Get(st->owner)->infrastructure.station++;
@@ -2262,6 +2264,7 @@ CommandCost CmdRemoveRoadStop(DoCommandFlag flags, TileIndex tile, uint8_t width
 		if ((flags & DC_EXEC) && (road_type[RTT_ROAD] != INVALID_ROADTYPE || road_type[RTT_TRAM] != INVALID_ROADTYPE)) {
 			MakeRoadNormal(cur_tile, road_bits, road_type[RTT_ROAD], road_type[RTT_TRAM], ClosestTownFromTile(cur_tile, UINT_MAX)->index,
 					road_owner[RTT_ROAD], road_owner[RTT_TRAM]);
+			InvalidateRoadRegion(cur_tile);
 
 			/* Update company infrastructure counts. */
 			int count = CountBits(road_bits);
@@ -4623,11 +4626,11 @@ void FlowStat::Invalidate()
 	SharesMap new_shares;
 	uint i = 0;
 	for (const auto &it : this->shares) {
-		new_shares[++i] = it.second;
+		new_shares.Append(++i, it.second);
 		if (it.first == this->unrestricted) this->unrestricted = i;
 	}
 	this->shares.swap(new_shares);
-	assert(!this->shares.empty() && this->unrestricted <= (--this->shares.end())->first);
+	assert(!this->shares.empty() && this->unrestricted <= this->shares.back().first);
 }
 
 /**
@@ -4667,11 +4670,11 @@ void FlowStat::ChangeShare(StationID st, int flow)
 			 * removed. */
 			flow = 0;
 		}
-		new_shares[it.first + added_shares - removed_shares] = it.second;
+		new_shares.Append(it.first + added_shares - removed_shares, it.second);
 		last_share = it.first;
 	}
 	if (flow > 0) {
-		new_shares[last_share + (uint)flow] = st;
+		new_shares.Append(last_share + (uint)flow, st);
 		if (this->unrestricted < last_share) {
 			this->ReleaseShare(st);
 		} else {
@@ -4699,15 +4702,15 @@ void FlowStat::RestrictShare(StationID st)
 				flow = it.first - last_share;
 				this->unrestricted -= flow;
 			} else {
-				new_shares[it.first] = it.second;
+				new_shares.Append(it.first, it.second);
 			}
 		} else {
-			new_shares[it.first - flow] = it.second;
+			new_shares.Append(it.first - flow, it.second);
 		}
 		last_share = it.first;
 	}
 	if (flow == 0) return;
-	new_shares[last_share + flow] = st;
+	new_shares.Append(last_share + flow, st);
 	this->shares.swap(new_shares);
 	assert(!this->shares.empty());
 }
@@ -4737,10 +4740,10 @@ void FlowStat::ReleaseShare(StationID st)
 	}
 	if (flow == 0) return;
 	SharesMap new_shares;
-	new_shares[flow] = st;
+	new_shares.Append(flow, st);
 	for (SharesMap::iterator it(this->shares.begin()); it != this->shares.end(); ++it) {
 		if (it->second != st) {
-			new_shares[flow + it->first] = it->second;
+			new_shares.Append(flow + it->first, it->second);
 		} else {
 			flow = 0;
 		}
@@ -4761,7 +4764,7 @@ void FlowStat::ScaleToMonthly(uint runtime)
 	uint share = 0;
 	for (auto i : this->shares) {
 		share = std::max(share + 1, i.first * 30 / runtime);
-		new_shares[share] = i.second;
+		new_shares.Append(share, i.second);
 		if (this->unrestricted == i.first) this->unrestricted = share;
 	}
 	this->shares.swap(new_shares);
@@ -4843,7 +4846,7 @@ StationIDStack FlowStatMap::DeleteFlows(StationID via)
 		s_flows.ChangeShare(via, INT_MIN);
 		if (s_flows.GetShares()->empty()) {
 			ret.Push(f_it->first);
-			this->erase(f_it++);
+			f_it = this->erase(f_it);
 		} else {
 			++f_it;
 		}
@@ -4873,6 +4876,34 @@ void FlowStatMap::ReleaseFlows(StationID via)
 	}
 }
 
+/**
+ * Add the flows of another map for all origins that do not have flows in this map yet.
+ * @param other Map with the flows to add; the added flows are moved out of it.
+ */
+void FlowStatMap::Merge(FlowStatMap &other)
+{
+	size_t old_size = this->size();
+	for (auto &it : other) {
+		auto end = this->begin() + old_size;
+		auto pos = std::lower_bound(this->begin(), end, it.first, [](const value_type &v, StationID o) { return v.first < o; });
+		if (pos == end || pos->first != it.first) this->push_back(std::move(it));
+	}
+	std::inplace_merge(this->begin(), this->begin() + old_size, this->end(), [](const value_type &a, const value_type &b) { return a.first < b.first; });
+}
+
+/**
+ * Sort the flows by their origin after they have been appended in any order, e.g. while loading.
+ * Of several flows with the same origin only the first one is kept, like #insert would do.
+ */
+void FlowStatMap::SortByOrigin()
+{
+	auto less = [](const value_type &a, const value_type &b) { return a.first < b.first; };
+	if (std::adjacent_find(this->begin(), this->end(), [](const value_type &a, const value_type &b) { return a.first >= b.first; }) == this->end()) return;
+
+	std::stable_sort(this->begin(), this->end(), less);
+	this->erase(std::unique(this->begin(), this->end(), [](const value_type &a, const value_type &b) { return a.first == b.first; }), this->end());
+}
+
 /**
  * Get the sum of all flows from this FlowStatMap.
  * @return sum of all flows.
@@ -4881,7 +4912,7 @@ uint FlowStatMap::GetFlow() const
 {
 	uint ret = 0;
 	for (const auto &it : *this) {
-		ret += (--(it.second.GetShares()->end()))->first;
+		ret += it.second.GetShares()->back().first;
 	}
 	return ret;
 }
@@ -4909,7 +4940,7 @@ uint FlowStatMap::GetFlowFrom(StationID from) const
 {
 	FlowStatMap::const_iterator i = this->find(from);
 	if (i == this->end()) return 0;
-	return (--(i->second.GetShares()->end()))->first;
+	return i->second.GetShares()->back().first;
 }
 
 /**
@@ -4940,4 +4971,5 @@ extern const TileTypeProcs _tile_type_station_procs = {
 	VehicleEnter_Station,       // vehicle_enter_tile_proc
 	GetFoundation_Station,      // get_foundation_proc
 	TerraformTile_Station,      // terraform_tile_proc
+	nullptr,                    // tile_loop_idle_proc
 };
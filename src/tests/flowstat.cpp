@@ -0,0 +1,128 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file flowstat.cpp Test functionality of FlowStat and FlowStatMap. */
+
+#include "../stdafx.h"
+
+#include "../3rdparty/catch2/catch.hpp"
+
+#include "../station_base.h"
+
+TEST_CASE("FlowStat - shares")
+{
+	FlowStat fs(1, 10);
+	fs.AppendShare(2, 20);
+	fs.AppendShare(3, 5, true);
+
+	CHECK(fs.GetShare(1) == 10);
+	CHECK(fs.GetShare(2) == 20);
+	CHECK(fs.GetShare(3) == 5);
+	CHECK(fs.GetShare(4) == 0);
+	CHECK(fs.GetUnrestricted() == 30);
+	CHECK(fs.GetShares()->back().first == 35);
+
+	fs.ChangeShare(2, -5);
+	CHECK(fs.GetShare(2) == 15);
+	CHECK(fs.GetUnrestricted() == 25);
+
+	fs.ChangeShare(4, 7);
+	CHECK(fs.GetShare(4) == 7);
+
+	fs.ChangeShare(1, INT_MIN);
+	CHECK(fs.GetShare(1) == 0);
+	CHECK(fs.GetShares()->size() == 3);
+}
+
+TEST_CASE("FlowStat - restrict and release")
+{
+	FlowStat fs(1, 10);
+	fs.AppendShare(2, 20);
+
+	fs.RestrictShare(1);
+	CHECK(fs.GetUnrestricted() == 20);
+	CHECK(fs.GetShares()->back().second == 1);
+	CHECK(fs.GetShare(2) == 20);
+
+	fs.ReleaseShare(1);
+	CHECK(fs.GetShares()->front().second == 1);
+	CHECK(fs.GetUnrestricted() == fs.GetShares()->back().first);
+	CHECK(fs.GetShare(2) == 20);
+}
+
+TEST_CASE("FlowStat - scale and invalidate")
+{
+	FlowStat fs(1, 60);
+	fs.AppendShare(2, 120);
+
+	fs.ScaleToMonthly(60);
+	CHECK(fs.GetShare(1) == 30);
+	CHECK(fs.GetShare(2) == 60);
+	CHECK(fs.GetUnrestricted() == 90);
+
+	fs.Invalidate();
+	CHECK(fs.GetShare(1) == 1);
+	CHECK(fs.GetShare(2) == 1);
+	CHECK(fs.GetUnrestricted() == 2);
+}
+
+TEST_CASE("FlowStatMap - sorted by origin")
+{
+	FlowStatMap flows;
+	flows.AddFlow(5, 1, 10);
+	flows.AddFlow(2, 1, 10);
+	flows.AddFlow(9, 3, 10);
+	flows.AddFlow(2, 3, 5);
+
+	CHECK(flows.size() == 3);
+	CHECK(std::is_sorted(flows.begin(), flows.end(), [](const auto &a, const auto &b) { return a.first < b.first; }));
+	CHECK(flows.GetFlowFrom(2) == 15);
+	CHECK(flows.GetFlowFromVia(2, 3) == 5);
+	CHECK(flows.GetFlowVia(1) == 20);
+	CHECK(flows.GetFlow() == 35);
+	CHECK(flows.find(4) == flows.end());
+
+	CHECK(flows.insert(std::make_pair(StationID(5), FlowStat(7, 1))).second == false);
+	CHECK(flows.erase(StationID(5)) == 1);
+	CHECK(flows.erase(StationID(5)) == 0);
+
+	StationIDStack erased = flows.DeleteFlows(3);
+	CHECK(erased.Pop() == 9);
+	CHECK(erased.IsEmpty());
+	CHECK(flows.size() == 1);
+
+	FlowStatMap other;
+	other.AddFlow(1, 4, 1);
+	other.AddFlow(2, 4, 1);
+	other.AddFlow(7, 4, 1);
+	flows.Merge(other);
+	CHECK(flows.size() == 3);
+	CHECK(flows.GetFlowFrom(2) == 10);
+	CHECK(flows.begin()->first == 1);
+	CHECK((flows.end() - 1)->first == 7);
+}
+
+TEST_CASE("FlowStatMap - sort appended flows")
+{
+	FlowStatMap flows;
+	flows.emplace_back(StationID(4), FlowStat(1, 10));
+	flows.emplace_back(StationID(2), FlowStat(1, 20));
+	flows.emplace_back(StationID(4), FlowStat(3, 30));
+	flows.emplace_back(StationID(3), FlowStat(1, 40));
+	flows.SortByOrigin();
+
+	CHECK(flows.size() == 3);
+	CHECK(std::is_sorted(flows.begin(), flows.end(), [](const auto &a, const auto &b) { return a.first < b.first; }));
+	CHECK(flows.GetFlowFrom(2) == 20);
+	CHECK(flows.GetFlowFrom(3) == 40);
+	/* The first flow of an origin is kept, like inserting them one by one would do. */
+	CHECK(flows.GetFlowFromVia(4, 1) == 10);
+	CHECK(flows.GetFlowFromVia(4, 3) == 0);
+
+	flows.SortByOrigin();
+	CHECK(flows.size() == 3);
+}
@@ -0,0 +1,116 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file linkgraph_mcf.cpp Test functionality of the multi-commodity flow solver of the link graph. */
+
+#include "../stdafx.h"
+
+#include "../3rdparty/catch2/catch.hpp"
+
+#include "../map_func.h"
+#include "../settings_type.h"
+#include "../worker_pool.h"
+#include "../core/random_func.hpp"
+#include "../linkgraph/flowmapper.h"
+#include "../linkgraph/mcf.h"
+
+/** Number of nodes of the link graph; enough to search the paths of multiple sources at once. */
+static const uint TEST_NODES = 160;
+
+/**
+ * Create a link graph with a ring of links and some random links across it. The links have
+ * little capacity compared to the demand, so pushing flow saturates them often.
+ * @return The link graph.
+ */
+static LinkGraph *CreateTestLinkGraph()
+{
+	Randomizer random;
+	random.SetSeed(0x4D43462E);
+
+	LinkGraph *lg = new LinkGraph(0);
+	lg->Init(TEST_NODES);
+	for (NodeID node = 0; node < TEST_NODES; ++node) {
+		(*lg)[node].station = node;
+		(*lg)[node].supply = 100000;
+		(*lg)[node].UpdateLocation(TileXY(1 + random.Next(Map::MaxX() - 1), 1 + random.Next(Map::MaxY() - 1)));
+	}
+
+	for (NodeID node = 0; node < TEST_NODES; ++node) {
+		NodeID next = (node + 1) % TEST_NODES;
+		(*lg)[node].UpdateEdge(next, 20 + random.Next(40), 0, 0, EUM_UNRESTRICTED);
+		(*lg)[next].UpdateEdge(node, 20 + random.Next(40), 0, 0, EUM_UNRESTRICTED);
+
+		NodeID across = random.Next(TEST_NODES);
+		if (across == node) continue;
+		(*lg)[node].UpdateEdge(across, 10 + random.Next(20), 0, 0, EUM_UNRESTRICTED);
+		(*lg)[across].UpdateEdge(node, 10 + random.Next(20), 0, 0, EUM_UNRESTRICTED);
+	}
+	return lg;
+}
+
+/**
+ * Run the multi-commodity flow solver and the flow mapper, like a link graph job does, on a link graph.
+ * @param lg The link graph.
+ * @param threads Number of worker threads to use.
+ * @return The flow over every edge, followed by the resulting flows at every node.
+ */
+static std::vector<uint> RunSolver(const LinkGraph &lg, uint8_t threads)
+{
+	_worker_threads = threads;
+
+	LinkGraphJob job(lg);
+	job.Init();
+
+	Randomizer random;
+	random.SetSeed(0x44454D44);
+	for (NodeID from = 0; from < TEST_NODES; ++from) {
+		for (uint i = 0; i < 8; i++) {
+			NodeID to = random.Next(TEST_NODES);
+			if (to != from) job[from].DeliverSupply(to, 10 + random.Next(200));
+		}
+	}
+
+	MCFHandler<MCF1stPass>().Run(job);
+	FlowMapper(false).Run(job);
+	MCFHandler<MCF2ndPass>().Run(job);
+	FlowMapper(false).Run(job);
+
+	std::vector<uint> result;
+	for (NodeID node = 0; node < TEST_NODES; ++node) {
+		for (const Edge &edge : job[node].edges) result.push_back(edge.Flow());
+	}
+	for (NodeID node = 0; node < TEST_NODES; ++node) {
+		for (const auto &[origin, flow] : job[node].flows) {
+			result.push_back(origin);
+			result.push_back(flow.GetUnrestricted());
+			for (const auto &[share, via] : *flow.GetShares()) {
+				result.push_back(share);
+				result.push_back(via);
+			}
+		}
+	}
+
+	_worker_threads = 1;
+	return result;
+}
+
+TEST_CASE("MCF - searching the paths of multiple sources at once gives the same flows")
+{
+	Map::Allocate(256, 256);
+	_settings_game.linkgraph.accuracy = 16;
+	_settings_game.linkgraph.short_path_saturation = 80;
+
+	REQUIRE(LinkGraph::CanAllocateItem());
+	LinkGraph *lg = CreateTestLinkGraph();
+
+	std::vector<uint> serial = RunSolver(*lg, 1);
+	std::vector<uint> parallel = RunSolver(*lg, 4);
+	CHECK(!serial.empty());
+	CHECK(serial == parallel);
+
+	delete lg;
+}
@@ -0,0 +1,266 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file newgrf_spritegroup.cpp Test functionality of compiling deterministic sprite groups and memoising callbacks. */
+
+#include "../stdafx.h"
+
+#include "../3rdparty/catch2/catch.hpp"
+
+#include "../core/random_func.hpp"
+#include "../newgrf_callback_cache.h"
+#include "../newgrf_spritegroup.h"
+
+extern TemporaryStorageArray<int32_t, 0x110> _temp_store;
+
+static uint _test_variable_reads = 0;    ///< Number of reads of variables of the test scope.
+static uint32_t _test_variable_offset = 0; ///< Offset added to the variables of the test scope.
+
+/** Scope with variables that only depend on the variable and its parameter. */
+struct TestScopeResolver : ScopeResolver {
+	TestScopeResolver(ResolverObject &ro) : ScopeResolver(ro) {}
+
+	uint32_t GetVariable(byte variable, uint32_t parameter, bool *available) const override
+	{
+		_test_variable_reads++;
+		if (variable == 0x45) {
+			*available = false;
+			return UINT_MAX;
+		}
+		return ((variable * 0x9E3779B9U) ^ (parameter * 0x85EBCA6BU)) + _test_variable_offset;
+	}
+};
+
+/** Resolver that resolves everything in the test scope. */
+struct TestResolverObject : ResolverObject {
+	TestScopeResolver self_scope;
+
+	TestResolverObject(CallbackID callback = CBID_NO_CALLBACK) : ResolverObject(nullptr, callback, 0x1234, 0xFFFF0042), self_scope(*this) {}
+
+	ScopeResolver *GetScope(VarSpriteGroupScope, byte) override
+	{
+		return &this->self_scope;
+	}
+};
+
+/**
+ * Create a deterministic sprite group.
+ * @param size Size of the group.
+ * @param adjusts The adjusts of the group.
+ * @param ranges The ranges of the group; none for a calculated result.
+ * @param default_group The default group.
+ * @return The group.
+ */
+static DeterministicSpriteGroup *MakeGroup(DeterministicSpriteGroupSize size, const std::vector<DeterministicSpriteGroupAdjust> &adjusts, const std::vector<DeterministicSpriteGroupRange> &ranges, const SpriteGroup *default_group)
+{
+	assert(SpriteGroup::CanAllocateItem());
+	DeterministicSpriteGroup *group = new DeterministicSpriteGroup();
+	group->var_scope = VSG_SCOPE_SELF;
+	group->size = size;
+	group->adjusts = adjusts;
+	group->ranges = ranges;
+	group->default_group = default_group;
+	group->error_group = ranges.empty() ? default_group : ranges[0].group;
+	group->calculated_result = ranges.empty();
+	return group;
+}
+
+/**
+ * Create a random deterministic sprite group.
+ * @param seed Seed of the group; the same seed gives the same group.
+ * @param compile Whether to compile the group and its procedures.
+ * @param results The groups the ranges can resolve to.
+ * @param depth Depth of procedure calls.
+ * @return The group.
+ */
+static const SpriteGroup *MakeRandomGroup(uint32_t seed, bool compile, const std::vector<const SpriteGroup *> &results, uint depth = 0)
+{
+	static const byte variables[] = { 0x1A, 0x1A, 0x1A, 0x10, 0x18, 0x1C, 0x40, 0x41, 0x41, 0x60, 0x60, 0x7B, 0x7D, 0x7E };
+
+	Randomizer r;
+	r.SetSeed(seed);
+
+	DeterministicSpriteGroupSize size = (DeterministicSpriteGroupSize)r.Next(3);
+	uint32_t type_max = size == DSG_SIZE_BYTE ? 0xFF : (size == DSG_SIZE_WORD ? 0xFFFF : 0xFFFFFFFF);
+
+	std::vector<DeterministicSpriteGroupAdjust> adjusts(1 + r.Next(8));
+	for (DeterministicSpriteGroupAdjust &adjust : adjusts) {
+		adjust = {};
+		do {
+			adjust.operation = (DeterministicSpriteGroupAdjustOperation)r.Next(DSGA_OP_SAR + 1);
+		} while (adjust.operation == DSGA_OP_SDIV || adjust.operation == DSGA_OP_SMOD);
+		if (&adjust == &adjusts.front()) adjust.operation = DSGA_OP_ADD;
+
+		adjust.variable = r.Next(64) == 0 ? 0x45 : variables[r.Next(lengthof(variables))];
+		if (adjust.variable == 0x7E && depth > 1) adjust.variable = 0x40;
+		if (adjust.variable == 0x7E) adjust.subroutine = MakeRandomGroup(r.Next(), compile, results, depth + 1);
+		if (adjust.variable == 0x7B) adjust.parameter = r.Next(2) == 0 ? 0x40 : 0x60;
+		if (adjust.variable == 0x60 || adjust.variable == 0x7D) adjust.parameter = r.Next(4);
+
+		adjust.shift_num = r.Next(4) == 0 ? r.Next(32) : 0;
+		static const uint32_t masks[] = { 0x3, 0xF, 0xFF, 0xFFFF, 0xFFFFFFFF };
+		adjust.and_mask = (r.Next(4) == 0 ? r.Next() : masks[r.Next(lengthof(masks))]) & type_max;
+		if (r.Next(6) == 0) {
+			adjust.type = r.Next(2) == 0 ? DSGA_TYPE_DIV : DSGA_TYPE_MOD;
+			adjust.add_val = r.Next(16);
+			adjust.divmod_val = 1 + r.Next(100);
+		}
+	}
+
+	std::vector<DeterministicSpriteGroupRange> ranges;
+	if (r.Next(4) != 0) {
+		uint32_t low = r.Next(4);
+		while (ranges.size() < 1 + r.Next(8) && low <= type_max - 64) {
+			uint32_t high = low + r.Next(4);
+			ranges.push_back({ results[r.Next((uint)results.size())], low, high });
+			low = high + 1 + r.Next(3);
+		}
+		if (r.Next(4) == 0) ranges.push_back({ results[r.Next((uint)results.size())], type_max - r.Next(64), type_max });
+	}
+
+	DeterministicSpriteGroup *group = MakeGroup(size, adjusts, ranges, results[r.Next((uint)results.size())]);
+	if (compile) group->Compile();
+	return group;
+}
+
+/** Outcome of resolving a group. */
+struct Outcome {
+	uint32_t result;     ///< Callback result of the resolved group.
+	uint32_t last_value; ///< Last value of the resolver.
+	std::vector<uint32_t> registers; ///< Contents of the temporary storage.
+
+	bool operator==(const Outcome &other) const = default;
+};
+
+/**
+ * Resolve a group.
+ * @param group The group.
+ * @return What resolving the group resulted in.
+ */
+static Outcome ResolveGroup(const SpriteGroup *group)
+{
+	TestResolverObject object;
+	const SpriteGroup *result = SpriteGroup::Resolve(group, object);
+
+	Outcome outcome{ result == nullptr ? UINT_MAX : result->GetCallbackResult(), object.last_value, {} };
+	for (uint i = 0; i < 0x110; i++) outcome.registers.push_back(GetRegister(i));
+	return outcome;
+}
+
+TEST_CASE("DeterministicSpriteGroup - compiled program")
+{
+	std::vector<const SpriteGroup *> results;
+	assert(SpriteGroup::CanAllocateItem(8));
+	for (uint i = 0; i < 8; i++) results.push_back(new CallbackResultSpriteGroup(i, true));
+
+	SECTION("constants are folded") {
+		std::vector<DeterministicSpriteGroupAdjust> adjusts(3);
+		adjusts[0] = { DSGA_OP_ADD, DSGA_TYPE_NONE, 0x1A, 0, 0, 0x5, 0, 0, nullptr };
+		adjusts[1] = { DSGA_OP_MUL, DSGA_TYPE_NONE, 0x1A, 0, 0, 0x3, 0, 0, nullptr };
+		adjusts[2] = { DSGA_OP_SUB, DSGA_TYPE_NONE, 0x1A, 0, 0, 0x1, 0, 0, nullptr };
+		DeterministicSpriteGroup *group = MakeGroup(DSG_SIZE_BYTE, adjusts, { { results[1], 10, 20 } }, results[0]);
+		group->Compile();
+
+		REQUIRE(group->program.size() == 1);
+		CHECK(group->program[0].operand == DSGO_CONSTANT);
+		CHECK(group->program[0].constant == 14);
+		REQUIRE(group->range_table.size() == 1);
+		CHECK(group->range_table[0] == results[1]);
+		CHECK(ResolveGroup(group).result == 1);
+	}
+
+	SECTION("repeated reads are cached") {
+		std::vector<DeterministicSpriteGroupAdjust> adjusts(3);
+		adjusts[0] = { DSGA_OP_ADD, DSGA_TYPE_NONE, 0x40, 0, 0, 0xFF, 0, 0, nullptr };
+		adjusts[1] = { DSGA_OP_XOR, DSGA_TYPE_NONE, 0x40, 0, 8, 0xFF, 0, 0, nullptr };
+		adjusts[2] = { DSGA_OP_ADD, DSGA_TYPE_NONE, 0x41, 0, 0, 0xFF, 0, 0, nullptr };
+		DeterministicSpriteGroup *group = MakeGroup(DSG_SIZE_DWORD, adjusts, {}, results[0]);
+		group->Compile();
+
+		REQUIRE(group->program.size() == 3);
+		CHECK(group->program[0].operand == DSGO_CACHED);
+		CHECK(group->program[1].operand == DSGO_CACHED);
+		CHECK(group->program[0].cache_slot == group->program[1].cache_slot);
+		CHECK(group->program[2].operand == DSGO_VARIABLE);
+	}
+
+	SECTION("unreachable ranges are removed") {
+		std::vector<DeterministicSpriteGroupAdjust> adjusts(1);
+		adjusts[0] = { DSGA_OP_ADD, DSGA_TYPE_NONE, 0x40, 0, 0, 0x3, 0, 0, nullptr };
+		DeterministicSpriteGroup *group = MakeGroup(DSG_SIZE_WORD, adjusts, { { results[1], 0, 1 }, { results[2], 2, 5 }, { results[3], 6, 9 } }, results[0]);
+		group->Compile();
+
+		REQUIRE(group->ranges.size() == 2);
+		CHECK(group->ranges[1].high == 3);
+		REQUIRE(group->range_table.size() == 4);
+		CHECK(group->range_table[0] == results[1]);
+		CHECK(group->range_table[3] == results[2]);
+	}
+
+	SECTION("same outcome as interpreted") {
+		for (uint32_t seed = 1; seed <= 2000; seed++) {
+			const SpriteGroup *compiled = MakeRandomGroup(seed, true, results);
+			const SpriteGroup *interpreted = MakeRandomGroup(seed, false, results);
+			INFO("seed " << seed);
+			CHECK(ResolveGroup(compiled) == ResolveGroup(interpreted));
+		}
+	}
+
+	_spritegroup_pool.CleanPool();
+}
+
+TEST_CASE("ResolveMemoisedCallback - result of the cache")
+{
+	std::vector<const SpriteGroup *> results;
+	assert(SpriteGroup::CanAllocateItem(4));
+	for (uint i = 0; i < 4; i++) results.push_back(new CallbackResultSpriteGroup(i, true));
+
+	/* Result 1 for variable 40 below 0x80, otherwise 2; variable 40 is also stored in register 5. */
+	std::vector<DeterministicSpriteGroupAdjust> adjusts(2);
+	adjusts[0] = { DSGA_OP_ADD, DSGA_TYPE_NONE, 0x40, 0, 0, 0xFF, 0, 0, nullptr };
+	adjusts[1] = { DSGA_OP_STO, DSGA_TYPE_NONE, 0x1A, 0, 0, 0x5, 0, 0, nullptr };
+	const SpriteGroup *group = MakeGroup(DSG_SIZE_DWORD, adjusts, { { results[1], 0, 0x7F } }, results[2]);
+
+	_cache_newgrf_callbacks = true;
+	auto resolve = [&]() {
+		TestResolverObject object(CBID_VEHICLE_REFIT_CAPACITY);
+		object.root_spritegroup = group;
+		return object.ResolveCallback();
+	};
+	uint32_t var40 = 0x40 * 0x9E3779B9U;
+	_test_variable_offset = 0x110 - (var40 & 0xFF);
+
+	_test_variable_reads = 0;
+	CHECK(resolve() == 1);
+	CHECK(_test_variable_reads == 1);
+	CHECK(GetRegister(5) == ((var40 + _test_variable_offset) & 0xFF));
+
+	/* Same variable, so only the recorded variable is read again. */
+	_temp_store.ClearChanges();
+	_test_variable_reads = 0;
+	CHECK(resolve() == 1);
+	CHECK(_test_variable_reads == 1);
+	CHECK(GetRegister(5) == ((var40 + _test_variable_offset) & 0xFF));
+
+	/* The variable changed, so the callback is resolved again. */
+	_test_variable_offset += 0x80;
+	_test_variable_reads = 0;
+	CHECK(resolve() == 2);
+	CHECK(_test_variable_reads == 2);
+	CHECK(GetRegister(5) == ((var40 + _test_variable_offset) & 0xFF));
+
+	/* Without the setting nothing is memoised, so the changed variable is only read to resolve the callback. */
+	_cache_newgrf_callbacks = false;
+	_test_variable_offset -= 0x80;
+	_test_variable_reads = 0;
+	CHECK(resolve() == 1);
+	CHECK(_test_variable_reads == 1);
+
+	_test_variable_offset = 0;
+	ClearNewGRFCallbackCache();
+	_spritegroup_pool.CleanPool();
+}
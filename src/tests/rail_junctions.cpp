@@ -0,0 +1,71 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file rail_junctions.cpp Test functionality of updating the graph of rail junctions. */
+
+#include "../stdafx.h"
+
+#include "../3rdparty/catch2/catch.hpp"
+
+#include "../map_func.h"
+#include "../rail_map.h"
+#include "../tunnel_map.h"
+#include "../clear_map.h"
+#include "../pathfinder/rail_junctions.h"
+
+/**
+ * Get the distances to a depot of all positions on a row of tiles.
+ * @param depot The depot.
+ * @param y The row.
+ * @return The distance of every trackdir of every tile of the row, except the tiles at the border of the map.
+ */
+static std::vector<int> GetRowDistances(TileIndex depot, uint y)
+{
+	RailJunctionDistanceField field = GetRailJunctionDistances(depot);
+	std::vector<int> distances;
+	for (uint x = 1; x < Map::MaxX(); x++) {
+		for (Trackdir td : { TRACKDIR_X_NE, TRACKDIR_X_SW }) distances.push_back(field.GetDistance(TileXY(x, y), td));
+	}
+	return distances;
+}
+
+TEST_CASE("RailJunctions - building a tunnel updates the graph around both ends")
+{
+	Map::Allocate(64, 64);
+
+	/* A depot with track leading to a dead end, and more track further along the same row. */
+	const uint y = 10;
+	TileIndex depot = TileXY(5, y);
+	MakeRailDepot(depot, OWNER_NONE, 0, DIAGDIR_SW, RAILTYPE_RAIL);
+	for (uint x = 6; x <= 10; x++) MakeRailNormal(TileXY(x, y), OWNER_NONE, TRACK_BIT_X, RAILTYPE_RAIL);
+	for (uint x = 16; x <= 20; x++) MakeRailNormal(TileXY(x, y), OWNER_NONE, TRACK_BIT_X, RAILTYPE_RAIL);
+
+	InvalidateRailJunctions(INVALID_TILE);
+	CHECK(GetRowDistances(depot, y)[(18 - 1) * 2] == RAIL_JUNCTION_UNREACHABLE);
+
+	/* Connect both parts with a tunnel, but only report its entrance as changed. */
+	MakeRailTunnel(TileXY(11, y), OWNER_NONE, DIAGDIR_SW, RAILTYPE_RAIL);
+	MakeRailTunnel(TileXY(15, y), OWNER_NONE, DIAGDIR_NE, RAILTYPE_RAIL);
+	InvalidateRailJunctions(TileXY(11, y));
+	std::vector<int> updated = GetRowDistances(depot, y);
+	CHECK(updated[(18 - 1) * 2] != RAIL_JUNCTION_UNREACHABLE);
+
+	InvalidateRailJunctions(INVALID_TILE);
+	std::vector<int> built = GetRowDistances(depot, y);
+	CHECK(updated == built);
+
+	/* Removing the tunnel again, reporting both ends like the command does. */
+	MakeClear(TileXY(11, y), CLEAR_GRASS, 3);
+	MakeClear(TileXY(15, y), CLEAR_GRASS, 3);
+	InvalidateRailJunctions(TileXY(11, y));
+	InvalidateRailJunctions(TileXY(15, y));
+	updated = GetRowDistances(depot, y);
+	CHECK(updated[(18 - 1) * 2] == RAIL_JUNCTION_UNREACHABLE);
+
+	InvalidateRailJunctions(INVALID_TILE);
+	CHECK(updated == GetRowDistances(depot, y));
+}
@@ -0,0 +1,43 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file spritecache.cpp Test functionality of the size classes of the sprite cache. */
+
+#include "../stdafx.h"
+
+#include "../3rdparty/catch2/catch.hpp"
+
+#include "../spritecache.h"
+#include "../spritecache_internal.h"
+
+TEST_CASE("GetSpriteSizeClass - smallest class that fits")
+{
+	CHECK(GetSpriteSizeClass(1) == 0);
+	CHECK(GetSpriteSizeClass(64) == 0);
+	CHECK(GetSpriteSizeClass(65) == 1);
+	CHECK(GetSpriteSizeClassSize(1) == 80);
+	CHECK(GetSpriteSizeClassSize(4) == 128);
+	CHECK(GetSpriteSizeClassSize(5) == 160);
+
+	for (size_t size = 1; size < 1024 * 1024; size += 1 + size / 7) {
+		uint size_class = GetSpriteSizeClass(size);
+		CHECK(GetSpriteSizeClassSize(size_class) >= size);
+		if (size_class > 0) CHECK(GetSpriteSizeClassSize(size_class - 1) < size);
+	}
+
+	CHECK(GetSpriteSizeClassSize(GetSpriteSizeClass((size_t)UINT32_MAX + 1)) == (size_t)UINT32_MAX + 1);
+}
+
+TEST_CASE("GetSpriteSizeClass - at most a quarter wasted")
+{
+	for (uint size_class = 1; GetSpriteSizeClassSize(size_class) <= 1024 * 1024; size_class++) {
+		size_t size = GetSpriteSizeClassSize(size_class);
+		CHECK(GetSpriteSizeClass(size) == size_class);
+		CHECK(GetSpriteSizeClass(size + 1) == size_class + 1);
+		CHECK(GetSpriteSizeClassSize(size_class + 1) - size <= size / 4);
+	}
+}
@@ -0,0 +1,123 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file viewport_sprite_sorter.cpp Test functionality of sorting viewport sprites in clusters. */
+
+#include "../stdafx.h"
+
+#include "../3rdparty/catch2/catch.hpp"
+
+#include "../core/random_func.hpp"
+#include "../viewport_sprite_sorter.h"
+#include "../worker_pool.h"
+
+/** Simple sorter for the tests, that orders sprites by xmin + ymin. */
+static void SortByXYMin(ParentSpriteToSortVector *psdv)
+{
+	std::stable_sort(psdv->begin(), psdv->end(), [](const ParentSpriteToDraw *a, const ParentSpriteToDraw *b) {
+		return a->xmin + a->ymin < b->xmin + b->ymin;
+	});
+}
+
+/**
+ * Create sprites at random places on the screen.
+ * @param count Number of sprites.
+ * @param seed Seed for the random places.
+ * @return The sprites.
+ */
+static std::vector<ParentSpriteToDraw> MakeSprites(uint count, uint32_t seed)
+{
+	Randomizer r;
+	r.SetSeed(seed);
+
+	std::vector<ParentSpriteToDraw> sprites(count);
+	for (ParentSpriteToDraw &ps : sprites) {
+		ps.xmin = r.Next(1000);
+		ps.ymin = r.Next(1000);
+		ps.extent_left = r.Next(4000);
+		ps.extent_top = r.Next(4000);
+		ps.extent_right = ps.extent_left + r.Next(64);
+		ps.extent_bottom = ps.extent_top + r.Next(64);
+	}
+	return sprites;
+}
+
+/**
+ * Check that the clustered sort puts every pair of sprites that cover each other in the order of the sorter.
+ * @param sprites The sprites to sort.
+ * @return True if all overlapping sprites are in the right order.
+ */
+static bool SortsOverlappingSprites(std::vector<ParentSpriteToDraw> &sprites)
+{
+	ParentSpriteToSortVector psdv;
+	for (ParentSpriteToDraw &ps : sprites) psdv.push_back(&ps);
+	ViewportSortParentSpritesClustered(&psdv, &SortByXYMin);
+
+	ParentSpriteToSortVector expected;
+	for (ParentSpriteToDraw &ps : sprites) expected.push_back(&ps);
+	if (!std::is_permutation(psdv.begin(), psdv.end(), expected.begin())) return false;
+
+	for (size_t i = 0; i < psdv.size(); i++) {
+		for (size_t j = i + 1; j < psdv.size(); j++) {
+			const ParentSpriteToDraw *a = psdv[i];
+			const ParentSpriteToDraw *b = psdv[j];
+			bool overlap = a->extent_left < b->extent_right && b->extent_left < a->extent_right &&
+					a->extent_top < b->extent_bottom && b->extent_top < a->extent_bottom;
+			if (overlap && a->xmin + a->ymin > b->xmin + b->ymin) return false;
+		}
+	}
+	return true;
+}
+
+TEST_CASE("ViewportSortParentSpritesClustered - separate clusters")
+{
+	/* Two rows of sprites that overlap within each row, but not with the other row. */
+	std::vector<ParentSpriteToDraw> sprites(200);
+	for (int i = 0; i < 200; i++) {
+		ParentSpriteToDraw &ps = sprites[i];
+		ps.xmin = 200 - i;
+		ps.ymin = 0;
+		ps.extent_left = (i / 2) * 10;
+		ps.extent_right = ps.extent_left + 15;
+		ps.extent_top = (i % 2) * 100;
+		ps.extent_bottom = ps.extent_top + 10;
+	}
+
+	ParentSpriteToSortVector psdv;
+	for (ParentSpriteToDraw &ps : sprites) psdv.push_back(&ps);
+	ViewportSortParentSpritesClustered(&psdv, &SortByXYMin);
+
+	/* The cluster of the first sprite comes first, and each cluster is sorted on its own. */
+	for (int i = 0; i < 100; i++) {
+		CHECK(psdv[i] == &sprites[198 - i * 2]);
+		CHECK(psdv[100 + i] == &sprites[199 - i * 2]);
+	}
+}
+
+TEST_CASE("ViewportSortParentSpritesClustered - random sprites")
+{
+	_worker_threads = 1;
+	for (uint32_t seed = 1; seed <= 5; seed++) {
+		std::vector<ParentSpriteToDraw> sprites = MakeSprites(40, seed);
+		CHECK(SortsOverlappingSprites(sprites));
+
+		sprites = MakeSprites(800, seed);
+		CHECK(SortsOverlappingSprites(sprites));
+	}
+}
+
+TEST_CASE("ViewportSortParentSpritesClustered - threaded")
+{
+	_worker_threads = 4;
+	for (uint32_t seed = 1; seed <= 3; seed++) {
+		std::vector<ParentSpriteToDraw> sprites = MakeSprites(2000, seed);
+		CHECK(SortsOverlappingSprites(sprites));
+	}
+
+	_worker_threads = 1;
+	ShutdownWorkerPool();
+}
@@ -0,0 +1,69 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file worker_pool.cpp Test functionality from worker_pool. */
+
+#include "../stdafx.h"
+
+#include "../3rdparty/catch2/catch.hpp"
+
+#include "../worker_pool.h"
+
+#include <atomic>
+
+/**
+ * Run ParallelFor over \a count items and check every item is visited exactly once.
+ * @param count Number of items.
+ * @return True if every item was visited exactly once.
+ */
+static bool VisitsAllOnce(size_t count)
+{
+	std::vector<std::atomic<int>> visits(count);
+	ParallelFor(count, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) visits[i]++;
+	});
+	return std::all_of(visits.begin(), visits.end(), [](const std::atomic<int> &v) { return v == 1; });
+}
+
+TEST_CASE("ParallelFor - serial")
+{
+	_worker_threads = 1;
+	CHECK(GetWorkerThreadCount() == 1);
+	CHECK(VisitsAllOnce(0));
+	CHECK(VisitsAllOnce(1));
+	CHECK(VisitsAllOnce(1000));
+}
+
+TEST_CASE("ParallelFor - threaded")
+{
+	_worker_threads = 4;
+	CHECK(GetWorkerThreadCount() == 4);
+	for (int i = 0; i < 100; i++) {
+		CHECK(VisitsAllOnce(1));
+		CHECK(VisitsAllOnce(7));
+		CHECK(VisitsAllOnce(10000));
+	}
+
+	_worker_threads = 1;
+	ShutdownWorkerPool();
+}
+
+TEST_CASE("ParallelFor - nested")
+{
+	_worker_threads = 3;
+
+	std::atomic<size_t> total = 0;
+	ParallelFor(16, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			ParallelFor(16, [&](size_t inner_begin, size_t inner_end) { total += inner_end - inner_begin; });
+		}
+	});
+	CHECK(total == 16 * 16);
+
+	_worker_threads = 1;
+	ShutdownWorkerPool();
+}
@@ -0,0 +1,125 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file yapf_segment_cache.cpp Test functionality of dropping the cached costs of YAPF rail segments on track changes. */
+
+#include "../stdafx.h"
+
+#include "../3rdparty/catch2/catch.hpp"
+
+#include "../map_func.h"
+#include "../rail_map.h"
+#include "../clear_map.h"
+#include "../signal_func.h"
+#include "../settings_type.h"
+#include "../train.h"
+#include "../pathfinder/yapf/yapf.h"
+#include "../pathfinder/yapf/yapf_cache.h"
+
+/** Row of the main line of the test network. */
+static const uint TEST_ROW = 10;
+
+/**
+ * Find the nearest depot of a train with the cached segment costs, and again after flushing the caches.
+ * @param v The train.
+ * @return True iff the cache was used, and both searches found the same depot with the same cost.
+ */
+static bool CachedDepotMatchesRecomputed(const Train *v)
+{
+	uint64_t hits = YapfGetSegmentCacheStats().hits;
+	FindDepotData cached = YapfTrainFindNearestDepot(v, 0);
+	bool cache_used = YapfGetSegmentCacheStats().hits > hits;
+
+	YapfNotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
+	FindDepotData recomputed = YapfTrainFindNearestDepot(v, 0);
+
+	return cache_used && cached.tile == recomputed.tile && cached.best_length == recomputed.best_length && cached.reverse == recomputed.reverse;
+}
+
+/**
+ * Put a block signal on the main line.
+ * @param x The column of the signal.
+ * @param signals The signals to put on the track, see #SetPresentSignals.
+ */
+static void BuildSignal(uint x, uint signals)
+{
+	TileIndex tile = TileXY(x, TEST_ROW);
+	SetHasSignals(tile, true);
+	SetSignalType(tile, TRACK_X, SIGTYPE_BLOCK);
+	SetSignalVariant(tile, TRACK_X, SIG_ELECTRIC);
+	SetPresentSignals(tile, signals);
+	SetSignalStates(tile, signals);
+	YapfNotifyTrackLayoutChange(tile, TRACK_X);
+}
+
+TEST_CASE("YAPF - cached rail segment costs match recomputed ones after track changes")
+{
+	Map::Allocate(64, 64);
+	ResetRailTypes();
+
+	_settings_game.pf.forbid_90_deg = false;
+	_settings_game.pf.yapf.max_search_nodes = 10000;
+	_settings_game.pf.yapf.rail_firstred_penalty = 10 * YAPF_TILE_LENGTH;
+	_settings_game.pf.yapf.rail_curve45_penalty = YAPF_TILE_LENGTH;
+	_settings_game.pf.yapf.rail_depot_reverse_penalty = 50 * YAPF_TILE_LENGTH;
+	/* Without look-ahead every segment that does not start at the train is cached globally. */
+	_settings_game.pf.yapf.rail_look_ahead_max_signals = 0;
+
+	/* A main line between two depots, with a short dead end and a branch to a third depot. */
+	MakeRailDepot(TileXY(5, TEST_ROW), OWNER_NONE, 0, DIAGDIR_SW, RAILTYPE_RAIL);
+	for (uint x = 6; x <= 44; x++) MakeRailNormal(TileXY(x, TEST_ROW), OWNER_NONE, TRACK_BIT_X, RAILTYPE_RAIL);
+	MakeRailDepot(TileXY(45, TEST_ROW), OWNER_NONE, 1, DIAGDIR_NE, RAILTYPE_RAIL);
+
+	SetTrackBits(TileXY(28, TEST_ROW), TRACK_BIT_X | TRACK_BIT_LOWER);
+	for (uint y = TEST_ROW + 1; y <= TEST_ROW + 2; y++) MakeRailNormal(TileXY(28, y), OWNER_NONE, TRACK_BIT_Y, RAILTYPE_RAIL);
+
+	SetTrackBits(TileXY(20, TEST_ROW), TRACK_BIT_X | TRACK_BIT_LOWER);
+	for (uint y = TEST_ROW + 1; y <= TEST_ROW + 4; y++) MakeRailNormal(TileXY(20, y), OWNER_NONE, TRACK_BIT_Y, RAILTYPE_RAIL);
+	MakeRailDepot(TileXY(20, TEST_ROW + 5), OWNER_NONE, 2, DIAGDIR_NW, RAILTYPE_RAIL);
+	YapfNotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
+
+	REQUIRE(Train::CanAllocateItem());
+	Train *v = new Train();
+	v->tile = TileXY(30, TEST_ROW);
+	v->track = TRACK_BIT_X;
+	v->direction = DIR_NE;
+	v->owner = OWNER_NONE;
+	v->railtype = RAILTYPE_RAIL;
+	v->compatible_railtypes = RAILTYPES_RAIL;
+	v->gcache.cached_total_length = 8;
+
+	/* Fill the caches. */
+	FindDepotData initial = YapfTrainFindNearestDepot(v, 0);
+	CHECK(initial.tile == TileXY(20, TEST_ROW + 5));
+
+	/* A one-way signal facing away from the train blocks the way towards the branch. */
+	BuildSignal(25, SignalAgainstTrackdir(TRACKDIR_X_NE));
+	CHECK(CachedDepotMatchesRecomputed(v));
+
+	/* Removing a piece of the main line behind the train. */
+	MakeClear(TileXY(35, TEST_ROW), CLEAR_GRASS, 3);
+	YapfNotifyTrackLayoutChange(TileXY(35, TEST_ROW), TRACK_X);
+	CHECK(CachedDepotMatchesRecomputed(v));
+
+	/* Removing the signal again. */
+	SetHasSignals(TileXY(25, TEST_ROW), false);
+	YapfNotifyTrackLayoutChange(TileXY(25, TEST_ROW), TRACK_X);
+	CHECK(CachedDepotMatchesRecomputed(v));
+
+	/* Rebuilding the removed piece with a two-way signal on it. */
+	MakeRailNormal(TileXY(35, TEST_ROW), OWNER_NONE, TRACK_BIT_X, RAILTYPE_RAIL);
+	BuildSignal(35, SignalAlongTrackdir(TRACKDIR_X_NE) | SignalAgainstTrackdir(TRACKDIR_X_NE));
+	CHECK(CachedDepotMatchesRecomputed(v));
+
+	/* Cutting off the branch, so the train has to go to another depot. */
+	MakeClear(TileXY(20, TEST_ROW + 2), CLEAR_GRASS, 3);
+	YapfNotifyTrackLayoutChange(TileXY(20, TEST_ROW + 2), TRACK_Y);
+	CHECK(CachedDepotMatchesRecomputed(v));
+	CHECK(YapfTrainFindNearestDepot(v, 0).tile == TileXY(5, TEST_ROW));
+
+	_vehicle_pool.CleanPool();
+}
@@ -0,0 +1,250 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file tick_profiling.cpp Profiling of the game loop per subsystem and per game entity. */
+
+#include "stdafx.h"
+#include "tick_profiling.h"
+#include "console_func.h"
+#include "fileio_func.h"
+#include "string_func.h"
+#include "core/bitmath_func.hpp"
+#include "3rdparty/fmt/chrono.h"
+#include "timer/timer.h"
+#include "timer/timer_game_tick.h"
+
+#include <chrono>
+#include <unordered_map>
+
+#include "safeguards.h"
+
+bool _tick_profile_active = false;              ///< Whether a capture is running.
+thread_local bool _tick_profile_in_loop = false; ///< Whether the game loop of this thread is being measured.
+
+/** Names of the zones, and of the kind of entity they are measured for. */
+static const struct {
+	const char *name;   ///< Name of the zone.
+	const char *entity; ///< Name of the kind of entity, or \c nullptr if the zone is not measured per entity.
+} _tick_profile_zones[] = {
+	{ "gameloop",   nullptr    },
+	{ "tileloop",   nullptr    },
+	{ "vehicle",    "vehicle"  },
+	{ "station",    "station"  },
+	{ "town",       "town"     },
+	{ "industry",   "industry" },
+	{ "yapf_train", "vehicle"  },
+	{ "yapf_road",  "vehicle"  },
+	{ "yapf_ship",  "vehicle"  },
+	{ "newgrf",     "grf"      },
+};
+static_assert(lengthof(_tick_profile_zones) == TPZ_END);
+
+/** A single measurement of a zone. */
+struct TickProfileEvent {
+	uint64_t start;       ///< Start time, in nanoseconds since the start of the capture.
+	uint64_t duration;    ///< Duration in nanoseconds.
+	uint32_t id;          ///< Entity the zone was measured for.
+	TickProfileZone zone; ///< The zone.
+};
+
+/** A zone that has been entered but not left yet. */
+struct TickProfileOpenZone {
+	uint64_t start;       ///< Start time, in nanoseconds since the start of the capture.
+	uint32_t id;          ///< Entity the zone is measured for.
+	TickProfileZone zone; ///< The zone.
+};
+
+/** Accumulated measurements of a zone for a single entity. */
+struct TickProfileTotal {
+	uint64_t time = 0;  ///< Total time in nanoseconds.
+	uint64_t calls = 0; ///< Number of measurements.
+	uint64_t max = 0;   ///< Longest measurement in nanoseconds.
+};
+
+/** Maximum number of events kept for exporting; the totals keep being updated after that. */
+static const size_t MAX_TICK_PROFILE_EVENTS = 1 << 21;
+
+static std::chrono::steady_clock::time_point _tick_profile_epoch; ///< Start time of the capture.
+static uint64_t _tick_profile_start_tick;     ///< Game tick the capture started at.
+static uint64_t _tick_profile_ticks;          ///< Number of game ticks that have been captured.
+static std::vector<TickProfileEvent> _tick_profile_events;    ///< Events for exporting to a trace.
+static size_t _tick_profile_dropped;          ///< Number of events not kept as there were too many.
+static std::vector<TickProfileOpenZone> _tick_profile_stack;  ///< Zones currently being measured.
+static std::unordered_map<uint32_t, TickProfileTotal> _tick_profile_totals[TPZ_END]; ///< Totals per zone and entity.
+
+/**
+ * Get the current time of the capture.
+ * @return Nanoseconds since the start of the capture.
+ */
+static uint64_t GetTickProfileTime()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _tick_profile_epoch).count();
+}
+
+void TickProfileScope::Begin(TickProfileZone zone, uint32_t id)
+{
+	if (zone == TPZ_GAMELOOP) _tick_profile_in_loop = true;
+	_tick_profile_stack.push_back({ GetTickProfileTime(), id, zone });
+}
+
+void TickProfileScope::End()
+{
+	/* The capture was aborted while this zone was being measured. */
+	if (_tick_profile_stack.empty()) return;
+
+	TickProfileOpenZone open = _tick_profile_stack.back();
+	_tick_profile_stack.pop_back();
+
+	uint64_t duration = GetTickProfileTime() - open.start;
+	if (_tick_profile_events.size() < MAX_TICK_PROFILE_EVENTS) {
+		_tick_profile_events.push_back({ open.start, duration, open.id, open.zone });
+	} else {
+		_tick_profile_dropped++;
+	}
+
+	TickProfileTotal &total = _tick_profile_totals[open.zone][open.id];
+	total.time += duration;
+	total.calls++;
+	total.max = std::max(total.max, duration);
+
+	if (open.zone == TPZ_GAMELOOP) {
+		_tick_profile_in_loop = false;
+		_tick_profile_ticks++;
+	}
+}
+
+/** Discard all collected data. */
+static void ClearTickProfile()
+{
+	_tick_profile_events.clear();
+	_tick_profile_events.shrink_to_fit();
+	_tick_profile_stack.clear();
+	_tick_profile_in_loop = false;
+	for (auto &totals : _tick_profile_totals) totals.clear();
+	_tick_profile_dropped = 0;
+	_tick_profile_ticks = 0;
+}
+
+/**
+ * Stop the capture when the requested number of ticks has passed.
+ */
+static TimeoutTimer<TimerGameTick> _tick_profile_timeout(0, []()
+{
+	StopTickProfile();
+	IConsolePrint(CC_DEBUG, "Tick profiling stopped after {} ticks.", _tick_profile_ticks);
+});
+
+/**
+ * Start a new capture, discarding the data of the previous one.
+ * @param ticks Number of game ticks to stop the capture after, or 0 to keep capturing until stopped.
+ */
+void StartTickProfile(uint64_t ticks)
+{
+	ClearTickProfile();
+	_tick_profile_epoch = std::chrono::steady_clock::now();
+	_tick_profile_start_tick = TimerGameTick::counter;
+	_tick_profile_active = true;
+
+	if (ticks > 0) {
+		_tick_profile_timeout.Reset(ticks);
+	} else {
+		_tick_profile_timeout.Abort();
+	}
+}
+
+/** Stop capturing, but keep the data for inspection and exporting. */
+void StopTickProfile()
+{
+	_tick_profile_active = false;
+	_tick_profile_timeout.Abort();
+}
+
+/** Stop capturing and discard all collected data. */
+void AbortTickProfile()
+{
+	StopTickProfile();
+	ClearTickProfile();
+}
+
+/** Print the time spent per zone to the console. */
+void PrintTickProfileSummary()
+{
+	IConsolePrint(CC_INFO, "Tick profile of {} ticks, starting at tick {}{}:", _tick_profile_ticks, _tick_profile_start_tick, _tick_profile_active ? " (running)" : "");
+	for (uint zone = 0; zone < TPZ_END; zone++) {
+		TickProfileTotal sum;
+		for (const auto &[id, total] : _tick_profile_totals[zone]) {
+			sum.time += total.time;
+			sum.calls += total.calls;
+			sum.max = std::max(sum.max, total.max);
+		}
+		if (sum.calls == 0) continue;
+
+		IConsolePrint(CC_INFO, "  {:<10}: {:>10.3f} ms total, {:>10} calls, {:>9.3f} us avg, {:>9.3f} us max, {} entities",
+				_tick_profile_zones[zone].name, sum.time / 1e6, sum.calls, sum.time / 1e3 / sum.calls, sum.max / 1e3,
+				_tick_profile_zones[zone].entity != nullptr ? _tick_profile_totals[zone].size() : 0);
+	}
+	if (_tick_profile_dropped > 0) IConsolePrint(CC_WARNING, "  {} events were not kept for exporting.", _tick_profile_dropped);
+}
+
+/**
+ * Print the entities that took the most time in a zone to the console.
+ * @param zone_name Name of the zone.
+ * @param count Number of entities to print.
+ * @return False if there is no zone with the given name that is measured per entity.
+ */
+bool PrintTickProfileTop(const char *zone_name, uint count)
+{
+	uint zone = 0;
+	while (zone < TPZ_END && !StrEqualsIgnoreCase(zone_name, _tick_profile_zones[zone].name)) zone++;
+	if (zone == TPZ_END || _tick_profile_zones[zone].entity == nullptr) return false;
+
+	std::vector<std::pair<uint32_t, TickProfileTotal>> totals(_tick_profile_totals[zone].begin(), _tick_profile_totals[zone].end());
+	std::sort(totals.begin(), totals.end(), [](const auto &a, const auto &b) { return a.second.time > b.second.time || (a.second.time == b.second.time && a.first < b.first); });
+	if (totals.size() > count) totals.resize(count);
+
+	IConsolePrint(CC_INFO, "Top {} {} entities in zone '{}':", totals.size(), _tick_profile_zones[zone].entity, _tick_profile_zones[zone].name);
+	for (const auto &[id, total] : totals) {
+		std::string name = (zone == TPZ_NEWGRF) ? fmt::format("[{:08X}]", BSWAP32(id)) : fmt::format("{} {}", _tick_profile_zones[zone].entity, id);
+		IConsolePrint(CC_INFO, "  {:<16}: {:>10.3f} ms total, {:>8} calls, {:>9.3f} us max", name, total.time / 1e6, total.calls, total.max / 1e3);
+	}
+	return true;
+}
+
+/**
+ * Get the name of the file to export the trace to by default.
+ * @return File name in the screenshot directory.
+ */
+std::string GetTickProfileFilename()
+{
+	return fmt::format("{}tickprofile-{:%Y%m%d-%H%M}.json", FiosGetScreenshotDir(), fmt::localtime(time(nullptr)));
+}
+
+/**
+ * Write the collected events in the Chrome trace event format, so they can be inspected
+ * in e.g. chrome://tracing or Perfetto.
+ * @param filename File to write to.
+ * @return True if the file could be written.
+ */
+bool ExportTickProfile(const std::string &filename)
+{
+	FILE *f = FioFOpenFile(filename, "wt", Subdirectory::NO_DIRECTORY);
+	if (f == nullptr) return false;
+	FileCloser fcloser(f);
+
+	fmt::print(f, "{{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	bool first = true;
+	for (const TickProfileEvent &e : _tick_profile_events) {
+		fmt::print(f, "{}{{\"name\":\"{}\",\"cat\":\"game\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":{:.3f},\"dur\":{:.3f}", first ? "" : ",\n", _tick_profile_zones[e.zone].name, e.start / 1e3, e.duration / 1e3);
+		if (e.id != TICK_PROFILE_NO_ID) fmt::print(f, ",\"args\":{{\"id\":{}}}", e.id);
+		fmt::print(f, "}}");
+		first = false;
+	}
+	fmt::print(f, "\n]}}\n");
+
+	IConsolePrint(CC_DEBUG, "Wrote {} tick profile events to '{}'.", _tick_profile_events.size(), filename);
+	return true;
+}
@@ -0,0 +1,76 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file tick_profiling.h Profiling of the game loop per subsystem and per game entity. */
+
+#ifndef TICK_PROFILING_H
+#define TICK_PROFILING_H
+
+/**
+ * Parts of the game loop that can be measured. Zones can be nested; the time
+ * of a zone includes the time of the zones nested in it.
+ *
+ * @note When adding new zones here, also update the names in tick_profiling.cpp.
+ */
+enum TickProfileZone : uint8_t {
+	TPZ_GAMELOOP,        ///< A whole run of the game loop.
+	TPZ_TILELOOP,        ///< Running the tile loop procs of a tick.
+	TPZ_VEHICLE,         ///< Tick of a single vehicle.
+	TPZ_STATION_LOADING, ///< Loading and unloading at a single station.
+	TPZ_TOWN,            ///< Tick of a single town.
+	TPZ_INDUSTRY,        ///< Production of a single industry.
+	TPZ_YAPF_TRAIN,      ///< Train pathfinder call for a single vehicle.
+	TPZ_YAPF_ROAD,       ///< Road vehicle pathfinder call for a single vehicle.
+	TPZ_YAPF_SHIP,       ///< Ship pathfinder call for a single vehicle.
+	TPZ_NEWGRF,          ///< Resolving a sprite group of a single NewGRF.
+	TPZ_END,             ///< End marker.
+};
+
+/** Identifier used for zones that are not measured per game entity. */
+static const uint32_t TICK_PROFILE_NO_ID = UINT32_MAX;
+
+extern bool _tick_profile_active;
+extern thread_local bool _tick_profile_in_loop;
+
+/**
+ * RAII class for measuring a zone of the game loop, optionally for a single game entity.
+ * It does nothing unless a capture is running and it is used on the thread running the game loop.
+ */
+class TickProfileScope {
+	bool recording; ///< Whether this scope is being measured.
+
+	void Begin(TickProfileZone zone, uint32_t id);
+	void End();
+
+public:
+	/**
+	 * Start measuring a zone.
+	 * @param zone The zone being measured.
+	 * @param id Index of the vehicle, station, town or industry, or the GRFID, the zone is measured for.
+	 */
+	inline TickProfileScope(TickProfileZone zone, uint32_t id = TICK_PROFILE_NO_ID)
+	{
+		this->recording = (zone == TPZ_GAMELOOP) ? _tick_profile_active : _tick_profile_in_loop;
+		if (this->recording) this->Begin(zone, id);
+	}
+
+	/** Finish measuring the zone. */
+	inline ~TickProfileScope()
+	{
+		if (this->recording) this->End();
+	}
+};
+
+void StartTickProfile(uint64_t ticks);
+void StopTickProfile();
+void AbortTickProfile();
+void PrintTickProfileSummary();
+bool PrintTickProfileTop(const char *zone_name, uint count);
+bool ExportTickProfile(const std::string &filename);
+std::string GetTickProfileFilename();
+
+#endif /* TICK_PROFILING_H */
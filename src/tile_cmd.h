@@ -151,6 +151,18 @@ typedef Foundation GetFoundationProc(TileIndex tile, Slope tileh);
  */
 typedef CommandCost TerraformTileProc(TileIndex tile, DoCommandFlag flags, int z_new, Slope tileh_new);
 
+/**
+ * Tile callback function signature for checking whether the tile loop of a tile would do nothing.
+ *
+ * The tile loop calls this for a whole batch of tiles before running any of their tile loop procs, on worker threads.
+ * So it may only read the map, and it may only return true when running the tile loop procs of the other tiles
+ * in the batch cannot change the outcome.
+ *
+ * @param tile The tile to check.
+ * @return True if calling the tile loop proc of \a tile would not change anything, so it can be skipped.
+ */
+typedef bool TileLoopIdleProc(TileIndex tile);
+
 /**
  * Set of callback functions for performing tile operations of a given tile type.
  * @see TileType
@@ -170,6 +182,7 @@ struct TileTypeProcs {
 	VehicleEnterTileProc *vehicle_enter_tile_proc; ///< Called when a vehicle enters a tile
 	GetFoundationProc *get_foundation_proc;
 	TerraformTileProc *terraform_tile_proc;        ///< Called when a terraforming operation is about to take place
+	TileLoopIdleProc *tile_loop_idle_proc;         ///< Called to check whether the tile loop of the tile can be skipped
 };
 
 extern const TileTypeProcs * const _tile_type_procs[16];
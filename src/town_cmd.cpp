@@ -53,6 +53,7 @@
 #include "road_cmd.h"
 #include "terraform_cmd.h"
 #include "tunnelbridge_cmd.h"
+#include "tick_profiling.h"
 #include "timer/timer.h"
 #include "timer/timer_game_calendar.h"
 #include "timer/timer_game_economy.h"
@@ -889,6 +890,7 @@ void OnTick_Town()
 	if (_game_mode == GM_EDITOR) return;
 
 	for (Town *t : Town::Iterate()) {
+		TickProfileScope tick_profile(TPZ_TOWN, t->index);
 		TownTickHandler(t);
 	}
 }
@@ -3968,6 +3970,7 @@ extern const TileTypeProcs _tile_type_town_procs = {
 	nullptr,                    // vehicle_enter_tile_proc
 	GetFoundation_Town,      // get_foundation_proc
 	TerraformTile_Town,      // terraform_tile_proc
+	nullptr,                 // tile_loop_idle_proc
 };
 
 
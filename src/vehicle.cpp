@@ -60,6 +60,7 @@
 #include "timer/timer_game_calendar.h"
 #include "timer/timer_game_economy.h"
 #include "timer/timer_game_tick.h"
+#include "tick_profiling.h"
 
 #include "table/strings.h"
 
@@ -372,32 +373,39 @@ Vehicle::Vehicle(VehicleType type)
 	this->last_loading_station = INVALID_STATION;
 }
 
-/* Size of the hash, 6 = 64 x 64, 7 = 128 x 128. Larger sizes will (in theory) reduce hash
- * lookup times at the expense of memory usage. */
-const int HASH_BITS = 7;
-const int HASH_SIZE = 1 << HASH_BITS;
-const int HASH_MASK = HASH_SIZE - 1;
-const int TOTAL_HASH_SIZE = 1 << (HASH_BITS * 2);
-const int TOTAL_HASH_MASK = TOTAL_HASH_SIZE - 1;
+/* Maximum size of the tile hash per axis, 10 = 1024 x 1024. The hash is sized to the map, so
+ * maps up to this size get one bucket per tile; larger maps share a bucket between tiles that
+ * are a multiple of (1 << MAX_TILE_HASH_BITS) apart. */
+static const uint MAX_TILE_HASH_BITS = 10;
 
-/* Resolution of the hash, 0 = 1*1 tile, 1 = 2*2 tiles, 2 = 4*4 tiles, etc.
- * Profiling results show that 0 is fastest. */
-const int HASH_RES = 0;
+static uint _tile_hash_bits_x; ///< Number of bits of the tile hash in the X direction.
+static uint _tile_hash_mask_x; ///< Mask for the X coordinate in the tile hash.
+static uint _tile_hash_mask_y; ///< Mask for the Y coordinate in the tile hash.
+static std::vector<Vehicle *> _vehicle_tile_hash; ///< Tile hash, sized to the map by #ResetVehicleHash.
 
-static Vehicle *_vehicle_tile_hash[TOTAL_HASH_SIZE];
+/**
+ * Get the bucket of the tile hash for the given tile coordinates.
+ * @param x The X coordinate of the tile, need not be masked.
+ * @param y The Y coordinate of the tile, need not be masked.
+ * @return The head of the vehicle chain for the bucket.
+ */
+static inline Vehicle **GetVehicleTileHashBucket(uint x, uint y)
+{
+	return &_vehicle_tile_hash[((y & _tile_hash_mask_y) << _tile_hash_bits_x) | (x & _tile_hash_mask_x)];
+}
 
 static Vehicle *VehicleFromTileHash(int xl, int yl, int xu, int yu, void *data, VehicleFromPosProc *proc, bool find_first)
 {
-	for (int y = yl; ; y = (y + (1 << HASH_BITS)) & (HASH_MASK << HASH_BITS)) {
-		for (int x = xl; ; x = (x + 1) & HASH_MASK) {
-			Vehicle *v = _vehicle_tile_hash[(x + y) & TOTAL_HASH_MASK];
+	for (uint y = yl & _tile_hash_mask_y; ; y = (y + 1) & _tile_hash_mask_y) {
+		for (uint x = xl & _tile_hash_mask_x; ; x = (x + 1) & _tile_hash_mask_x) {
+			Vehicle *v = *GetVehicleTileHashBucket(x, y);
 			for (; v != nullptr; v = v->hash_tile_next) {
 				Vehicle *a = proc(v, data);
 				if (find_first && a != nullptr) return a;
 			}
-			if (x == xu) break;
+			if (x == (xu & _tile_hash_mask_x)) break;
 		}
-		if (y == yu) break;
+		if (y == (yu & _tile_hash_mask_y)) break;
 	}
 
 	return nullptr;
@@ -419,11 +427,11 @@ static Vehicle *VehicleFromPosXY(int x, int y, void *data, VehicleFromPosProc *p
 {
 	const int COLL_DIST = 6;
 
-	/* Hash area to scan is from xl,yl to xu,yu */
-	int xl = GB((x - COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS);
-	int xu = GB((x + COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS);
-	int yl = GB((y - COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS) << HASH_BITS;
-	int yu = GB((y + COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS) << HASH_BITS;
+	/* Tile area to scan is from xl,yl to xu,yu */
+	int xl = (x - COLL_DIST) / TILE_SIZE;
+	int xu = (x + COLL_DIST) / TILE_SIZE;
+	int yl = (y - COLL_DIST) / TILE_SIZE;
+	int yu = (y + COLL_DIST) / TILE_SIZE;
 
 	return VehicleFromTileHash(xl, yl, xu, yu, data, proc, find_first);
 }
@@ -475,10 +483,7 @@ bool HasVehicleOnPosXY(int x, int y, void *data, VehicleFromPosProc *proc)
  */
 static Vehicle *VehicleFromPos(TileIndex tile, void *data, VehicleFromPosProc *proc, bool find_first)
 {
-	int x = GB(TileX(tile), HASH_RES, HASH_BITS);
-	int y = GB(TileY(tile), HASH_RES, HASH_BITS) << HASH_BITS;
-
-	Vehicle *v = _vehicle_tile_hash[(x + y) & TOTAL_HASH_MASK];
+	Vehicle *v = *GetVehicleTileHashBucket(TileX(tile), TileY(tile));
 	for (; v != nullptr; v = v->hash_tile_next) {
 		if (v->tile != tile) continue;
 
@@ -624,9 +629,7 @@ static void UpdateVehicleTileHash(Vehicle *v, bool remove)
 	if (remove) {
 		new_hash = nullptr;
 	} else {
-		int x = GB(TileX(v->tile), HASH_RES, HASH_BITS);
-		int y = GB(TileY(v->tile), HASH_RES, HASH_BITS) << HASH_BITS;
-		new_hash = &_vehicle_tile_hash[(x + y) & TOTAL_HASH_MASK];
+		new_hash = GetVehicleTileHashBucket(TileX(v->tile), TileY(v->tile));
 	}
 
 	if (old_hash == new_hash) return;
@@ -675,11 +678,22 @@ static void UpdateVehicleViewportHash(Vehicle *v, int x, int y, int old_x, int o
 	}
 }
 
+/**
+ * Clear the vehicle hashes and resize the tile hash to the current map size.
+ * Vehicles have to be re-added by updating their position afterwards.
+ */
 void ResetVehicleHash()
 {
 	for (Vehicle *v : Vehicle::Iterate()) { v->hash_tile_current = nullptr; }
 	memset(_vehicle_viewport_hash, 0, sizeof(_vehicle_viewport_hash));
-	memset(_vehicle_tile_hash, 0, sizeof(_vehicle_tile_hash));
+
+	_tile_hash_bits_x = std::min(Map::LogX(), MAX_TILE_HASH_BITS);
+	uint bits_y = std::min(Map::LogY(), MAX_TILE_HASH_BITS);
+	_tile_hash_mask_x = (1U << _tile_hash_bits_x) - 1;
+	_tile_hash_mask_y = (1U << bits_y) - 1;
+
+	_vehicle_tile_hash.clear();
+	_vehicle_tile_hash.resize(static_cast<size_t>(1) << (_tile_hash_bits_x + bits_y), nullptr);
 }
 
 void ResetVehicleColourMap()
@@ -985,7 +999,10 @@ void CallVehicleTicks()
 
 	{
 		PerformanceMeasurer framerate(PFE_GL_ECONOMY);
-		for (Station *st : Station::Iterate()) LoadUnloadStation(st);
+		for (Station *st : Station::Iterate()) {
+			TickProfileScope tick_profile(TPZ_STATION_LOADING, st->index);
+			LoadUnloadStation(st);
+		}
 	}
 	PerformanceAccumulator::Reset(PFE_GL_TRAINS);
 	PerformanceAccumulator::Reset(PFE_GL_ROADVEHS);
@@ -994,6 +1011,7 @@ void CallVehicleTicks()
 
 	for (Vehicle *v : Vehicle::Iterate()) {
 		[[maybe_unused]] size_t vehicle_index = v->index;
+		TickProfileScope tick_profile(TPZ_VEHICLE, v->index);
 
 		/* Vehicle could be deleted in this tick */
 		if (!v->Tick()) {
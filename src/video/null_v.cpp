@@ -12,6 +12,8 @@
 #include "../blitter/factory.hpp"
 #include "../saveload/saveload.h"
 #include "../window_func.h"
+#include "../benchmark.h"
+#include "../worker_pool.h"
 #include "null_v.h"
 
 #include "../safeguards.h"
@@ -29,6 +31,10 @@ const char *VideoDriver_Null::Start(const StringList &parm)
 	this->UpdateAutoResolution();
 
 	this->ticks = GetDriverParamInt(parm, "ticks", 1000);
+	this->benchmark = GetDriverParamBool(parm, "benchmark");
+	this->desync_check = GetDriverParamBool(parm, "desync_check");
+
+	this->threads = GetDriverParamInt(parm, "threads", -1);
 	_screen.width  = _screen.pitch = _cur_resolution.width;
 	_screen.height = _cur_resolution.height;
 	_screen.dst_ptr = nullptr;
@@ -46,6 +52,23 @@ void VideoDriver_Null::MakeDirty(int, int, int, int) {}
 
 void VideoDriver_Null::MainLoop()
 {
+	/* Allow comparing runs with a different number of worker threads without changing the configuration.
+	 * This has to be done here, as the configuration is only loaded after the driver has been started. */
+	if (this->threads >= 0) _worker_threads = std::min(this->threads, UINT8_MAX);
+
+	if (this->benchmark) {
+		/* The first run of the game loop loads the savegame given on the command line. */
+		::GameLoop();
+		if (!RunGameLoopBenchmark(this->ticks)) _exit_game = true;
+		return;
+	}
+
+	if (this->desync_check) {
+		::GameLoop();
+		if (!RunDesyncCheck(this->ticks)) _exit_game = true;
+		return;
+	}
+
 	uint i;
 
 	for (i = 0; i < this->ticks; i++) {
@@ -15,7 +15,10 @@
 /** The null video driver. */
 class VideoDriver_Null : public VideoDriver {
 private:
-	uint ticks; ///< Amount of ticks to run.
+	uint ticks;        ///< Amount of ticks to run.
+	bool benchmark;    ///< Whether to only run the game loop and report how long that took.
+	bool desync_check; ///< Whether to only compare the game loop with and without worker threads.
+	int threads;       ///< Number of worker threads to use instead of the configured number, or -1 to keep that.
 
 public:
 	const char *Start(const StringList &param) override;
@@ -90,7 +90,14 @@
 #include "network/network_func.h"
 #include "framerate_type.h"
 #include "viewport_cmd.h"
-
+#include "newgrf_debug.h"
+#include "worker_pool.h"
+#include "console_func.h"
+#include "fileio_func.h"
+#include "timer/timer.h"
+#include "timer/timer_game_calendar.h"
+
+#include <chrono>
 #include <forward_list>
 #include <stack>
 
@@ -179,11 +186,68 @@ struct ViewportDrawer {
 	FoundationPart foundation_part;                  ///< Currently active foundation for ground sprite drawing.
 	int *last_foundation_child[FOUNDATION_PART_END]; ///< Tail of ChildSprite list of the foundations. (index into child_screen_sprites_to_draw)
 	Point foundation_offset[FOUNDATION_PART_END];    ///< Pixel offset for ground sprites on the foundations.
+
+	std::vector<PreparedViewportSprite> prepared_tile_sprites;   ///< Looked up sprites of #tile_sprites_to_draw, for drawing by a worker thread.
+	std::vector<PreparedViewportSprite> prepared_parent_sprites; ///< Looked up sprites of #parent_sprites_to_draw, for drawing by a worker thread.
+	std::vector<PreparedViewportSprite> prepared_child_sprites;  ///< Looked up sprites of #child_screen_sprites_to_draw, for drawing by a worker thread.
 };
 
+/**
+ * Height of the horizontal bands a viewport is drawn in, in pixels. Each band is collected,
+ * sorted and drawn on its own, so the bands can be drawn by different threads. The bands do
+ * not depend on the number of threads, so the result does not either.
+ */
+static const int VIEWPORT_DRAW_BAND_HEIGHT = 128;
+
 static bool MarkViewportDirty(const Viewport *vp, int left, int top, int right, int bottom);
 
 static ViewportDrawer _vd;
+static std::vector<ViewportDrawer> _vd_bands; ///< Collected sprites of each band of the viewport that is being drawn.
+static std::string _sprite_sort_dump_file; ///< File to write the parent sprites of the next viewport redraw to, see #DumpViewportSpriteSort.
+
+/** A call to one of the functions tile procs add sprites to the viewport with, see #TileDrawList. */
+struct TileDrawCommand {
+	/** The function that was called. */
+	enum Type : byte {
+		GROUND_SPRITE,   ///< #DrawGroundSpriteAt
+		OFFSET_GROUND,   ///< #OffsetGroundSprite
+		SORTABLE_SPRITE, ///< #AddSortableSpriteToDraw
+		CHILD_SPRITE,    ///< #AddChildSpriteScreen
+		START_COMBINE,   ///< #StartSpriteCombine
+		END_COMBINE,     ///< #EndSpriteCombine
+	};
+
+	Type type;
+	bool transparent;        ///< The transparent parameter of the call.
+	bool scale;              ///< The scale parameter of #AddChildSpriteScreen.
+	bool relative;           ///< The relative parameter of #AddChildSpriteScreen.
+	SpriteID image;
+	PaletteID pal;
+	const SubSprite *sub;
+	std::array<int32_t, 9> args; ///< The coordinates and extents passed to the call, in the order of its parameters.
+};
+
+/**
+ * The calls the tile proc of a tile made to add its sprites to the viewport.
+ * Replaying them adds the same sprites without running the tile proc and resolving NewGRF sprite groups again.
+ * The calls are recorded before the sprites are clipped to the drawn area, so they can be replayed for any area.
+ */
+using TileDrawList = std::vector<TileDrawCommand>;
+
+/** The recorded draw lists of a tile. */
+struct TileDrawCacheEntry {
+	TileType type = MP_VOID;                         ///< Type of the tile when its draw lists were recorded.
+	uint8_t recorded = 0;                            ///< Bitmask of the zoom levels in #lists that have been recorded.
+	uint32_t last_used = 0;                          ///< Value of #_tile_draw_cache_clock when the tile was last drawn.
+	std::array<TileDrawList, ZOOM_LVL_END> lists;    ///< Draw list of the tile per zoom level.
+};
+
+/** Maximum number of tiles in #_tile_draw_cache; the tiles that were not drawn for the longest time are dropped when it grows beyond this. */
+static const size_t TILE_DRAW_CACHE_MAX_TILES = 1 << 16;
+
+static std::unordered_map<uint32_t, TileDrawCacheEntry> _tile_draw_cache; ///< Draw lists of the static scenery that has been drawn recently.
+static uint32_t _tile_draw_cache_clock = 0; ///< Number of times the landscape has been added to a viewport, to find the tiles that were not drawn for the longest time.
+static TileDrawList *_tile_draw_recording = nullptr; ///< Draw list the calls of the tile proc that is running are recorded in, if any.
 
 TileHighlightData _thd;
 static TileInfo _cur_ti;
@@ -266,6 +330,7 @@ void InitializeWindowViewport(Window *w, int x, int y,
 	vp->dest_scrollpos_y = pt.y;
 
 	vp->overlay = nullptr;
+	vp->prefetch_zoom = ZOOM_LVL_END;
 
 	w->viewport = vp;
 	vp->virtual_left = 0;
@@ -522,6 +587,8 @@ static void AddTileSpriteToDraw(SpriteID image, PaletteID pal, int32_t x, int32_
 	ts.y = pt.y + extra_offs_y;
 }
 
+static void AddChildSpriteToDraw(int parent, SpriteID image, PaletteID pal, int x, int y, bool transparent, const SubSprite *sub, bool scale, bool relative);
+
 /**
  * Adds a child sprite to the active foundation.
  *
@@ -544,7 +611,7 @@ static void AddChildSpriteToFoundation(SpriteID image, PaletteID pal, const SubS
 	int *old_child = _vd.last_child;
 	_vd.last_child = _vd.last_foundation_child[foundation_part];
 
-	AddChildSpriteScreen(image, pal, offs.x + extra_offs_x, offs.y + extra_offs_y, false, sub, false, false);
+	AddChildSpriteToDraw(_vd.foundation[foundation_part], image, pal, offs.x + extra_offs_x, offs.y + extra_offs_y, false, sub, false, false);
 
 	/* Switch back to last ChildSprite list */
 	_vd.last_child = old_child;
@@ -565,6 +632,10 @@ static void AddChildSpriteToFoundation(SpriteID image, PaletteID pal, const SubS
  */
 void DrawGroundSpriteAt(SpriteID image, PaletteID pal, int32_t x, int32_t y, int z, const SubSprite *sub, int extra_offs_x, int extra_offs_y)
 {
+	if (_tile_draw_recording != nullptr) {
+		_tile_draw_recording->push_back({ TileDrawCommand::GROUND_SPRITE, false, false, false, image, pal, sub, { x, y, z, extra_offs_x, extra_offs_y } });
+	}
+
 	/* Switch to first foundation part, if no foundation was drawn */
 	if (_vd.foundation_part == FOUNDATION_PART_NONE) _vd.foundation_part = FOUNDATION_PART_NORMAL;
 
@@ -600,6 +671,10 @@ void DrawGroundSprite(SpriteID image, PaletteID pal, const SubSprite *sub, int e
  */
 void OffsetGroundSprite(int x, int y)
 {
+	if (_tile_draw_recording != nullptr) {
+		_tile_draw_recording->push_back({ TileDrawCommand::OFFSET_GROUND, false, false, false, 0, 0, nullptr, { x, y } });
+	}
+
 	/* Switch to next foundation part */
 	switch (_vd.foundation_part) {
 		case FOUNDATION_PART_NONE:
@@ -642,7 +717,7 @@ static void AddCombinedSprite(SpriteID image, PaletteID pal, int x, int y, int z
 		return;
 
 	const ParentSpriteToDraw &pstd = _vd.parent_sprites_to_draw.back();
-	AddChildSpriteScreen(image, pal, pt.x - pstd.left, pt.y - pstd.top, false, sub, false);
+	AddChildSpriteToDraw((int)_vd.parent_sprites_to_draw.size() - 1, image, pal, pt.x - pstd.left, pt.y - pstd.top, false, sub, false, true);
 }
 
 /**
@@ -676,6 +751,10 @@ void AddSortableSpriteToDraw(SpriteID image, PaletteID pal, int x, int y, int w,
 
 	assert((image & SPRITE_MASK) < MAX_SPRITES);
 
+	if (_tile_draw_recording != nullptr) {
+		_tile_draw_recording->push_back({ TileDrawCommand::SORTABLE_SPRITE, transparent, false, false, image, pal, sub, { x, y, w, h, dz, z, bb_offset_x, bb_offset_y, bb_offset_z } });
+	}
+
 	/* make the sprites transparent with the right palette */
 	if (transparent) {
 		SetBit(image, PALETTE_MODIFIER_TRANSPARENT);
@@ -743,6 +822,11 @@ void AddSortableSpriteToDraw(SpriteID image, PaletteID pal, int x, int y, int w,
 
 	ps.first_child = -1;
 
+	ps.extent_left = left;
+	ps.extent_top = top;
+	ps.extent_right = right;
+	ps.extent_bottom = bottom;
+
 	_vd.last_child = &ps.first_child;
 
 	if (_vd.combine_sprites == SPRITE_COMBINE_PENDING) _vd.combine_sprites = SPRITE_COMBINE_ACTIVE;
@@ -770,6 +854,10 @@ void StartSpriteCombine()
 {
 	assert(_vd.combine_sprites == SPRITE_COMBINE_NONE);
 	_vd.combine_sprites = SPRITE_COMBINE_PENDING;
+
+	if (_tile_draw_recording != nullptr) {
+		_tile_draw_recording->push_back({ TileDrawCommand::START_COMBINE, false, false, false, 0, 0, nullptr, {} });
+	}
 }
 
 /**
@@ -780,6 +868,10 @@ void EndSpriteCombine()
 {
 	assert(_vd.combine_sprites != SPRITE_COMBINE_NONE);
 	_vd.combine_sprites = SPRITE_COMBINE_NONE;
+
+	if (_tile_draw_recording != nullptr) {
+		_tile_draw_recording->push_back({ TileDrawCommand::END_COMBINE, false, false, false, 0, 0, nullptr, {} });
+	}
 }
 
 /**
@@ -815,18 +907,11 @@ bool IsInsideRotatedRectangle(int x, int y)
 }
 
 /**
- * Add a child sprite to a parent sprite.
- *
- * @param image the image to draw.
- * @param pal the provided palette.
- * @param x sprite x-offset (screen coordinates) relative to parent sprite.
- * @param y sprite y-offset (screen coordinates) relative to parent sprite.
- * @param transparent if true, switch the palette between the provided palette and the transparent palette,
- * @param sub Only draw a part of the sprite.
- * @param scale if true, scale offsets to base zoom level.
- * @param relative if true, draw sprite relative to parent sprite offsets.
+ * Add a child sprite to a parent sprite, without recording it in the draw list of the tile.
+ * @param parent Index of the parent sprite in #ViewportDrawer::parent_sprites_to_draw the active ChildSprite list belongs to.
+ * @see AddChildSpriteScreen
  */
-void AddChildSpriteScreen(SpriteID image, PaletteID pal, int x, int y, bool transparent, const SubSprite *sub, bool scale, bool relative)
+static void AddChildSpriteToDraw(int parent, SpriteID image, PaletteID pal, int x, int y, bool transparent, const SubSprite *sub, bool scale, bool relative)
 {
 	assert((image & SPRITE_MASK) < MAX_SPRITES);
 
@@ -850,6 +935,16 @@ void AddChildSpriteScreen(SpriteID image, PaletteID pal, int x, int y, bool tran
 	cs.relative = relative;
 	cs.next = -1;
 
+	/* Grow the area covered by the parent sprite, so sorting knows which sprites the child sprite may cover. */
+	ParentSpriteToDraw &ps = _vd.parent_sprites_to_draw[parent];
+	const Sprite *spr = GetSprite(image & SPRITE_MASK, SpriteType::Normal);
+	int left = (relative ? ps.left : ps.x) + cs.x + spr->x_offs;
+	int top = (relative ? ps.top : ps.y) + cs.y + spr->y_offs;
+	ps.extent_left = std::min(ps.extent_left, left);
+	ps.extent_top = std::min(ps.extent_top, top);
+	ps.extent_right = std::max(ps.extent_right, left + spr->width);
+	ps.extent_bottom = std::max(ps.extent_bottom, top + spr->height);
+
 	/* Append the sprite to the active ChildSprite list.
 	 * If the active ParentSprite is a foundation, update last_foundation_child as well.
 	 * Note: ChildSprites of foundations are NOT sequential in the vector, as selection sprites are added at last. */
@@ -858,6 +953,27 @@ void AddChildSpriteScreen(SpriteID image, PaletteID pal, int x, int y, bool tran
 	_vd.last_child = &cs.next;
 }
 
+/**
+ * Add a child sprite to a parent sprite.
+ *
+ * @param image the image to draw.
+ * @param pal the provided palette.
+ * @param x sprite x-offset (screen coordinates) relative to parent sprite.
+ * @param y sprite y-offset (screen coordinates) relative to parent sprite.
+ * @param transparent if true, switch the palette between the provided palette and the transparent palette,
+ * @param sub Only draw a part of the sprite.
+ * @param scale if true, scale offsets to base zoom level.
+ * @param relative if true, draw sprite relative to parent sprite offsets.
+ */
+void AddChildSpriteScreen(SpriteID image, PaletteID pal, int x, int y, bool transparent, const SubSprite *sub, bool scale, bool relative)
+{
+	if (_tile_draw_recording != nullptr) {
+		_tile_draw_recording->push_back({ TileDrawCommand::CHILD_SPRITE, transparent, scale, relative, image, pal, sub, { x, y } });
+	}
+
+	AddChildSpriteToDraw((int)_vd.parent_sprites_to_draw.size() - 1, image, pal, x, y, transparent, sub, scale, relative);
+}
+
 static void AddStringToDraw(int x, int y, StringID string, Colours colour, uint16_t width)
 {
 	assert(width != 0);
@@ -1180,6 +1296,142 @@ static int GetViewportY(Point tile)
 	return (tile.y * (int)(TILE_PIXELS / 2) + tile.x * (int)(TILE_PIXELS / 2) - TilePixelHeightOutsideMap(tile.x, tile.y)) << ZOOM_LVL_SHIFT;
 }
 
+/**
+ * Check whether the drawing of a tile type only changes when its tiles are marked dirty or a new day starts,
+ * so the calls of its tile proc can be cached in #_tile_draw_cache.
+ * @param type The type of tile.
+ * @return True iff the draw lists of the tiles of this type can be cached.
+ */
+static bool IsTileDrawCacheable(TileType type)
+{
+	switch (type) {
+		case MP_HOUSE:
+		case MP_INDUSTRY:
+		case MP_OBJECT:
+		case MP_TREES:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+/**
+ * Make room in #_tile_draw_cache by dropping (at least) the half of the tiles that were not drawn for the longest time.
+ */
+static void EvictTileDrawCache()
+{
+	std::vector<uint32_t> last_used;
+	last_used.reserve(_tile_draw_cache.size());
+	for (const auto &[tile, entry] : _tile_draw_cache) last_used.push_back(entry.last_used);
+
+	auto median = last_used.begin() + last_used.size() / 2;
+	std::nth_element(last_used.begin(), median, last_used.end());
+	uint32_t threshold = *median;
+
+	for (auto it = _tile_draw_cache.begin(); it != _tile_draw_cache.end(); /* nothing */) {
+		if (it->second.last_used <= threshold) {
+			it = _tile_draw_cache.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+/**
+ * Replay the draw list of a tile.
+ * @param list The recorded calls of the tile proc.
+ */
+static void ReplayTileDrawList(const TileDrawList &list)
+{
+	for (const TileDrawCommand &cmd : list) {
+		const auto &a = cmd.args;
+		switch (cmd.type) {
+			case TileDrawCommand::GROUND_SPRITE: DrawGroundSpriteAt(cmd.image, cmd.pal, a[0], a[1], a[2], cmd.sub, a[3], a[4]); break;
+			case TileDrawCommand::OFFSET_GROUND: OffsetGroundSprite(a[0], a[1]); break;
+			case TileDrawCommand::SORTABLE_SPRITE: AddSortableSpriteToDraw(cmd.image, cmd.pal, a[0], a[1], a[2], a[3], a[4], a[5], cmd.transparent, a[6], a[7], a[8], cmd.sub); break;
+			case TileDrawCommand::CHILD_SPRITE: AddChildSpriteScreen(cmd.image, cmd.pal, a[0], a[1], cmd.transparent, cmd.sub, cmd.scale, cmd.relative); break;
+			case TileDrawCommand::START_COMBINE: StartSpriteCombine(); break;
+			case TileDrawCommand::END_COMBINE: EndSpriteCombine(); break;
+			default: NOT_REACHED();
+		}
+	}
+}
+
+/**
+ * Add the sprites of the current tile (#_cur_ti) to the viewport.
+ * Static scenery is drawn from the cached draw list of the tile, if there is one.
+ * @param tile_type The type of the current tile.
+ */
+static void ViewportAddTile(TileType tile_type)
+{
+	if (_cur_ti.tile == INVALID_TILE || !IsTileDrawCacheable(tile_type)) {
+		_tile_type_procs[tile_type]->draw_tile_proc(&_cur_ti);
+		return;
+	}
+
+	ZoomLevel zoom = _vd.dpi.zoom;
+	auto it = _tile_draw_cache.find(_cur_ti.tile.base());
+	if (it != _tile_draw_cache.end() && it->second.type == tile_type && HasBit(it->second.recorded, zoom)) {
+		it->second.last_used = _tile_draw_cache_clock;
+		ReplayTileDrawList(it->second.lists[zoom]);
+		return;
+	}
+
+	TileDrawList list;
+	_tile_draw_recording = &list;
+	_tile_type_procs[tile_type]->draw_tile_proc(&_cur_ti);
+	_tile_draw_recording = nullptr;
+
+	if (it == _tile_draw_cache.end()) {
+		if (_tile_draw_cache.size() >= TILE_DRAW_CACHE_MAX_TILES) EvictTileDrawCache();
+		it = _tile_draw_cache.try_emplace(_cur_ti.tile.base()).first;
+	}
+	TileDrawCacheEntry &entry = it->second;
+	entry.last_used = _tile_draw_cache_clock;
+	if (entry.type != tile_type) {
+		entry.type = tile_type;
+		entry.recorded = 0;
+	}
+	entry.lists[zoom] = std::move(list);
+	SetBit(entry.recorded, zoom);
+}
+
+/**
+ * Forget the cached draw lists of a tile and its neighbours, as the drawing of a tile may depend on its neighbours.
+ * @param tile The tile that changed.
+ */
+void InvalidateTileDrawCache(TileIndex tile)
+{
+	if (_tile_draw_cache.empty()) return;
+
+	for (int dy = -1; dy <= 1; dy++) {
+		for (int dx = -1; dx <= 1; dx++) {
+			TileIndex t = TileAddWrap(tile, dx, dy);
+			if (t != INVALID_TILE) _tile_draw_cache.erase(t.base());
+		}
+	}
+}
+
+/**
+ * Forget the cached draw lists of all tiles.
+ * Used when something changed that affects the drawing of any tile, such as transparency options, company colours or NewGRFs.
+ */
+void ClearTileDrawCache()
+{
+	_tile_draw_cache.clear();
+}
+
+/**
+ * NewGRF graphics can depend on the date and on variables of towns and industries that change
+ * without marking tiles dirty. Those are mostly updated daily or less often, so drop all draw
+ * lists every day; in between the drawing is assumed not to change.
+ */
+static IntervalTimer<TimerGameCalendar> _tile_draw_cache_daily({TimerGameCalendar::DAY, TimerGameCalendar::Priority::NONE}, [](auto)
+{
+	ClearTileDrawCache();
+});
+
 /**
  * Add the landscape to the viewport, i.e. all ground tiles and buildings.
  */
@@ -1188,6 +1440,8 @@ static void ViewportAddLandscape()
 	assert(_vd.dpi.top <= _vd.dpi.top + _vd.dpi.height);
 	assert(_vd.dpi.left <= _vd.dpi.left + _vd.dpi.width);
 
+	_tile_draw_cache_clock++;
+
 	Point upper_left = InverseRemapCoords(_vd.dpi.left, _vd.dpi.top);
 	Point upper_right = InverseRemapCoords(_vd.dpi.left + _vd.dpi.width, _vd.dpi.top);
 
@@ -1288,7 +1542,7 @@ static void ViewportAddLandscape()
 				_vd.last_foundation_child[0] = nullptr;
 				_vd.last_foundation_child[1] = nullptr;
 
-				_tile_type_procs[tile_type]->draw_tile_proc(&_cur_ti);
+				ViewportAddTile(tile_type);
 				if (_cur_ti.tile != INVALID_TILE) DrawTileSelection(&_cur_ti);
 			}
 		}
@@ -1731,71 +1985,194 @@ static void ViewportDrawStrings(ZoomLevel zoom, const StringSpriteToDrawVector *
 	}
 }
 
+/**
+ * Write the parent sprites of the bands of the viewport that is being drawn to #_sprite_sort_dump_file.
+ * Each band is written as a line with the number of sprites, followed by a line per sprite with its
+ * bounding box and the area it covers on the screen.
+ * @param bands The number of bands in #_vd_bands that are being drawn.
+ */
+static void WriteSpriteSortDump(uint bands)
+{
+	std::string filename = std::move(_sprite_sort_dump_file);
+	_sprite_sort_dump_file.clear();
+
+	FILE *f = FioFOpenFile(filename, "wt", Subdirectory::NO_DIRECTORY);
+	if (f == nullptr) {
+		IConsolePrint(CC_ERROR, "Could not open '{}' for writing.", filename);
+		return;
+	}
+	FileCloser fcloser(f);
+
+	size_t sprites = 0;
+	for (uint i = 0; i < bands; i++) {
+		const ParentSpriteToSortVector &psdv = _vd_bands[i].parent_sprites_to_sort;
+		fmt::print(f, "{}\n", psdv.size());
+		for (const ParentSpriteToDraw *ps : psdv) {
+			fmt::print(f, "{} {} {} {} {} {} {} {} {} {}\n", ps->xmin, ps->ymin, ps->zmin, ps->xmax, ps->ymax, ps->zmax,
+					ps->extent_left, ps->extent_top, ps->extent_right, ps->extent_bottom);
+		}
+		sprites += psdv.size();
+	}
+
+	IConsolePrint(CC_DEBUG, "Wrote {} sprites in {} sets to '{}'.", sprites, bands, filename);
+}
+
+/**
+ * Look up all sprites of a band in the sprite cache, so the band can be drawn by a worker thread.
+ * @param vd The band to prepare.
+ */
+static void ViewportPrepareSprites(ViewportDrawer &vd)
+{
+	for (const TileSpriteToDraw &ts : vd.tile_sprites_to_draw) {
+		vd.prepared_tile_sprites.push_back(PrepareSpriteViewport(ts.image, ts.pal));
+	}
+	for (const ParentSpriteToDraw &ps : vd.parent_sprites_to_draw) {
+		vd.prepared_parent_sprites.push_back(ps.image != SPR_EMPTY_BOUNDING_BOX ? PrepareSpriteViewport(ps.image, ps.pal) : PreparedViewportSprite{});
+	}
+	for (const ChildScreenSpriteToDraw &cs : vd.child_screen_sprites_to_draw) {
+		vd.prepared_child_sprites.push_back(PrepareSpriteViewport(cs.image, cs.pal));
+	}
+}
+
+/**
+ * Sort and draw the sprites of a band that has been prepared by #ViewportPrepareSprites.
+ * This only touches the band and its part of the screen, so it can be done by a worker thread.
+ * @param vd The band to draw.
+ */
+static void ViewportDrawPreparedSprites(ViewportDrawer &vd)
+{
+	for (size_t i = 0; i < vd.tile_sprites_to_draw.size(); i++) {
+		const TileSpriteToDraw &ts = vd.tile_sprites_to_draw[i];
+		DrawPreparedSpriteViewport(vd.prepared_tile_sprites[i], ts.x, ts.y, ts.sub, &vd.dpi);
+	}
+
+	ViewportSortParentSpritesClustered(&vd.parent_sprites_to_sort, _vp_sprite_sorter);
+
+	for (const ParentSpriteToDraw *ps : vd.parent_sprites_to_sort) {
+		if (ps->image != SPR_EMPTY_BOUNDING_BOX) {
+			DrawPreparedSpriteViewport(vd.prepared_parent_sprites[ps - vd.parent_sprites_to_draw.data()], ps->x, ps->y, ps->sub, &vd.dpi);
+		}
+
+		int child_idx = ps->first_child;
+		while (child_idx >= 0) {
+			const ChildScreenSpriteToDraw *cs = vd.child_screen_sprites_to_draw.data() + child_idx;
+			const PreparedViewportSprite &prepared = vd.prepared_child_sprites[child_idx];
+			child_idx = cs->next;
+			if (cs->relative) {
+				DrawPreparedSpriteViewport(prepared, ps->left + cs->x, ps->top + cs->y, cs->sub, &vd.dpi);
+			} else {
+				DrawPreparedSpriteViewport(prepared, ps->x + cs->x, ps->y + cs->y, cs->sub, &vd.dpi);
+			}
+		}
+	}
+}
+
 void ViewportDoDraw(const Viewport *vp, int left, int top, int right, int bottom)
 {
-	_vd.dpi.zoom = vp->zoom;
-	int mask = ScaleByZoom(-1, vp->zoom);
+	ZoomLevel zoom = vp->zoom;
+	int mask = ScaleByZoom(-1, zoom);
 
-	_vd.combine_sprites = SPRITE_COMBINE_NONE;
+	int width = (right - left) & mask;
+	int height = (bottom - top) & mask;
+	left &= mask;
+	top &= mask;
 
-	_vd.dpi.width = (right - left) & mask;
-	_vd.dpi.height = (bottom - top) & mask;
-	_vd.dpi.left = left & mask;
-	_vd.dpi.top = top & mask;
+	/* Collect the sprites of every band. Looking at the map is not thread safe, so this happens here. */
+	int band_height = ScaleByZoom(VIEWPORT_DRAW_BAND_HEIGHT, zoom);
+	uint bands = std::max(1U, CeilDiv(height, band_height));
+	if (_vd_bands.size() < bands) _vd_bands.resize(bands);
+
+	_vd.dpi.zoom = zoom;
 	_vd.dpi.pitch = _cur_dpi->pitch;
-	_vd.last_child = nullptr;
+	DrawPixelInfo *screen_dpi = _cur_dpi;
+	AutoRestoreBackup dpi_backup(_cur_dpi, &_vd.dpi);
 
-	int x = UnScaleByZoom(_vd.dpi.left - (vp->virtual_left & mask), vp->zoom) + vp->left;
-	int y = UnScaleByZoom(_vd.dpi.top - (vp->virtual_top & mask), vp->zoom) + vp->top;
+	for (uint i = 0; i < bands; i++) {
+		_vd.combine_sprites = SPRITE_COMBINE_NONE;
+		_vd.last_child = nullptr;
 
-	_vd.dpi.dst_ptr = BlitterFactory::GetCurrentBlitter()->MoveTo(_cur_dpi->dst_ptr, x - _cur_dpi->left, y - _cur_dpi->top);
-	AutoRestoreBackup dpi_backup(_cur_dpi, &_vd.dpi);
+		_vd.dpi.width = width;
+		_vd.dpi.left = left;
+		_vd.dpi.top = top + i * band_height;
+		_vd.dpi.height = std::min(band_height, top + height - _vd.dpi.top);
 
-	ViewportAddLandscape();
-	ViewportAddVehicles(&_vd.dpi);
+		int x = UnScaleByZoom(_vd.dpi.left - (vp->virtual_left & mask), zoom) + vp->left;
+		int y = UnScaleByZoom(_vd.dpi.top - (vp->virtual_top & mask), zoom) + vp->top;
+		_vd.dpi.dst_ptr = BlitterFactory::GetCurrentBlitter()->MoveTo(screen_dpi->dst_ptr, x - screen_dpi->left, y - screen_dpi->top);
+
+		ViewportAddLandscape();
+		ViewportAddVehicles(&_vd.dpi);
 
-	ViewportAddKdtreeSigns(&_vd.dpi);
+		ViewportAddKdtreeSigns(&_vd.dpi);
+
+		DrawTextEffects(&_vd.dpi);
+
+		for (auto &psd : _vd.parent_sprites_to_draw) {
+			_vd.parent_sprites_to_sort.push_back(&psd);
+		}
 
-	DrawTextEffects(&_vd.dpi);
+		std::swap(_vd, _vd_bands[i]);
+	}
 
-	if (!_vd.tile_sprites_to_draw.empty()) ViewportDrawTileSprites(&_vd.tile_sprites_to_draw);
+	if (!_sprite_sort_dump_file.empty()) WriteSpriteSortDump(bands);
 
-	for (auto &psd : _vd.parent_sprites_to_draw) {
-		_vd.parent_sprites_to_sort.push_back(&psd);
+	/* When there is more than one band and thread, sort and draw the sprites of the bands on the worker threads.
+	 * That needs all sprites to be in the sprite cache at once; if they do not fit, the bands are drawn one by one. */
+	bool prepared = bands > 1 && GetWorkerThreadCount() > 1 && _newgrf_debug_sprite_picker.mode == SPM_NONE;
+	if (prepared) {
+		uint version = GetSpriteCacheVersion();
+		for (uint i = 0; i < bands; i++) ViewportPrepareSprites(_vd_bands[i]);
+		prepared = version == GetSpriteCacheVersion();
+	}
+	if (prepared) {
+		ParallelFor(bands, [](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) ViewportDrawPreparedSprites(_vd_bands[i]);
+		});
 	}
 
-	_vp_sprite_sorter(&_vd.parent_sprites_to_sort);
-	ViewportDrawParentSprites(&_vd.parent_sprites_to_sort, &_vd.child_screen_sprites_to_draw);
+	for (uint i = 0; i < bands; i++) {
+		ViewportDrawer &vd = _vd_bands[i];
+		_cur_dpi = &vd.dpi;
 
-	if (_draw_bounding_boxes) ViewportDrawBoundingBoxes(&_vd.parent_sprites_to_sort);
-	if (_draw_dirty_blocks) ViewportDrawDirtyBlocks();
+		if (!prepared) {
+			if (!vd.tile_sprites_to_draw.empty()) ViewportDrawTileSprites(&vd.tile_sprites_to_draw);
 
-	DrawPixelInfo dp = _vd.dpi;
-	ZoomLevel zoom = _vd.dpi.zoom;
-	dp.zoom = ZOOM_LVL_NORMAL;
-	dp.width = UnScaleByZoom(dp.width, zoom);
-	dp.height = UnScaleByZoom(dp.height, zoom);
-	_cur_dpi = &dp;
+			ViewportSortParentSpritesClustered(&vd.parent_sprites_to_sort, _vp_sprite_sorter);
+			ViewportDrawParentSprites(&vd.parent_sprites_to_sort, &vd.child_screen_sprites_to_draw);
+		}
 
-	if (vp->overlay != nullptr && vp->overlay->GetCargoMask() != 0 && vp->overlay->GetCompanyMask() != 0) {
-		/* translate to window coordinates */
-		dp.left = x;
-		dp.top = y;
-		vp->overlay->Draw(&dp);
-	}
+		if (_draw_bounding_boxes) ViewportDrawBoundingBoxes(&vd.parent_sprites_to_sort);
+		if (_draw_dirty_blocks) ViewportDrawDirtyBlocks();
 
-	if (!_vd.string_sprites_to_draw.empty()) {
-		/* translate to world coordinates */
-		dp.left = UnScaleByZoom(_vd.dpi.left, zoom);
-		dp.top = UnScaleByZoom(_vd.dpi.top, zoom);
-		ViewportDrawStrings(zoom, &_vd.string_sprites_to_draw);
-	}
+		DrawPixelInfo dp = vd.dpi;
+		dp.zoom = ZOOM_LVL_NORMAL;
+		dp.width = UnScaleByZoom(dp.width, zoom);
+		dp.height = UnScaleByZoom(dp.height, zoom);
+		_cur_dpi = &dp;
 
-	_vd.string_sprites_to_draw.clear();
-	_vd.tile_sprites_to_draw.clear();
-	_vd.parent_sprites_to_draw.clear();
-	_vd.parent_sprites_to_sort.clear();
-	_vd.child_screen_sprites_to_draw.clear();
+		if (vp->overlay != nullptr && vp->overlay->GetCargoMask() != 0 && vp->overlay->GetCompanyMask() != 0) {
+			/* translate to window coordinates */
+			dp.left = UnScaleByZoom(vd.dpi.left - (vp->virtual_left & mask), zoom) + vp->left;
+			dp.top = UnScaleByZoom(vd.dpi.top - (vp->virtual_top & mask), zoom) + vp->top;
+			vp->overlay->Draw(&dp);
+		}
+
+		if (!vd.string_sprites_to_draw.empty()) {
+			/* translate to world coordinates */
+			dp.left = UnScaleByZoom(vd.dpi.left, zoom);
+			dp.top = UnScaleByZoom(vd.dpi.top, zoom);
+			ViewportDrawStrings(zoom, &vd.string_sprites_to_draw);
+		}
+
+		vd.string_sprites_to_draw.clear();
+		vd.tile_sprites_to_draw.clear();
+		vd.parent_sprites_to_draw.clear();
+		vd.parent_sprites_to_sort.clear();
+		vd.child_screen_sprites_to_draw.clear();
+		vd.prepared_tile_sprites.clear();
+		vd.prepared_parent_sprites.clear();
+		vd.prepared_child_sprites.clear();
+	}
 }
 
 static inline void ViewportDraw(const Viewport *vp, int left, int top, int right, int bottom)
@@ -1903,6 +2280,81 @@ static void ClampSmoothScroll(uint32_t delta_ms, int64_t delta_hi, int64_t delta
 	}
 }
 
+/**
+ * Prefetch the sprites of an area of the viewport, i.e. queue those that are not in the sprite cache for decoding in the background.
+ * @param zoom Zoom level of the viewport.
+ * @param left Left edge of the area, in virtual screen coordinates.
+ * @param top Top edge of the area, in virtual screen coordinates.
+ * @param right Right edge of the area (exclusive).
+ * @param bottom Bottom edge of the area (exclusive).
+ */
+static void PrefetchViewportArea(ZoomLevel zoom, int left, int top, int right, int bottom)
+{
+	if (left >= right || top >= bottom) return;
+
+	int mask = ScaleByZoom(-1, zoom);
+	_vd.dpi.zoom = zoom;
+	_vd.dpi.left = left & mask;
+	_vd.dpi.top = top & mask;
+	_vd.dpi.width = (right - _vd.dpi.left) & mask;
+	_vd.dpi.height = (bottom - _vd.dpi.top) & mask;
+	_vd.dpi.pitch = 0;
+	_vd.dpi.dst_ptr = nullptr;
+	_vd.combine_sprites = SPRITE_COMBINE_NONE;
+	_vd.last_child = nullptr;
+
+	AutoRestoreBackup dpi_backup(_cur_dpi, &_vd.dpi);
+	ViewportAddLandscape();
+
+	_vd.string_sprites_to_draw.clear();
+	_vd.tile_sprites_to_draw.clear();
+	_vd.parent_sprites_to_draw.clear();
+	_vd.child_screen_sprites_to_draw.clear();
+}
+
+/**
+ * Prefetch the sprites around a viewport, so they are in the sprite cache by the time the viewport is scrolled
+ * there, instead of being loaded while drawing. The prefetched area is the viewport extended by half its size
+ * on each side, which is also the area that becomes visible when zooming out once. Sprites are cached for all
+ * zoom levels at once, so that is covered as well. This is done again when the viewport moved a quarter of its
+ * size, but only for the part of the area that has not been prefetched before.
+ * @param vp The viewport.
+ */
+static void PrefetchViewportSprites(ViewportData *vp)
+{
+	if (!IsSpritePrefetchAvailable()) return;
+
+	Rect area;
+	area.left = vp->virtual_left - vp->virtual_width / 2;
+	area.top = vp->virtual_top - vp->virtual_height / 2;
+	area.right = area.left + vp->virtual_width * 2;
+	area.bottom = area.top + vp->virtual_height * 2;
+
+	const Rect &old = vp->prefetch_area;
+	bool same_zoom = vp->prefetch_zoom == vp->zoom;
+	if (same_zoom && abs(area.left - old.left) < vp->virtual_width / 4 && abs(area.top - old.top) < vp->virtual_height / 4 &&
+			area.right - area.left == old.right - old.left && area.bottom - area.top == old.bottom - old.top) {
+		return;
+	}
+
+	SetSpritePrefetchMode(true);
+	if (!same_zoom || area.left >= old.right || old.left >= area.right || area.top >= old.bottom || old.top >= area.bottom) {
+		PrefetchViewportArea(vp->zoom, area.left, area.top, area.right, area.bottom);
+	} else {
+		/* Only the parts of the area that are not in the previous area. */
+		int top = std::max(area.top, old.top);
+		int bottom = std::min(area.bottom, old.bottom);
+		PrefetchViewportArea(vp->zoom, area.left, area.top, area.right, top);
+		PrefetchViewportArea(vp->zoom, area.left, bottom, area.right, area.bottom);
+		PrefetchViewportArea(vp->zoom, area.left, top, std::max(area.left, old.left), bottom);
+		PrefetchViewportArea(vp->zoom, std::min(area.right, old.right), top, area.right, bottom);
+	}
+	SetSpritePrefetchMode(false);
+
+	vp->prefetch_area = area;
+	vp->prefetch_zoom = vp->zoom;
+}
+
 /**
  * Update the viewport position being displayed.
  * @param w %Window owning the viewport.
@@ -1962,6 +2414,8 @@ void UpdateViewportPosition(Window *w, uint32_t delta_ms)
 		SetViewportPosition(w, w->viewport->scrollpos_x, w->viewport->scrollpos_y);
 		if (update_overlay) RebuildViewportOverlay(w);
 	}
+
+	PrefetchViewportSprites(w->viewport);
 }
 
 /**
@@ -2050,6 +2504,8 @@ void ConstrainAllViewportsZoom()
  */
 void MarkTileDirtyByTile(TileIndex tile, int bridge_level_offset, int tile_height_override)
 {
+	InvalidateTileDrawCache(tile);
+
 	Point pt = RemapCoords(TileX(tile) * TILE_SIZE, TileY(tile) * TILE_SIZE, tile_height_override * TILE_HEIGHT);
 	MarkAllViewportsDirty(
 			pt.x - MAX_TILE_EXTENT_LEFT,
@@ -3501,14 +3957,15 @@ Point GetViewportStationMiddle(const Viewport *vp, const Station *st)
 struct ViewportSSCSS {
 	VpSorterChecker fct_checker; ///< The check function.
 	VpSpriteSorter fct_sorter;   ///< The sorting function.
+	const char *name;            ///< Name of the sorter, for the benchmark.
 };
 
 /** List of sorters ordered from best to worst. */
 static ViewportSSCSS _vp_sprite_sorters[] = {
 #ifdef WITH_SSE
-	{ &ViewportSortParentSpritesSSE41Checker, &ViewportSortParentSpritesSSE41 },
+	{ &ViewportSortParentSpritesSSE41Checker, &ViewportSortParentSpritesSSE41, "sse4.1" },
 #endif
-	{ &ViewportSortParentSpritesChecker, &ViewportSortParentSprites }
+	{ &ViewportSortParentSpritesChecker, &ViewportSortParentSprites, "generic" }
 };
 
 /** Choose the "best" sprite sorter and set _vp_sprite_sorter. */
@@ -3523,6 +3980,83 @@ void InitializeSpriteSorter()
 	assert(_vp_sprite_sorter != nullptr);
 }
 
+/**
+ * Get the path of a sprite sort dump; dumps are only kept in the screenshot directory.
+ * @param name Name of the dump, without any directories.
+ * @return The path, or an empty string when \a name is not a plain file name.
+ */
+static std::string GetSpriteSortDumpPath(const std::string &name)
+{
+	if (name.empty() || name == "." || name == ".." || name.find_first_of("/\\:") != std::string::npos) return {};
+	return fmt::format("{}{}", FiosGetScreenshotDir(), name);
+}
+
+/**
+ * Write the parent sprites of the next viewport redraw to a file in the screenshot directory, to benchmark the sprite sorters with.
+ * @param name Name of the file to write to.
+ * @return True if \a name is a valid file name.
+ */
+bool DumpViewportSpriteSort(const std::string &name)
+{
+	std::string filename = GetSpriteSortDumpPath(name);
+	if (filename.empty()) return false;
+
+	_sprite_sort_dump_file = filename;
+	MarkWholeScreenDirty();
+	return true;
+}
+
+/**
+ * Time the sprite sorters with sprites written by #DumpViewportSpriteSort.
+ * @param name Name of the file in the screenshot directory to read the sprites from.
+ * @param repeats Number of times to sort each set of sprites.
+ * @return True if the file could be read.
+ */
+bool BenchmarkViewportSpriteSorters(const std::string &name, uint repeats)
+{
+	std::string filename = GetSpriteSortDumpPath(name);
+	if (filename.empty()) return false;
+
+	FILE *f = FioFOpenFile(filename, "rt", Subdirectory::NO_DIRECTORY);
+	if (f == nullptr) return false;
+	FileCloser fcloser(f);
+
+	std::vector<std::vector<ParentSpriteToDraw>> sets;
+	size_t sprites = 0;
+	uint count;
+	while (fscanf(f, "%u", &count) == 1) {
+		std::vector<ParentSpriteToDraw> &set = sets.emplace_back(count);
+		for (ParentSpriteToDraw &ps : set) {
+			if (fscanf(f, "%d %d %d %d %d %d %d %d %d %d", &ps.xmin, &ps.ymin, &ps.zmin, &ps.xmax, &ps.ymax, &ps.zmax,
+					&ps.extent_left, &ps.extent_top, &ps.extent_right, &ps.extent_bottom) != 10) return false;
+		}
+		sprites += count;
+	}
+
+	IConsolePrint(CC_DEBUG, "Sorting {} sprites in {} sets {} times:", sprites, sets.size(), repeats);
+
+	auto benchmark = [&](const char *name, const std::function<void(ParentSpriteToSortVector *)> &sort) {
+		ParentSpriteToSortVector psdv;
+		auto start = std::chrono::steady_clock::now();
+		for (uint i = 0; i < repeats; i++) {
+			for (std::vector<ParentSpriteToDraw> &set : sets) {
+				psdv.clear();
+				for (ParentSpriteToDraw &ps : set) psdv.push_back(&ps);
+				sort(&psdv);
+			}
+		}
+		auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+		IConsolePrint(CC_DEBUG, "  {:<20} {:>10.3f} ms", name, duration.count() / 1000.0);
+	};
+
+	for (const ViewportSSCSS &sorter : _vp_sprite_sorters) {
+		if (!sorter.fct_checker()) continue;
+		benchmark(sorter.name, sorter.fct_sorter);
+		benchmark(fmt::format("{} clustered", sorter.name).c_str(), [&](ParentSpriteToSortVector *psdv) { ViewportSortParentSpritesClustered(psdv, sorter.fct_sorter); });
+	}
+	return true;
+}
+
 /**
  * Scroll players main viewport.
  * @param flags type of operation
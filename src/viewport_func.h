@@ -66,6 +66,11 @@ void SetTileSelectSize(int w, int h);
 void SetTileSelectBigSize(int ox, int oy, int sx, int sy);
 
 void ViewportDoDraw(const Viewport *vp, int left, int top, int right, int bottom);
+void InvalidateTileDrawCache(TileIndex tile);
+void ClearTileDrawCache();
+
+bool DumpViewportSpriteSort(const std::string &name);
+bool BenchmarkViewportSpriteSorters(const std::string &name, uint repeats);
 
 bool ScrollWindowToTile(TileIndex tile, Window *w, bool instant = false);
 bool ScrollWindowTo(int x, int y, int z, Window *w, bool instant = false);
@@ -0,0 +1,158 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file viewport_sprite_sorter.cpp Splitting the sorting of parent sprites into independent clusters. */
+
+#include "stdafx.h"
+#include "viewport_sprite_sorter.h"
+#include "worker_pool.h"
+
+#include "safeguards.h"
+
+static const size_t CLUSTER_MIN_SPRITES = 64;            ///< Below this number of sprites, sorting them at once is cheaper than finding clusters.
+static const size_t CLUSTER_MAX_CELLS_PER_SPRITE = 4;    ///< Maximum number of grid cells per sprite; larger grids use larger cells.
+static const size_t CLUSTER_MAX_ENTRIES_PER_SPRITE = 16; ///< Maximum number of sprite/cell pairs per sprite, before giving up on clustering.
+static const size_t CLUSTER_PARALLEL_MIN_SPRITES = 1024; ///< Minimum number of sprites before clusters are sorted on the worker threads.
+
+/**
+ * Find the representative of the cluster of a sprite, while flattening the tree on the way.
+ * @param parent Parent of each sprite in the union-find forest.
+ * @param i The sprite.
+ * @return The representative of the cluster.
+ */
+static uint FindCluster(std::vector<uint> &parent, uint i)
+{
+	while (parent[i] != i) {
+		parent[i] = parent[parent[i]];
+		i = parent[i];
+	}
+	return i;
+}
+
+/**
+ * Check whether the screen areas of two sprites, including their child sprites, overlap.
+ * @param a The first sprite.
+ * @param b The second sprite.
+ * @return True iff the order the sprites are drawn in can make a difference.
+ */
+static inline bool ExtentsOverlap(const ParentSpriteToDraw *a, const ParentSpriteToDraw *b)
+{
+	return a->extent_left < b->extent_right && b->extent_left < a->extent_right &&
+			a->extent_top < b->extent_bottom && b->extent_top < a->extent_bottom;
+}
+
+/**
+ * Sort parent sprites by splitting them into clusters of sprites that cover each other on the screen.
+ * The order of sprites of different clusters does not matter for the result, so each cluster is sorted
+ * on its own by \a sorter, which makes the quadratic worst case of the sorters only apply to single clusters.
+ * Large numbers of sprites are sorted on the worker threads, a cluster per thread.
+ * The clusters are found by putting the sprites in a grid of about the average size of a sprite,
+ * and only comparing sprites that share a grid cell.
+ * @param psdv The sprites to sort.
+ * @param sorter The sorter to sort each cluster with.
+ */
+void ViewportSortParentSpritesClustered(ParentSpriteToSortVector *psdv, VpSpriteSorter sorter)
+{
+	size_t count = psdv->size();
+	if (count < CLUSTER_MIN_SPRITES) {
+		sorter(psdv);
+		return;
+	}
+
+	int64_t left = INT64_MAX, top = INT64_MAX, right = INT64_MIN, bottom = INT64_MIN;
+	int64_t total_width = 0, total_height = 0;
+	for (const ParentSpriteToDraw *ps : *psdv) {
+		left = std::min<int64_t>(left, ps->extent_left);
+		top = std::min<int64_t>(top, ps->extent_top);
+		right = std::max<int64_t>(right, ps->extent_right);
+		bottom = std::max<int64_t>(bottom, ps->extent_bottom);
+		total_width += std::max(ps->extent_right - ps->extent_left, 1);
+		total_height += std::max(ps->extent_bottom - ps->extent_top, 1);
+	}
+
+	int64_t cell_width = std::max<int64_t>(total_width / count, 1);
+	int64_t cell_height = std::max<int64_t>(total_height / count, 1);
+	int64_t columns, rows;
+	for (;;) {
+		columns = (right - left) / cell_width + 1;
+		rows = (bottom - top) / cell_height + 1;
+		if ((uint64_t)(columns * rows) <= count * CLUSTER_MAX_CELLS_PER_SPRITE) break;
+		cell_width *= 2;
+		cell_height *= 2;
+	}
+
+	/* Sprite/cell pairs, grouped by cell after sorting. */
+	std::vector<std::pair<uint, uint>> entries;
+	for (uint i = 0; i < count; i++) {
+		const ParentSpriteToDraw *ps = (*psdv)[i];
+		int64_t first_column = (ps->extent_left - left) / cell_width;
+		int64_t last_column = (std::max(ps->extent_right - 1, ps->extent_left) - left) / cell_width;
+		int64_t first_row = (ps->extent_top - top) / cell_height;
+		int64_t last_row = (std::max(ps->extent_bottom - 1, ps->extent_top) - top) / cell_height;
+		for (int64_t row = first_row; row <= last_row; row++) {
+			for (int64_t column = first_column; column <= last_column; column++) {
+				entries.emplace_back((uint)(row * columns + column), i);
+			}
+		}
+
+		/* Many large sprites; clustering is not going to help. */
+		if (entries.size() > count * CLUSTER_MAX_ENTRIES_PER_SPRITE) {
+			sorter(psdv);
+			return;
+		}
+	}
+	std::sort(entries.begin(), entries.end());
+
+	std::vector<uint> parent(count);
+	for (uint i = 0; i < count; i++) parent[i] = i;
+
+	for (auto cell_begin = entries.begin(); cell_begin != entries.end(); /* nothing */) {
+		auto cell_end = std::find_if(cell_begin, entries.end(), [&](const auto &entry) { return entry.first != cell_begin->first; });
+		for (auto a = cell_begin; a != cell_end; a++) {
+			for (auto b = std::next(a); b != cell_end; b++) {
+				uint cluster_a = FindCluster(parent, a->second);
+				uint cluster_b = FindCluster(parent, b->second);
+				if (cluster_a == cluster_b || !ExtentsOverlap((*psdv)[a->second], (*psdv)[b->second])) continue;
+				parent[std::max(cluster_a, cluster_b)] = std::min(cluster_a, cluster_b);
+			}
+		}
+		cell_begin = cell_end;
+	}
+
+	/* Collect the clusters in the order of their first sprite, keeping the order of the sprites within each cluster. */
+	std::vector<uint> cluster_index(count, UINT_MAX);
+	std::vector<ParentSpriteToSortVector> clusters;
+	for (uint i = 0; i < count; i++) {
+		uint root = FindCluster(parent, i);
+		if (cluster_index[root] == UINT_MAX) {
+			cluster_index[root] = (uint)clusters.size();
+			clusters.emplace_back();
+		}
+		clusters[cluster_index[root]].push_back((*psdv)[i]);
+	}
+
+	if (clusters.size() == 1) {
+		sorter(psdv);
+		return;
+	}
+
+	auto sort_clusters = [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			if (clusters[i].size() > 1) sorter(&clusters[i]);
+		}
+	};
+	if (count >= CLUSTER_PARALLEL_MIN_SPRITES && GetWorkerThreadCount() > 1) {
+		ParallelFor(clusters.size(), sort_clusters);
+	} else {
+		sort_clusters(0, clusters.size());
+	}
+
+	auto out = psdv->begin();
+	for (const ParentSpriteToSortVector &cluster : clusters) {
+		out = std::copy(cluster.begin(), cluster.end(), out);
+	}
+}
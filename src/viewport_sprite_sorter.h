@@ -36,6 +36,12 @@ struct ParentSpriteToDraw {
 
 	int32_t first_child;              ///< the first child to draw.
 	uint32_t order;                   ///< Used during sprite sorting
+
+	/* Screen area covered by the sprite and its child sprites, to find sprites whose order does not matter */
+	int32_t extent_left;              ///< minimal screen X coordinate of the sprite and its children
+	int32_t extent_top;               ///< minimal screen Y coordinate of the sprite and its children
+	int32_t extent_right;             ///< maximal screen X coordinate of the sprite and its children, exclusive
+	int32_t extent_bottom;            ///< maximal screen Y coordinate of the sprite and its children, exclusive
 };
 
 typedef std::vector<ParentSpriteToDraw*> ParentSpriteToSortVector;
@@ -50,6 +56,8 @@ bool ViewportSortParentSpritesSSE41Checker();
 void ViewportSortParentSpritesSSE41(ParentSpriteToSortVector *psdv);
 #endif
 
+void ViewportSortParentSpritesClustered(ParentSpriteToSortVector *psdv, VpSpriteSorter sorter);
+
 void InitializeSpriteSorter();
 
 #endif /* VIEWPORT_SPRITE_SORTER_H */
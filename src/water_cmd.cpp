@@ -1272,6 +1272,32 @@ void TileLoop_Water(TileIndex tile)
 	}
 }
 
+/**
+ * Check whether the tile loop of a water tile would do nothing.
+ * This is the case for canals, rivers and sea that only borders other non-coast
+ * water. The tile loops of other tiles never change water tiles other than coast,
+ * so the result stays valid while the rest of the batch is processed.
+ * @param tile The tile to check.
+ * @return True if the tile loop can be skipped.
+ */
+static bool TileLoopIdle_Water(TileIndex tile)
+{
+	/* The ambient sound callback draws random numbers. */
+	if (HasGrfMiscBit(GMB_AMBIENT_SOUND_CALLBACK)) return false;
+
+	/* Coasts might dry up, or be flooded when a neighbour dried up. */
+	if (IsCoast(tile)) return false;
+
+	if (GetFloodingBehaviour(tile) != FLOOD_ACTIVE) return true;
+
+	for (Direction dir = DIR_BEGIN; dir < DIR_END; dir++) {
+		TileIndex dest = tile + TileOffsByDir(dir);
+		if (!IsValidTile(dest)) continue;
+		if (!IsTileType(dest, MP_WATER) || IsCoast(dest)) return false;
+	}
+	return true;
+}
+
 void ConvertGroundTilesIntoWaterTiles()
 {
 	int z;
@@ -1410,4 +1436,5 @@ extern const TileTypeProcs _tile_type_water_procs = {
 	VehicleEnter_Water,       // vehicle_enter_tile_proc
 	GetFoundation_Water,      // get_foundation_proc
 	TerraformTile_Water,      // terraform_tile_proc
+	TileLoopIdle_Water,       // tile_loop_idle_proc
 };
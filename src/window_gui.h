@@ -249,6 +249,8 @@ struct ViewportData : Viewport {
 	int32_t scrollpos_y;        ///< Currently shown y coordinate (virtual screen coordinate of topleft corner of the viewport).
 	int32_t dest_scrollpos_x;   ///< Current destination x coordinate to display (virtual screen coordinate of topleft corner of the viewport).
 	int32_t dest_scrollpos_y;   ///< Current destination y coordinate to display (virtual screen coordinate of topleft corner of the viewport).
+	Rect prefetch_area;         ///< Area of which the sprites were prefetched last, in virtual screen coordinates. Right and bottom are exclusive.
+	ZoomLevel prefetch_zoom;    ///< Zoom level of #prefetch_area, or #ZOOM_LVL_END when nothing has been prefetched.
 };
 
 struct QueryString;
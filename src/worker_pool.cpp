@@ -0,0 +1,218 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file worker_pool.cpp Implementation of the pool of worker threads. */
+
+#include "stdafx.h"
+#include "worker_pool.h"
+#include "thread.h"
+
+#include <atomic>
+#include <condition_variable>
+
+#include "safeguards.h"
+
+uint8_t _worker_threads = 1;
+
+/** Maximum number of threads in the pool, including the thread handing out the work. */
+static const uint MAX_WORKER_THREADS = 64;
+
+/** Whether the current thread is processing a batch of the worker pool. */
+static thread_local bool _in_worker_batch = false;
+
+/**
+ * Pool of threads that wait for a batch of work and then process it together
+ * with the thread that handed it out. Only one batch can be processed at a time;
+ * other threads that want to use the pool meanwhile do their work themselves.
+ */
+class WorkerPool {
+	std::vector<std::thread> threads;       ///< The worker threads, excluding the thread handing out the work.
+	std::mutex batch_mutex;                 ///< Held by the thread that handed out the current batch.
+
+	std::mutex mutex;                       ///< Protects all variables below, except #next.
+	std::condition_variable work_cv;        ///< Signalled when a new batch is available or the pool stops.
+	std::condition_variable done_cv;        ///< Signalled when the last worker finished its part of a batch.
+	const WorkerRangeProc *proc = nullptr;  ///< Procedure of the current batch.
+	size_t count = 0;                       ///< Number of items in the current batch.
+	size_t chunk = 1;                       ///< Number of items handed out at once.
+	std::atomic<size_t> next = 0;           ///< First item that has not been handed out yet.
+	uint busy = 0;                          ///< Number of workers processing the current batch.
+	uint64_t generation = 0;                ///< Number of batches handed out so far.
+	bool exit = false;                      ///< Whether the workers should stop.
+
+	/**
+	 * Process chunks of the batch until everything has been handed out.
+	 * @param proc Procedure of the batch.
+	 * @param count Number of items in the batch.
+	 * @param chunk Number of items to process at once.
+	 */
+	void RunChunks(const WorkerRangeProc *proc, size_t count, size_t chunk)
+	{
+		for (;;) {
+			size_t begin = this->next.fetch_add(chunk);
+			if (begin >= count) return;
+			(*proc)(begin, std::min(begin + chunk, count));
+		}
+	}
+
+	/** Main loop of the worker threads. */
+	void WorkerLoop()
+	{
+		_in_worker_batch = true;
+
+		std::unique_lock<std::mutex> lock(this->mutex);
+		uint64_t seen = this->generation;
+		for (;;) {
+			this->work_cv.wait(lock, [&]() { return this->exit || this->generation != seen; });
+			if (this->exit) return;
+
+			seen = this->generation;
+			const WorkerRangeProc *proc = this->proc;
+			size_t count = this->count;
+			size_t chunk = this->chunk;
+			this->busy++;
+
+			lock.unlock();
+			this->RunChunks(proc, count, chunk);
+			lock.lock();
+
+			if (--this->busy == 0) this->done_cv.notify_all();
+		}
+	}
+
+	/** Stop and join all worker threads. */
+	void Stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->exit = true;
+		}
+		this->work_cv.notify_all();
+		for (std::thread &t : this->threads) t.join();
+		this->threads.clear();
+		this->exit = false;
+	}
+
+	/**
+	 * Make sure the pool has the given number of worker threads.
+	 * @param workers Number of worker threads, excluding the calling thread.
+	 */
+	void Resize(uint workers)
+	{
+		if (this->threads.size() == workers) return;
+
+		this->Stop();
+		for (uint i = 0; i < workers; i++) {
+			std::thread t;
+			if (!StartNewThread(&t, "ottd:worker", &WorkerPool::WorkerThunk, this)) break;
+			this->threads.push_back(std::move(t));
+		}
+	}
+
+	/**
+	 * Entry point of the worker threads.
+	 * @param pool The pool the thread belongs to.
+	 */
+	static void WorkerThunk(WorkerPool *pool)
+	{
+		pool->WorkerLoop();
+	}
+
+public:
+	~WorkerPool()
+	{
+		this->Stop();
+	}
+
+	/**
+	 * Process a batch of work over all threads of the pool.
+	 * @param count Number of items to process.
+	 * @param proc Procedure to process a range of items.
+	 */
+	void Run(size_t count, const WorkerRangeProc &proc)
+	{
+		uint threads = GetWorkerThreadCount();
+		if (threads <= 1 || count <= 1 || _in_worker_batch) {
+			/* Pool disabled, nothing worth splitting, or called from within a batch. */
+			proc(0, count);
+			return;
+		}
+
+		std::unique_lock<std::mutex> batch_lock(this->batch_mutex, std::try_to_lock);
+		if (!batch_lock.owns_lock()) {
+			/* Another thread is using the pool; do it ourselves instead of waiting. */
+			proc(0, count);
+			return;
+		}
+
+		this->Resize(threads - 1);
+		if (this->threads.empty()) {
+			proc(0, count);
+			return;
+		}
+
+		size_t chunk = std::max<size_t>(1, count / (threads * 4));
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			/* Late workers of the previous batch must be finished before changing it. */
+			this->done_cv.wait(lock, [&]() { return this->busy == 0; });
+			this->proc = &proc;
+			this->count = count;
+			this->chunk = chunk;
+			this->next = 0;
+			this->generation++;
+		}
+		this->work_cv.notify_all();
+
+		_in_worker_batch = true;
+		this->RunChunks(&proc, count, chunk);
+		_in_worker_batch = false;
+
+		std::unique_lock<std::mutex> lock(this->mutex);
+		this->done_cv.wait(lock, [&]() { return this->busy == 0; });
+	}
+
+	/** Stop all worker threads; they will be started again when needed. */
+	void Shutdown()
+	{
+		std::lock_guard<std::mutex> batch_lock(this->batch_mutex);
+		this->Stop();
+	}
+};
+
+static WorkerPool _worker_pool; ///< The pool of worker threads.
+
+/**
+ * Get the number of threads work is split over, including the thread handing out the work.
+ * @return The number of threads; 1 when the worker pool is disabled.
+ */
+uint GetWorkerThreadCount()
+{
+	uint threads = _worker_threads;
+	if (threads == 0) threads = std::max(1U, std::thread::hardware_concurrency());
+	return std::min(threads, MAX_WORKER_THREADS);
+}
+
+/**
+ * Call \a proc for disjoint ranges covering [0, \a count), split over the worker threads.
+ * The ranges may be processed in any order and concurrently, so \a proc must only
+ * modify state that belongs to the items in its range. This function returns once
+ * all items have been processed.
+ * @param count Number of items to process.
+ * @param proc Procedure to process a range of items.
+ */
+void ParallelFor(size_t count, const WorkerRangeProc &proc)
+{
+	if (count == 0) return;
+	_worker_pool.Run(count, proc);
+}
+
+/** Stop the worker threads, e.g. before shutting down. */
+void ShutdownWorkerPool()
+{
+	_worker_pool.Shutdown();
+}
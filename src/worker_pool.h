@@ -0,0 +1,32 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file worker_pool.h Pool of persistent worker threads to split independent work over. */
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <functional>
+
+/**
+ * Number of threads to use for work that can be split over multiple threads.
+ * 1 disables the worker pool and runs everything on the calling thread, 0 uses one thread per hardware thread.
+ */
+extern uint8_t _worker_threads;
+
+/**
+ * Procedure to run for a part of the work given to #ParallelFor.
+ * @param begin First index of the range to process.
+ * @param end One past the last index of the range to process.
+ */
+using WorkerRangeProc = std::function<void(size_t begin, size_t end)>;
+
+uint GetWorkerThreadCount();
+void ParallelFor(size_t count, const WorkerRangeProc &proc);
+void ShutdownWorkerPool();
+
+#endif /* WORKER_POOL_H */